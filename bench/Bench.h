@@ -0,0 +1,64 @@
+#ifndef COMMANDSCRIPT_BENCH_BENCH_H
+#define COMMANDSCRIPT_BENCH_BENCH_H
+
+#include <chrono>
+#include <string>
+#include <ctype.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "MappedFile.h"
+
+/* shared by the benchmarks and checks under `bench/`, each of them is a program of it's own */
+namespace Bench
+{
+/* a copy of the whole file, for tokenizers which take their source as a string */
+static inline std::string load(const std::string &path)
+{
+    MappedFile file(path);
+    return std::string(file.data(), file.size());
+}
+
+/* a count or a size from the command line into `value`, which must be nothing but decimal digits, false otherwise,
+ * so a typo is reported rather than silently running an empty workload */
+static inline bool number(const char *text, size_t &value)
+{
+    char *end;
+    errno = 0;
+    unsigned long long result = strtoull(text, &end, 10);
+
+    if (!isdigit(static_cast<unsigned char>(*text)) || (*end != '\0') || (errno == ERANGE) || (result > SIZE_MAX))
+        return false;
+
+    value = static_cast<size_t>(result);
+    return true;
+}
+
+/* seconds taken by `fn` */
+template <typename Function>
+static inline double time(const Function &fn)
+{
+    auto begin = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+/* the fastest of `runs` calls to `fn`, which is the one least disturbed by the rest of the system */
+template <typename Function>
+static inline double best(size_t runs, const Function &fn)
+{
+    double result = time(fn);
+
+    for (size_t i = 1; i < runs; i++)
+    {
+        double seconds = time(fn);
+        if (seconds < result) result = seconds;
+    }
+
+    return result;
+}
+}
+
+#endif /* COMMANDSCRIPT_BENCH_BENCH_H */
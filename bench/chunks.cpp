@@ -0,0 +1,85 @@
+#include <memory>
+#include <string>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Bench.h"
+#include "Dumper.h"
+#include "Parser.h"
+#include "Strings.h"
+#include "Tokenizer.h"
+#include "ThreadPool.h"
+#include "SyntaxError.h"
+
+using namespace CommandScript;
+
+int main(int argc, char *argv[])
+{
+    size_t workers = 4;
+    size_t chunks = 4;
+
+    if ((argc > 3) || ((argc > 1) && !Bench::number(argv[1], workers)) || ((argc > 2) && !Bench::number(argv[2], chunks)))
+    {
+        fprintf(stderr, "usage: %s [workers] [chunks]\n", argv[0]);
+        fprintf(stderr, "    parses a source of `chunks` times the minimum chunk size, 4 by default, on `workers` threads, 4 by default,\n");
+        fprintf(stderr, "    it must be split, and give exactly the same tree and token count as a parse of the whole source\n");
+        return 2;
+    }
+
+    size_t failed = 0;
+
+    /* blank lines between statements, which are skipped right before every cut */
+    std::string statement = "value = handler(x, [1, 2.5], {k -> 'v'}, (y) -> {\n    return y + 1\n})\n\n\n";
+    std::string source = Strings::repeat(statement, chunks * Compiler::Parser::MinChunkSize / statement.size() + 1);
+
+    try
+    {
+        ThreadPool pool(workers);
+        std::shared_ptr<Compiler::Tokenizer> whole = std::make_shared<Compiler::Tokenizer>(source);
+        std::shared_ptr<Compiler::Tokenizer> split = std::make_shared<Compiler::Tokenizer>(source);
+        size_t pieces = split->split(pool.size() * Compiler::Parser::ChunksPerWorker, Compiler::Parser::MinChunkSize).size();
+
+        Compiler::Parser serial(whole);
+        Compiler::Parser parallel(split);
+        std::string expected = serial.parse()->toString();
+        std::string actual = parallel.parse(pool)->toString();
+
+        /* sources of a few times the minimum chunk size are worth splitting, no matter how many workers there are */
+        if (pieces < 2)
+        {
+            failed++;
+            fprintf(stderr, "%zu bytes on %zu workers are not split\n", source.size(), pool.size());
+        }
+
+        /* chunks read their own tokenizers, the one of the whole source is never read if the chunks succeeded */
+        if (split->count() != 0)
+        {
+            failed++;
+            fprintf(stderr, "chunks failed, the source was parsed as a whole\n");
+        }
+
+        if (actual != expected)
+        {
+            failed++;
+            fprintf(stderr, "trees parsed in chunks are different\n");
+        }
+
+        if ((parallel.tokens() != serial.tokens()) || (parallel.nodes() != serial.nodes()))
+        {
+            failed++;
+            fprintf(stderr, "%zu tokens and %zu nodes in chunks, but %zu tokens and %zu nodes as a whole\n",
+                    parallel.tokens(), parallel.nodes(), serial.tokens(), serial.nodes());
+        }
+
+        printf("%zu bytes, %zu chunks on %zu workers, %zu tokens, %zu nodes, %s\n",
+               source.size(), pieces, pool.size(), parallel.tokens(), parallel.nodes(), failed ? "FAILED" : "identical");
+    }
+    catch (const Exception::SyntaxError &e)
+    {
+        fprintf(stderr, "%d:%d: %s\n", e.row(), e.col(), e.message().c_str());
+        return 1;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+#include <memory>
+#include <string>
+
+#include <stdio.h>
+
+#include "Dumper.h"
+#include "Parser.h"
+#include "Strings.h"
+#include "Tokenizer.h"
+#include "SyntaxError.h"
+
+using namespace CommandScript;
+
+namespace
+{
+size_t failed = 0;
+
+/* whether `text` is well-formed UTF-8, decoded the plain way, so it doesn't share any code with the dumper */
+bool isUTF8(const std::string &text)
+{
+    for (size_t i = 0; i < text.size();)
+    {
+        unsigned char ch = static_cast<unsigned char>(text[i]);
+        size_t length = (ch < 0x80) ? 1 : (ch >> 5) == 0x06 ? 2 : (ch >> 4) == 0x0e ? 3 : (ch >> 3) == 0x1e ? 4 : 0;
+        uint32_t code = (length == 1) ? ch : (ch & (0x7f >> length));
+
+        if ((length == 0) || (i + length > text.size()))
+            return false;
+
+        for (size_t j = 1; j < length; j++)
+        {
+            if ((static_cast<unsigned char>(text[i + j]) & 0xc0) != 0x80)
+                return false;
+
+            code = (code << 6) | (static_cast<unsigned char>(text[i + j]) & 0x3f);
+        }
+
+        /* overlong forms, surrogates and code points beyond U+10FFFF */
+        static const uint32_t Least[] = { 0, 0, 0x80, 0x800, 0x10000 };
+        if ((code < Least[length]) || ((code >= 0xd800) && (code <= 0xdfff)) || (code > 0x10ffff))
+            return false;
+
+        i += length;
+    }
+
+    return true;
+}
+
+/* how a string which is not UTF-8 is dumped */
+std::string Bytes(const std::string &text, const std::string &bytes)
+{
+    return "{\"type\":\"Bytes\",\"text\":\"" + text + "\",\"bytes\":\"" + bytes + "\"}";
+}
+
+/* the JSON dump of `source` must be valid UTF-8, with it's only string constant quoted as `quoted` */
+void expectString(const std::string &source, const std::string &quoted)
+{
+    try
+    {
+        std::string json;
+        Compiler::Parser parser(std::make_shared<Compiler::Tokenizer>(source));
+        Compiler::Dumper(json, Compiler::Dumper::Format::Json).dump(parser.parse().get());
+
+        if (!isUTF8(json))
+        {
+            failed++;
+            fprintf(stderr, "%s: dumped as invalid UTF-8\n", Strings::repr(source).c_str());
+        }
+
+        if (json.find("\"string\":" + quoted) == std::string::npos)
+        {
+            failed++;
+            fprintf(stderr, "%s: string not dumped as %s: %s\n", Strings::repr(source).c_str(), quoted.c_str(), json.c_str());
+        }
+    }
+    catch (const Exception::SyntaxError &e)
+    {
+        failed++;
+        fprintf(stderr, "%s:%d:%d: %s\n", Strings::repr(source).c_str(), e.row(), e.col(), e.message().c_str());
+    }
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+    {
+        fprintf(stderr, "usage: %s\n", argv[0]);
+        fprintf(stderr, "    checks that JSON dumps of non-ASCII strings are valid UTF-8, and keep bytes which are not UTF-8 apart\n");
+        return 2;
+    }
+
+    /* well-formed UTF-8 is kept as-is, both in the source and from escapes */
+    expectString("a = \"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\"", "\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\"");
+    expectString("a = \"\\xc3\\xa9\"", "\"\xc3\xa9\"");
+
+    /* bytes which are not UTF-8 are replaced, and dumped as hex next to the text, including truncated, overlong and
+     * surrogate forms, so they're never confused with the chars of the same code points */
+    expectString("a = \"\\x80\\xff\"", Bytes("\xef\xbf\xbd\xef\xbf\xbd", "80ff"));
+    expectString("a = \"\\xe2\\x82\"", Bytes("\xef\xbf\xbd\xef\xbf\xbd", "e282"));
+    expectString("a = \"\\xc0\\xaf\"", Bytes("\xef\xbf\xbd\xef\xbf\xbd", "c0af"));
+    expectString("a = \"\\xed\\xa0\\x80\"", Bytes("\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd", "eda080"));
+    expectString("a = \"caf\\xe9\"", Bytes("caf\xef\xbf\xbd", "636166e9"));
+    expectString("a = \"caf\xc3\xa9\"", "\"caf\xc3\xa9\"");
+
+    /* control chars are still escaped */
+    expectString("a = \"\\x01\\t\"", "\"\\u0001\\t\"");
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,216 @@
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <system_error>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Bench.h"
+#include "Strings.h"
+#include "Tokenizer.h"
+#include "SyntaxError.h"
+
+using namespace CommandScript;
+
+namespace
+{
+/* chunk sizes of streamed sources, odd ones split operators, literals and names everywhere */
+const size_t Chunks[] = { 1, 2, 3, 7, 64, 4096 };
+
+/* chars operators are made of, operators spelled as words are identifiers to the lexer */
+const char Soup[] = "()[]{}~,:;@!.=+-*/%&|^<> ";
+
+/* a token with everything it carries, floats are compared by their bits */
+std::string describe(const Compiler::Token &token)
+{
+    if (!token.is<Compiler::Token::Type::Float>())
+        return Strings::format("%u %s", token.offset(), token.toString());
+    else
+        return Strings::format("%u <Float %a>", token.offset(), token.asFloat());
+}
+
+/* every token of `tk`, up to and including `EOF`, or up to the error, which is the last item then */
+std::vector<std::string> lex(Compiler::Tokenizer &tk)
+{
+    std::vector<std::string> result;
+
+    try
+    {
+        for (Compiler::Token token = tk.nextOrLine(); ; token = tk.nextOrLine())
+        {
+            result.push_back(describe(token));
+
+            if (token.is<Compiler::Token::Type::Eof>())
+                break;
+        }
+    }
+    catch (const Exception::SyntaxError &e)
+    {
+        result.push_back("error " + e.message());
+    }
+
+    return result;
+}
+
+std::vector<std::string> lex(const std::string &source, size_t chunk)
+{
+    size_t pos = 0;
+    Compiler::Tokenizer tk([&](char *buffer, size_t size)
+    {
+        size_t count = std::min(size, source.size() - pos);
+        memcpy(buffer, source.data() + pos, count);
+        pos += count;
+        return count;
+    }, chunk);
+
+    return lex(tk);
+}
+
+/* the reference lexer for operators, the longest spelling that matches, which is what the lexer did by hand before
+ * it was driven by tables, a lone '!' is the only invalid char of the soup, errors carry no position here */
+std::vector<std::pair<size_t, int>> reference(const std::string &source)
+{
+    size_t pos = 0;
+    std::vector<std::pair<size_t, int>> result;
+
+    while (pos < source.size())
+    {
+        int best = -1;
+        size_t size = 0;
+
+        if (source[pos] == ' ')
+        {
+            pos++;
+            continue;
+        }
+
+        for (int op = 0; op <= static_cast<int>(Compiler::Token::Operator::Decorator); op++)
+        {
+            const char *name = Compiler::Token::operatorName(static_cast<Compiler::Token::Operator>(op));
+            size_t length = strlen(name);
+
+            /* words and the new-line have letters, which are never in the soup */
+            if ((length > size) && !source.compare(pos, length, name))
+            {
+                best = op;
+                size = length;
+            }
+        }
+
+        if (best < 0)
+        {
+            result.emplace_back(pos, -1);
+            return result;
+        }
+
+        pos += size;
+        result.emplace_back(pos, best);
+    }
+
+    result.emplace_back(source.size(), -2);
+    return result;
+}
+
+/* the same, in the form `describe()` gives */
+std::vector<std::string> expected(const std::string &source)
+{
+    std::vector<std::string> result;
+
+    for (const std::pair<size_t, int> &item : reference(source))
+    {
+        switch (item.second)
+        {
+            case -1 : result.push_back("error"); break;
+            case -2 : result.push_back(describe(Compiler::Token::createEof(static_cast<uint32_t>(item.first)))); break;
+
+            default:
+            {
+                Compiler::Token::Operator op = static_cast<Compiler::Token::Operator>(item.second);
+                result.push_back(describe(Compiler::Token::createOperator(static_cast<uint32_t>(item.first), op)));
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* errors are only compared by their presence, the reference doesn't produce messages */
+bool same(std::vector<std::string> tokens, const std::vector<std::string> &expected)
+{
+    if (!tokens.empty() && !tokens.back().compare(0, 6, "error "))
+        tokens.back() = "error";
+
+    return tokens == expected;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = 0;
+
+    if ((argc < 2) || !Bench::number(argv[1], count))
+    {
+        fprintf(stderr, "usage: %s <count> [file] ...\n", argv[0]);
+        fprintf(stderr, "    lexes `count` random strings of operators, which must give exactly the tokens of a reference lexer,\n");
+        fprintf(stderr, "    then lexes each file from memory and streamed in chunks of several sizes, which must all be the same\n");
+        return 2;
+    }
+
+    size_t failed = 0;
+
+    /* the same strings every run */
+    std::mt19937_64 random(20160101);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        std::string source;
+        size_t size = random() % 64;
+
+        for (size_t j = 0; j < size; j++)
+            source += Soup[random() % (sizeof(Soup) - 1)];
+
+        Compiler::Tokenizer tk(source);
+        std::vector<std::string> want = expected(source);
+
+        /* streamed a char at a time, operators are read across every possible boundary */
+        if (!same(lex(tk), want) || !same(lex(source, 1), want))
+        {
+            if (failed++ < 10)
+                fprintf(stderr, "different tokens for %s\n", Strings::repr(source).c_str());
+        }
+    }
+
+    printf("%zu random operator strings, %zu different from the reference\n", count, failed);
+
+    for (int i = 2; i < argc; i++)
+    {
+        try
+        {
+            std::string source = Bench::load(argv[i]);
+            Compiler::Tokenizer tk(source);
+            std::vector<std::string> tokens = lex(tk);
+            size_t different = 0;
+
+            for (size_t chunk : Chunks)
+                if (lex(source, chunk) != tokens)
+                    different++;
+
+            if (different)
+                failed++;
+
+            printf("%s: %zu tokens, %zu of %zu chunk sizes different\n", argv[i], tokens.size(), different, sizeof(Chunks) / sizeof(Chunks[0]));
+        }
+        catch (const std::system_error &e)
+        {
+            failed++;
+            fprintf(stderr, "%s: %s\n", argv[i], e.code().message().c_str());
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,108 @@
+#include <memory>
+#include <string>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Bench.h"
+#include "Parser.h"
+#include "Strings.h"
+#include "Tokenizer.h"
+#include "SyntaxError.h"
+
+using namespace CommandScript;
+
+namespace
+{
+size_t failed = 0;
+
+/* targets nested `depth` deep, `((a, b), b), b`, they recurse without going through statements or expressions */
+std::string targets(size_t depth)
+{
+    std::string result = Strings::repeat("(", depth) + "a, b";
+    return result + Strings::repeat("), b", depth);
+}
+
+/* `source` must parse with a budget of `limit` if `accepted`, and be rejected as nesting too deep otherwise */
+void expectNesting(const char *name, const std::string &source, size_t limit, bool accepted)
+{
+    std::string error;
+
+    try
+    {
+        Compiler::Parser parser(std::make_shared<Compiler::Tokenizer>(source));
+        parser.setMaxDepth(limit);
+        parser.parse();
+    }
+    catch (const Exception::SyntaxError &e)
+    {
+        error = e.message();
+    }
+
+    if (accepted ? error.empty() : (error == "Nesting too deep"))
+        return;
+
+    failed++;
+    fprintf(stderr, "%s with a budget of %zu: %s\n", name, limit, error.empty() ? "not rejected" : error.c_str());
+}
+}
+
+int main(int argc, char *argv[])
+{
+    /* lambdas nested much deeper run into the nesting depth limit of the parser */
+    size_t copies = 2000;
+    size_t depth = 30;
+
+    if ((argc > 3) || ((argc > 1) && !Bench::number(argv[1], copies)) || ((argc > 2) && !Bench::number(argv[2], depth)))
+    {
+        fprintf(stderr, "usage: %s [copies] [depth]\n", argv[0]);
+        fprintf(stderr, "    parses `copies` handlers, 2000 by default, of lambdas nested 1 to `depth` deep, 30 by default,\n");
+        fprintf(stderr, "    the time per token should stay the same at every depth, targets of assignments and loops\n");
+        fprintf(stderr, "    nested deeper than the depth budget must be rejected as well\n");
+        return 2;
+    }
+
+    double first = 0.0;
+
+    /* far deeper than any stack could take if targets weren't counted */
+    expectNesting("assignment target 20 deep", targets(20) + " = 1\n", 32, true);
+    expectNesting("assignment target 2000 deep", targets(2000) + " = 1\n", 32, false);
+    expectNesting("assignment target 200000 deep", targets(200000) + " = 1\n", Compiler::Parser::DefaultMaxDepth, false);
+    expectNesting("loop target 20 deep", "for (" + targets(20) + " in x) {}\n", 32, true);
+    expectNesting("loop target 2000 deep", "for (" + targets(2000) + " in x) {}\n", 32, false);
+    expectNesting("loop target 200000 deep", "for (" + targets(200000) + " in x) {}\n", Compiler::Parser::DefaultMaxDepth, false);
+    printf("nested targets: %s\n", failed ? "FAILED" : "rejected past the depth budget");
+
+    for (size_t level = 1; level <= depth; level++)
+    {
+        /* the way handlers are registered, `Command.setHandler((x) -> { ... })`, with a lambda in each body */
+        std::string handler = Strings::repeat("f((x) -> {\n", level) + "g(x)\n" + Strings::repeat("})\n", level);
+        std::string source = Strings::repeat(handler, copies);
+
+        try
+        {
+            size_t tokens = 0;
+            double best = Bench::best(3, [&]
+            {
+                std::shared_ptr<Compiler::Tokenizer> tk = std::make_shared<Compiler::Tokenizer>(source);
+                Compiler::Parser parser(tk);
+                parser.parse();
+                tokens = tk->count();
+            });
+
+            /* relative to the shallowest, which is what linear parsing keeps close to 1 */
+            double perToken = best / tokens;
+            if (level == 1) first = perToken;
+
+            printf("depth %2zu: %8zu tokens in %9.3f ms, %6.1f ns/token, %.2fx depth 1\n",
+                   level, tokens, best * 1e3, perToken * 1e9, perToken / first);
+        }
+        catch (const Exception::SyntaxError &e)
+        {
+            fprintf(stderr, "depth %zu:%d:%d: %s\n", level, e.row(), e.col(), e.message().c_str());
+            return 1;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,201 @@
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Bench.h"
+#include "Strings.h"
+#include "Tokenizer.h"
+#include "SyntaxError.h"
+
+using namespace CommandScript;
+
+namespace
+{
+std::string digits(std::mt19937_64 &random, size_t count, bool leading)
+{
+    std::string result;
+
+    /* no leading zeros, which would make it an octal integer */
+    for (size_t i = 0; i < count; i++)
+        result += static_cast<char>((leading && (i == 0)) ? ('1' + random() % 9) : ('0' + random() % 10));
+
+    return result;
+}
+
+/* a decimal float literal, which has a fraction, an exponent, or both of them */
+std::string literal(std::mt19937_64 &random)
+{
+    size_t kind = random() % 3;
+    std::string result = digits(random, 1 + random() % 25, true);
+
+    if (kind != 2)
+        result += "." + digits(random, 1 + random() % 25, false);
+
+    if (kind != 0)
+        result += Strings::format("e%s%d", (random() & 1) ? "-" : "+", static_cast<int>(random() % 400));
+
+    return result;
+}
+
+/* what the tokenizer makes of `source`, which must be a single literal, as the bits of a double */
+bool lex(const std::string &source, double &value)
+{
+    try
+    {
+        Compiler::Tokenizer tk(source);
+        value = tk.next().asFloat();
+        return true;
+    }
+    catch (const Exception::SyntaxError &)
+    {
+        return false;
+    }
+}
+
+/* switch `LC_NUMERIC` to a locale whose decimal point is not '.', the one of the environment if it is such a locale,
+ * or the first one of a few common ones which is installed, returns it's name, or null if there is none */
+const char *numeric(void)
+{
+    static const char *names[] = { "", "de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8", "ru_RU.UTF-8", "ru_RU.utf8" };
+
+    for (const char *name : names)
+    {
+        const char *result = setlocale(LC_NUMERIC, name);
+
+        if (result && strcmp(localeconv()->decimal_point, "."))
+            return result;
+    }
+
+    setlocale(LC_NUMERIC, "C");
+    return nullptr;
+}
+
+/* a table of data the way scripts embed them, rows of integers, hexadecimals and floats with exponents */
+std::string table(std::mt19937_64 &random, size_t rows)
+{
+    std::string result = "table = [\n";
+
+    for (size_t i = 0; i < rows; i++)
+    {
+        /* all of them in range, so the table as a whole is valid */
+        result += Strings::format("    [%d, 0x%x, %d.%lde%d, %d.%lde-%d, %d.%d, %de-%d],\n",
+                                  static_cast<int>(random() % 100000),
+                                  static_cast<unsigned int>(random()),
+                                  static_cast<int>(random() % 10), static_cast<long>(random() % 10000000000000000), static_cast<int>(random() % 300),
+                                  static_cast<int>(random() % 10), static_cast<long>(random() % 10000000000000000), static_cast<int>(random() % 300),
+                                  static_cast<int>(random() % 1000), static_cast<int>(random() % 1000000),
+                                  static_cast<int>(random() % 10 + 1), static_cast<int>(random() % 30));
+    }
+
+    return result + "]\n";
+}
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = 1000000;
+    size_t rows = 100000;
+
+    if ((argc > 3) || ((argc > 1) && !Bench::number(argv[1], count)) || ((argc > 2) && !Bench::number(argv[2], rows)))
+    {
+        fprintf(stderr, "usage: %s [literals] [rows]\n", argv[0]);
+        fprintf(stderr, "    lexes `literals` random floats, 1000000 by default, which must be bit-identical to `strtod()`,\n");
+        fprintf(stderr, "    and again with `LC_NUMERIC` set to a locale with another decimal point, the environment's one if it is,\n");
+        fprintf(stderr, "    then tokenizes a data table of `rows` rows, 100000 by default, best of 5 runs\n");
+        return 2;
+    }
+
+    size_t failed = 0;
+    size_t different = 0;
+    std::vector<std::pair<std::string, double>> literals;
+
+    /* the same numbers every run */
+    std::mt19937_64 random(20160101);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        double value;
+        std::string source = literal(random);
+        double expected = strtod(source.c_str(), nullptr);
+
+        /* infinities must be rejected, everything else must be rounded exactly like `strtod()` does */
+        bool lexed = lex(source, value);
+        bool exact = std::isinf(expected) ? !lexed : (lexed && !memcmp(&value, &expected, sizeof(double)));
+
+        if (!exact && (different++ < 10))
+            fprintf(stderr, "%s: got %.17g, expected %.17g\n", source.c_str(), lexed ? value : NAN, expected);
+
+        /* kept for the locale check below, expected values are from the "C" locale */
+        if (lexed && (literals.size() < 10000))
+            literals.emplace_back(source, value);
+    }
+
+    /* integers must fit in `int64_t`, and never wrap around */
+    int64_t max = 0;
+    bool fits = false;
+    bool wraps = false;
+
+    try
+    {
+        max = Compiler::Tokenizer("9223372036854775807").next().asInteger();
+        fits = true;
+        Compiler::Tokenizer("9223372036854775808").next();
+        wraps = true;
+    }
+    catch (const Exception::SyntaxError &)
+    {
+    }
+
+    if (!fits || wraps || (max != INT64_MAX))
+    {
+        failed++;
+        fprintf(stderr, "integers out of range are not rejected\n");
+    }
+
+    printf("%zu literals, %zu different from strtod(), integer overflow %s\n", count, different, (fits && !wraps) ? "rejected" : "NOT rejected");
+
+    /* the host's locale must not change how literals are read, whether they're on the fast path or not */
+    size_t localized = 0;
+    const char *locale = numeric();
+
+    if (locale == nullptr)
+        printf("no locale with another decimal point is installed, set LC_NUMERIC to one to check it\n");
+    else
+    {
+        for (const auto &literal : literals)
+        {
+            double value;
+            bool lexed = lex(literal.first, value);
+
+            if ((!lexed || memcmp(&value, &literal.second, sizeof(double))) && (localized++ < 10))
+                fprintf(stderr, "%s: got %.17g in %s, expected %.17g\n", literal.first.c_str(), lexed ? value : NAN, locale, literal.second);
+        }
+
+        printf("%zu literals in LC_NUMERIC=%s (decimal point '%s'), %zu different from the \"C\" locale\n",
+               literals.size(), locale, localeconv()->decimal_point, localized);
+
+        setlocale(LC_NUMERIC, "C");
+        failed += localized;
+    }
+
+    /* mostly numbers, which is what the number lexer is measured with */
+    size_t tokens = 0;
+    std::string source = table(random, rows);
+    double best = Bench::best(5, [&]
+    {
+        Compiler::Tokenizer tk(source);
+        tk.tokenize();
+        tokens = tk.count();
+    });
+
+    printf("table of %zu rows: %zu bytes, %zu tokens in %.3f ms (%.2f MB/s, %.2f Mtok/s)\n",
+           rows, source.size(), tokens, best * 1e3, source.size() / best / 1e6, tokens / best / 1e6);
+
+    return (failed || different) ? 1 : 0;
+}
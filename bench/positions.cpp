@@ -0,0 +1,115 @@
+#include <memory>
+#include <string>
+#include <algorithm>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "AST.h"
+#include "Parser.h"
+#include "Strings.h"
+#include "Tokenizer.h"
+#include "SyntaxError.h"
+
+using namespace CommandScript;
+
+namespace
+{
+size_t failed = 0;
+
+/* the source whole, and streamed a few bytes at a time, which must report exactly the same */
+std::shared_ptr<Compiler::Tokenizer> tokenizer(const std::string &source, bool streaming)
+{
+    if (!streaming)
+        return std::make_shared<Compiler::Tokenizer>(source);
+
+    std::shared_ptr<size_t> pos = std::make_shared<size_t>(0);
+    return std::make_shared<Compiler::Tokenizer>([=](char *buffer, size_t size)
+    {
+        size = std::min(size, source.size() - *pos);
+        memcpy(buffer, source.data() + *pos, size);
+        *pos += size;
+        return size;
+    }, 3);
+}
+
+void expectError(const std::string &source, int row, int col, const std::string &message)
+{
+    for (bool streaming : { false, true })
+    {
+        std::shared_ptr<Compiler::Tokenizer> tk = tokenizer(source, streaming);
+        Compiler::Parser parser(tk);
+
+        try
+        {
+            parser.parse();
+            failed++;
+            fprintf(stderr, "%s: %s parsed, but \"%d:%d: %s\" expected\n",
+                    Strings::repr(source).c_str(), streaming ? "stream" : "source", row, col, message.c_str());
+        }
+        catch (const Exception::SyntaxError &e)
+        {
+            if ((e.row() != row) || (e.col() != col) || (e.message() != message))
+            {
+                failed++;
+                fprintf(stderr, "%s: %s reports \"%d:%d: %s\", but \"%d:%d: %s\" expected\n",
+                        Strings::repr(source).c_str(), streaming ? "stream" : "source",
+                        e.row(), e.col(), e.message().c_str(), row, col, message.c_str());
+            }
+        }
+    }
+}
+
+/* the value of the first statement, `name = value`, must be located at `offset` */
+void expectValueAt(const std::string &source, uint32_t offset)
+{
+    std::shared_ptr<Compiler::Tokenizer> tk = tokenizer(source, false);
+    Compiler::Parser parser(tk);
+
+    try
+    {
+        std::shared_ptr<Compiler::AST::Node> root = parser.parse();
+        Compiler::AST::Compond *compond = static_cast<Compiler::AST::Compond *>(root.get());
+        Compiler::AST::Node *value = compond->statements[0]->assignStatement->tuple->items[0];
+
+        /* nodes are located relative to their top-level statement */
+        uint32_t located = compond->statements[0]->offset + value->offset;
+
+        if (located != offset)
+        {
+            failed++;
+            fprintf(stderr, "%s: value located at %u, but %u expected\n",
+                    Strings::repr(source).c_str(), located, offset);
+        }
+    }
+    catch (const Exception::SyntaxError &e)
+    {
+        failed++;
+        fprintf(stderr, "%s:%d:%d: %s\n", Strings::repr(source).c_str(), e.row(), e.col(), e.message().c_str());
+    }
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+    {
+        fprintf(stderr, "usage: %s\n", argv[0]);
+        fprintf(stderr, "    checks where nodes and errors are located after the parser looked ahead and went back\n");
+        return 2;
+    }
+
+    /* new-lines after a component are looked past for attribute access, and then given back, positions are where
+     * tokens end, so what's left is the first new-line, which was looked at before anything was given back */
+    expectValueAt("x = a\n\n\nfoo = 1\n", 6);
+    expectValueAt("x = a.b\n\n\n.c\nfoo = 1\n", 13);
+    expectError("delete h()\n\n\nfoo bar", 2, 1, "Component must be mutable");
+    expectError("x = a\n\n\n)", 4, 2, "Unexpected token <Operator ')'>");
+
+    /* invalid tokens are reported only after every error before them */
+    expectError("x = = 1\ny = 2\nz = \"abc\n", 1, 5, "Unexpected token <Operator '='>");
+    expectError("x = 1\ny = 2\nz = \"abc\n", 4, 1, "Unexpected EOF when scanning strings");
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include <system_error>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Bench.h"
+#include "Dumper.h"
+#include "Parser.h"
+#include "Visitor.h"
+#include "Tokenizer.h"
+#include "SyntaxError.h"
+
+using namespace CommandScript;
+
+namespace
+{
+/* edits a source the way a person would, `count` times, at places spread evenly across it */
+struct Edit
+{
+    size_t offset;
+    size_t removed;
+    std::string text;
+};
+
+Edit edit(const std::string &source, size_t index, size_t count)
+{
+    /* odd edits change the leading digit of a decimal integer, which can't make it anything but another integer */
+    if (index & 1)
+    {
+        for (size_t pos = source.size() / (count + 1) * (index + 1); pos + 1 < source.size(); pos++)
+        {
+            size_t end = pos;
+            char prev = pos ? source[pos - 1] : ' ';
+
+            /* not part of a name, a float, nor a literal with a radix prefix */
+            if ((source[pos] < '1') || (source[pos] > '9') || isalnum(prev) || (prev == '_') || (prev == '.'))
+                continue;
+
+            while ((end < source.size()) && isdigit(source[end]))
+                end++;
+
+            if ((end < source.size()) && (isalnum(source[end]) || (source[end] == '_') || (source[end] == '.')))
+                continue;
+
+            return Edit { pos, 1, std::string(1, static_cast<char>('1' + (source[pos] - '1' + 1) % 9)) };
+        }
+    }
+
+    /* even ones add a statement of it's own right before a top-level one, chunks begin at exactly such places */
+    std::vector<std::pair<size_t, size_t>> chunks = Compiler::Tokenizer(source).split(count + 1, 1);
+    size_t pos = (chunks.size() < 2) ? source.size() : chunks[index % (chunks.size() - 1) + 1].first;
+    return Edit { pos, 0, "__edit" + std::to_string(index) + " = " + std::to_string(index) + "\n" };
+}
+
+/* offsets of every node in the tree, in the order they're visited, dumps don't have them */
+class Offsets : public Compiler::Visitor<Offsets>
+{
+    std::string &_result;
+
+public:
+    explicit Offsets(std::string &result) : _result(result) {}
+    bool visitNode(Compiler::AST::Node *node) { _result += std::to_string(node->offset) + " "; return true; }
+
+};
+
+/* what parsing ended up with, the tree or the error, as text to be compared, the parse alone is timed */
+template <typename Function>
+std::string outcome(const Function &parse, double &seconds)
+{
+    std::string result;
+    std::shared_ptr<Compiler::AST::Node> tree;
+
+    try
+    {
+        seconds = Bench::time([&]{ tree = parse(); });
+        Compiler::Dumper(result, Compiler::Dumper::Format::SExpr).dump(tree.get());
+        Offsets(result).traverse(static_cast<Compiler::AST::Compond *>(tree.get()));
+    }
+    catch (const Exception::SyntaxError &e)
+    {
+        seconds = 0.0;
+        result = Strings::format("%d:%d: %s", e.row(), e.col(), e.message());
+    }
+
+    return result;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = 16;
+
+    if (((argc != 2) && (argc != 3)) || ((argc == 3) && !Bench::number(argv[2], count)))
+    {
+        fprintf(stderr, "usage: %s <file> [edits]\n", argv[0]);
+        fprintf(stderr, "    edits the file a number of times, 16 by default, and reparses it after each edit,\n");
+        fprintf(stderr, "    the result must be exactly what a full parse of the edited source gives\n");
+        return 2;
+    }
+
+    try
+    {
+        size_t failed = 0;
+        size_t parsed = 0;
+        double reparsing = 0.0;
+        double parsing = 0.0;
+        std::string source = Bench::load(argv[1]);
+
+        /* the parser keeps everything of the last parse to reuse it */
+        Compiler::Parser parser(std::make_shared<Compiler::Tokenizer>(source));
+        double first = Bench::time([&]{ parser.parse(); });
+
+        for (size_t i = 0; i < count; i++)
+        {
+            double reparse;
+            double parse;
+            Edit change = edit(source, i, count);
+
+            source.replace(change.offset, change.removed, change.text);
+            std::string edited = outcome([&]{ return parser.reparse(source, change.offset, change.removed); }, reparse);
+            std::string whole = outcome([&]{ return Compiler::Parser(std::make_shared<Compiler::Tokenizer>(source)).parse(); }, parse);
+
+            if (edited != whole)
+                failed++;
+
+            /* errors are compared as well, but they're not worth timing, and would drag the averages down */
+            if ((reparse == 0.0) || (parse == 0.0))
+                printf("edit %zu at %zu: syntax error, %s\n", i, change.offset, (edited == whole) ? "identical" : "DIFFERENT");
+            else
+            {
+                parsed++;
+                reparsing += reparse;
+                parsing += parse;
+                printf("edit %zu at %zu: reparsed in %.3f ms, parsed in %.3f ms, %s\n",
+                       i, change.offset, reparse * 1e3, parse * 1e3, (edited == whole) ? "identical" : "DIFFERENT");
+            }
+        }
+
+        printf("%zu bytes, first parse in %.3f ms, %zu edits (%zu different, %zu parsed), reparsed in %.3f ms, parsed in %.3f ms on average\n",
+               source.size(), first * 1e3, count, failed, parsed,
+               parsed ? reparsing / parsed * 1e3 : 0.0, parsed ? parsing / parsed * 1e3 : 0.0);
+
+        return failed ? 1 : 0;
+    }
+    catch (const Exception::SyntaxError &e)
+    {
+        fprintf(stderr, "%s:%d:%d: %s\n", argv[1], e.row(), e.col(), e.message().c_str());
+        return 1;
+    }
+    catch (const std::system_error &e)
+    {
+        fprintf(stderr, "%s: %s\n", argv[1], e.code().message().c_str());
+        return 1;
+    }
+}
@@ -0,0 +1,180 @@
+#include <random>
+#include <string>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Bench.h"
+#include "Chars.h"
+#include "Strings.h"
+#include "Tokenizer.h"
+#include "SyntaxError.h"
+
+using namespace CommandScript;
+
+namespace
+{
+/* the plain loops the strided scans replaced, which they must agree with at every position */
+const char *skipBlanks(const char *begin, const char *end)
+{
+    while ((begin < end) && Chars::isBlank(*begin)) begin++;
+    return begin;
+}
+
+const char *findAny(const char *begin, const char *end, char a, char b, char c, char d, char e)
+{
+    while ((begin < end) && !Chars::isAny(*begin, a, b, c, d, e)) begin++;
+    return begin;
+}
+
+/* chars the random buffers are made of, every blank and every char the tokenizer scans for is among them */
+const char Mix[] = " \t\v\f\n\r\\\"'#\0ab";
+
+/* the way the tokenizer uses them, a scan from every stop, the stops are counted, so nothing is optimized away */
+template <typename Function>
+size_t stops(const std::string &source, const Function &scan)
+{
+    size_t result = 0;
+    const char *end = source.data() + source.size();
+
+    for (const char *p = source.data(); (p = scan(p, end)) < end; p++)
+        result++;
+
+    return result;
+}
+
+/* `size` bytes of lines made by `line` */
+template <typename Function>
+std::string generate(size_t size, std::mt19937_64 &random, const Function &line)
+{
+    std::string result;
+    result.reserve(size + 256);
+
+    while (result.size() < size)
+        result += line(random);
+
+    return result;
+}
+
+std::string letters(std::mt19937_64 &random, size_t count)
+{
+    std::string result;
+
+    for (size_t i = 0; i < count; i++)
+        result += (random() % 6) ? static_cast<char>('a' + random() % 26) : ' ';
+
+    return result;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    size_t megabytes = 4;
+
+    if ((argc > 2) || ((argc > 1) && !Bench::number(argv[1], megabytes)))
+    {
+        fprintf(stderr, "usage: %s [megabytes]\n", argv[0]);
+        fprintf(stderr, "    checks the strided scans against plain loops on random buffers, then measures both, and the tokenizer,\n");
+        fprintf(stderr, "    on comment-heavy, string-heavy and blank-heavy sources of `megabytes` each, 4 by default\n");
+        return 2;
+    }
+
+    size_t failed = 0;
+    size_t size = megabytes << 20;
+
+    /* the same buffers every run */
+    std::mt19937_64 random(20160101);
+
+    /* every start and every length up to a few strides, so each tail and each lane of a stride is hit */
+    for (size_t i = 0; i < 2000; i++)
+    {
+        std::string buffer;
+        size_t length = random() % 100;
+
+        for (size_t j = 0; j < length; j++)
+            buffer += Mix[random() % (sizeof(Mix) - 1)];
+
+        const char *end = buffer.data() + buffer.size();
+
+        for (const char *p = buffer.data(); p <= end; p++)
+        {
+            if ((Chars::skipBlanks(p, end) != skipBlanks(p, end)) ||
+                (Chars::findAny(p, end, '\n', '\r', '\\', '\0', '\0') != findAny(p, end, '\n', '\r', '\\', '\0', '\0')) ||
+                (Chars::findAny(p, end, '"', '\\', '\r', '\0', '\0') != findAny(p, end, '"', '\\', '\r', '\0', '\0')))
+            {
+                if (failed++ < 10)
+                    fprintf(stderr, "different scans for %s at %zu\n", Strings::repr(buffer).c_str(), static_cast<size_t>(p - buffer.data()));
+            }
+        }
+    }
+
+    printf("2000 random buffers, %zu scans different from plain loops\n", failed);
+
+    struct Input
+    {
+        const char *name;
+        std::string source;
+        const char *(*scan)(const char *, const char *);
+        const char *(*plain)(const char *, const char *);
+    };
+
+    /* scans as the tokenizer does them, comment bodies stop at line ends and continuations, strings at quotes and escapes */
+    Input inputs[] = {
+        {
+            "comment-heavy",
+            generate(size, random, [](std::mt19937_64 &r) { return "# " + letters(r, 40 + r() % 80) + "\n" + ((r() % 4) ? "" : "x = 1\n"); }),
+            [](const char *p, const char *end) { return Chars::findAny(p, end, '\n', '\r', '\\', '\0', '\0'); },
+            [](const char *p, const char *end) { return findAny(p, end, '\n', '\r', '\\', '\0', '\0'); },
+        },
+        {
+            "string-heavy",
+            generate(size, random, [](std::mt19937_64 &r) { return "s = \"" + letters(r, 40 + r() % 120) + ((r() % 4) ? "" : "\\n") + "\"\n"; }),
+            [](const char *p, const char *end) { return Chars::findAny(p, end, '"', '\\', '\r', '\0', '\0'); },
+            [](const char *p, const char *end) { return findAny(p, end, '"', '\\', '\r', '\0', '\0'); },
+        },
+        {
+            "blank-heavy",
+            generate(size, random, [](std::mt19937_64 &r) { return std::string(r() % 64, ' ') + "x =" + std::string(1 + r() % 32, (r() % 2) ? ' ' : '\t') + "1\n"; }),
+            [](const char *p, const char *end) { return Chars::skipBlanks(p, end); },
+            [](const char *p, const char *end) { return skipBlanks(p, end); },
+        },
+    };
+
+    for (const Input &input : inputs)
+    {
+        size_t found = 0;
+        size_t expected = 0;
+        size_t tokens = 0;
+
+        double plain = Bench::best(5, [&] { expected = stops(input.source, input.plain); });
+        double strided = Bench::best(5, [&] { found = stops(input.source, input.scan); });
+
+        try
+        {
+            double lexed = Bench::best(5, [&]
+            {
+                Compiler::Tokenizer tk(input.source);
+                tk.tokenize();
+                tokens = tk.count();
+                tk.fetch(tokens);
+            });
+
+            if (found != expected)
+            {
+                failed++;
+                fprintf(stderr, "%s: %zu stops, but %zu with plain loops\n", input.name, found, expected);
+            }
+
+            printf("%-13s: %zu bytes, %zu stops, plain %.0f MB/s, strided %.0f MB/s (%.2fx), %zu tokens at %.0f MB/s\n",
+                   input.name, input.source.size(), found, input.source.size() / plain / 1e6, input.source.size() / strided / 1e6,
+                   plain / strided, tokens, input.source.size() / lexed / 1e6);
+        }
+        catch (const Exception::SyntaxError &e)
+        {
+            failed++;
+            fprintf(stderr, "%s:%d:%d: %s\n", input.name, e.row(), e.col(), e.message().c_str());
+        }
+    }
+
+    return failed ? 1 : 0;
+}
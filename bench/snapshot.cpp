@@ -0,0 +1,119 @@
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Bench.h"
+#include "Dumper.h"
+#include "Parser.h"
+#include "Strings.h"
+#include "Tokenizer.h"
+#include "Serializer.h"
+#include "SymbolTable.h"
+#include "SyntaxError.h"
+
+using namespace CommandScript;
+
+namespace
+{
+std::string dump(const std::shared_ptr<Compiler::AST::Node> &tree)
+{
+    std::string result;
+    Compiler::Dumper(result, Compiler::Dumper::Format::SExpr).dump(tree.get());
+    return result;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <file> ...\n", argv[0]);
+        fprintf(stderr, "    parses each file, saves a snapshot of it and loads it back, the loaded tree must be exactly the parsed one,\n");
+        fprintf(stderr, "    opening the snapshot for use in place, and decoding it into a tree, are both timed against parsing,\n");
+        fprintf(stderr, "    with the file and the snapshot in the page cache either way\n");
+        return 2;
+    }
+
+    size_t failed = 0;
+    double parsing = 0.0;
+    double opening = 0.0;
+    double loading = 0.0;
+
+    /* every run saves into a snapshot of it's own */
+    const char *tmp = getenv("TMPDIR");
+    std::string path = Strings::format("%s/bench_snapshot.%d.ast", (tmp && *tmp) ? tmp : "/tmp", static_cast<int>(getpid()));
+
+    for (int i = 1; i < argc; i++)
+    {
+        try
+        {
+            std::string source = Bench::load(argv[i]);
+            uint64_t hash = Compiler::Serializer::hash(source);
+            std::shared_ptr<Compiler::AST::Node> parsed;
+            std::shared_ptr<Compiler::AST::Node> loaded;
+            std::shared_ptr<Compiler::Snapshot> snapshot;
+
+            size_t nodes = 0;
+            size_t tokens = 0;
+
+            /* a fresh tokenizer, parser and symbol table each run, just like a compilation */
+            double parse = Bench::best(5, [&]
+            {
+                Compiler::Parser parser(std::make_shared<Compiler::Tokenizer>(source));
+                parsed = parser.parse();
+                nodes = parser.nodes();
+                tokens = parser.tokens();
+            });
+
+            Compiler::Serializer::save(path, parsed.get(), hash, tokens, nodes);
+
+            /* records are checked once when opened, and used in place from then on */
+            double open = Bench::best(5, [&]
+            {
+                snapshot = Compiler::Serializer::open(path, hash);
+            });
+
+            /* everything that works on trees needs them decoded */
+            double load = Bench::best(5, [&]
+            {
+                loaded = Compiler::Serializer::load(path, hash, std::make_shared<Compiler::SymbolTable>());
+            });
+
+            /* records are usable without decoding, the root has a link for each top-level statement */
+            bool same = (snapshot != nullptr) && (loaded != nullptr) && (dump(loaded) == dump(parsed)) &&
+                        (snapshot->tokens() == tokens) && (snapshot->nodes() == nodes) &&
+                        (snapshot->root().kind == Compiler::Snapshot::Kind::Compond) &&
+                        (snapshot->root().size == static_cast<Compiler::AST::Compond *>(parsed.get())->statements.size());
+
+            if (!same)
+                failed++;
+
+            parsing += parse;
+            opening += open;
+            loading += load;
+            printf("%s: %zu bytes, parsed in %.3f ms, opened in %.3f ms (%.2fx), loaded in %.3f ms (%.2fx), %s\n",
+                   argv[i], source.size(), parse * 1e3, open * 1e3, parse / open, load * 1e3, parse / load, same ? "identical" : "DIFFERENT");
+        }
+        catch (const Exception::SyntaxError &e)
+        {
+            failed++;
+            fprintf(stderr, "%s:%d:%d: %s\n", argv[i], e.row(), e.col(), e.message().c_str());
+        }
+        catch (const std::system_error &e)
+        {
+            failed++;
+            fprintf(stderr, "%s: %s\n", argv[i], e.what());
+        }
+    }
+
+    unlink(path.c_str());
+    printf("total: parsed in %.3f ms, opened in %.3f ms (%.2fx), loaded in %.3f ms (%.2fx), %zu of %d files failed\n",
+           parsing * 1e3, opening * 1e3, opening > 0.0 ? parsing / opening : 0.0,
+           loading * 1e3, loading > 0.0 ? parsing / loading : 0.0, failed, argc - 1);
+
+    return failed ? 1 : 0;
+}
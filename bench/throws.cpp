@@ -0,0 +1,135 @@
+#include <atomic>
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Bench.h"
+#include "Parser.h"
+#include "Tokenizer.h"
+#include "MappedFile.h"
+#include "SyntaxError.h"
+
+using namespace CommandScript;
+
+namespace
+{
+std::atomic<size_t> throws(0);
+
+/* statements of every kind, each of them must be classified without a single exception, before the files */
+const char *const corpus[] = {
+    "print(e)\n",
+    "a = 1\n",
+    "a, b = 1, 2\n",
+    "a,\nb = 1, 2\n",
+    "a\n, b = 1, 2\n",
+    "a\n.b = 1\n",
+    "a\n= 1\n",
+    "a\n+= 1\n",
+    "a.b[1] += 2\n",
+    "f((x) -> {\n    x.y = 1\n})\n",
+    "{\n    a = 1\n    b += 2\n    f(a, b)\n}\n",
+};
+}
+
+/* every `throw` goes through this, the real one is found in the C++ runtime, which this binary takes precedence over,
+ * the type info is passed through untouched, so it's declared the way the runtime headers declare it, as `void *` */
+extern "C" void __cxa_throw(void *object, void *type, void (*destructor)(void *))
+{
+    typedef void (*Throw)(void *, void *, void (*)(void *)) __attribute__((noreturn));
+    static Throw next = reinterpret_cast<Throw>(dlsym(RTLD_NEXT, "__cxa_throw"));
+
+    throws++;
+    next(object, type, destructor);
+}
+
+int main(int argc, char *argv[])
+{
+    if ((argc > 1) && (argv[1][0] == '-'))
+    {
+        fprintf(stderr, "usage: %s [file] ...\n", argv[0]);
+        fprintf(stderr, "    parses a built-in corpus of valid statements, then each file, and counts the exceptions thrown\n");
+        fprintf(stderr, "    meanwhile, valid sources must throw none\n");
+        return 2;
+    }
+
+    /* make sure throws are actually counted, or the counts below would prove nothing */
+    try
+    {
+        throw std::bad_alloc();
+    }
+    catch (const std::bad_alloc &)
+    {
+        if (throws != 1)
+        {
+            fprintf(stderr, "throws are not counted, the C++ runtime must be linked dynamically\n");
+            return 2;
+        }
+    }
+
+    size_t total = 0;
+    size_t failed = 0;
+
+    for (const char *source : corpus)
+    {
+        size_t before = throws;
+
+        try
+        {
+            Compiler::Parser(std::make_shared<Compiler::Tokenizer>(source)).parse();
+        }
+        catch (const Exception::SyntaxError &e)
+        {
+            fprintf(stderr, "%s", source);
+            fprintf(stderr, "corpus:%d:%d: %s\n", e.row(), e.col(), e.message().c_str());
+        }
+
+        /* none of them is invalid, so even the syntax error counts */
+        if (throws != before)
+        {
+            failed++;
+            total += throws - before;
+        }
+    }
+
+    printf("corpus: %zu statements, %zu failed\n", sizeof(corpus) / sizeof(corpus[0]), failed);
+
+    for (int i = 1; i < argc; i++)
+    {
+        size_t before = throws;
+
+        try
+        {
+            Compiler::Parser parser(std::make_shared<Compiler::Tokenizer>(std::make_shared<MappedFile>(argv[i])));
+            double seconds = Bench::time([&]{ parser.parse(); });
+
+            /* valid sources must parse without a single exception */
+            total += throws - before;
+
+            if (throws != before)
+                failed++;
+
+            printf("%s: %zu nodes in %.3f ms, %zu exceptions thrown\n", argv[i], parser.nodes(), seconds * 1e3, throws - before);
+        }
+        catch (const Exception::SyntaxError &e)
+        {
+            /* the error itself is the only exception an invalid source may throw */
+            if (throws - before != 1)
+                failed++;
+
+            printf("%s:%d:%d: %s, %zu exceptions thrown\n", argv[i], e.row(), e.col(), e.message().c_str(), throws - before);
+        }
+        catch (const std::system_error &e)
+        {
+            failed++;
+            fprintf(stderr, "%s: %s\n", argv[i], e.code().message().c_str());
+        }
+    }
+
+    printf("total: %zu exceptions thrown by valid sources, %zu of %zu sources failed\n",
+           total, failed, sizeof(corpus) / sizeof(corpus[0]) + argc - 1);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,76 @@
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Bench.h"
+#include "Tokenizer.h"
+#include "MappedFile.h"
+#include "SyntaxError.h"
+
+using namespace CommandScript;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <file> ...\n", argv[0]);
+        fprintf(stderr, "    tokenizes each file as a whole, best of 5 runs, and reports the throughput and the size of tokens\n");
+        return 2;
+    }
+
+    size_t bytes = 0;
+    size_t tokens = 0;
+    size_t failed = 0;
+    double seconds = 0.0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        try
+        {
+            size_t count = 0;
+            std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(argv[i]);
+
+            /* a fresh tokenizer and symbol table each run, just like a compilation */
+            double best = Bench::best(5, [&]
+            {
+                Compiler::Tokenizer tk(file);
+                tk.tokenize();
+                count = tk.count();
+
+                /* an invalid token is only reported when fetched, which is what reading past the last one does */
+                tk.fetch(count);
+            });
+
+            bytes += file->size();
+            tokens += count;
+            seconds += best;
+
+            printf("%s: %zu bytes, %zu tokens in %.3f ms (%.2f MB/s, %.2f Mtok/s), %.2f source bytes per token\n",
+                   argv[i], file->size(), count, best * 1e3,
+                   file->size() / best / 1e6, count / best / 1e6,
+                   static_cast<double>(file->size()) / count);
+        }
+        catch (const Exception::SyntaxError &e)
+        {
+            failed++;
+            fprintf(stderr, "%s:%d:%d: %s\n", argv[i], e.row(), e.col(), e.message().c_str());
+        }
+        catch (const std::system_error &e)
+        {
+            failed++;
+            fprintf(stderr, "%s: %s\n", argv[i], e.code().message().c_str());
+        }
+    }
+
+    /* tokens are kept by value in a single buffer, so this is all the memory a token takes */
+    if (seconds > 0.0)
+    {
+        printf("total: %zu bytes, %zu tokens in %.3f ms (%.2f MB/s, %.2f Mtok/s), %zu bytes per token in memory\n",
+               bytes, tokens, seconds * 1e3, bytes / seconds / 1e6, tokens / seconds / 1e6, sizeof(Compiler::Token));
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include <system_error>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Bench.h"
+#include "Parser.h"
+#include "Visitor.h"
+#include "Tokenizer.h"
+#include "MappedFile.h"
+#include "SyntaxError.h"
+
+using namespace CommandScript;
+
+namespace
+{
+/* the cheapest pass there is, so the walk itself is what gets measured */
+class Count : public Compiler::Visitor<Count>
+{
+    size_t _nodes = 0;
+
+public:
+    size_t nodes(void) const { return _nodes; }
+    bool visitNode(Compiler::AST::Node *) { _nodes++; return true; }
+
+};
+
+/* every hook called, in order, entering and leaving nodes are told apart by the lowest bit */
+class Order : public Compiler::Visitor<Order>
+{
+    std::vector<uintptr_t> _hooks;
+
+public:
+    const std::vector<uintptr_t> &hooks(void) const { return _hooks; }
+
+public:
+    bool visitNode(Compiler::AST::Node *node) { _hooks.push_back(reinterpret_cast<uintptr_t>(node)); return true; }
+    void leaveNode(Compiler::AST::Node *node) { _hooks.push_back(reinterpret_cast<uintptr_t>(node) | 1); }
+
+};
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <file> ...\n", argv[0]);
+        fprintf(stderr, "    walks the tree of each file both recursively and iteratively, both of them must call the same\n");
+        fprintf(stderr, "    hooks in the same order, and visit every node of the tree exactly once\n");
+        return 2;
+    }
+
+    size_t failed = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        try
+        {
+            Compiler::Parser parser(std::make_shared<Compiler::Tokenizer>(std::make_shared<MappedFile>(argv[i])));
+            std::shared_ptr<Compiler::AST::Node> tree = parser.parse();
+            Compiler::AST::Compond *root = static_cast<Compiler::AST::Compond *>(tree.get());
+
+            Order recursive;
+            Order iterative;
+            recursive.traverse(root);
+            iterative.walk(root);
+
+            /* counts are checked, so the walks can't be optimized away, each node is entered and left once */
+            size_t traversed = 0;
+            size_t walked = 0;
+            double traverse = Bench::best(5, [&]{ Count counter; counter.traverse(root); traversed = counter.nodes(); });
+            double walk = Bench::best(5, [&]{ Count counter; counter.walk(root); walked = counter.nodes(); });
+            bool same = (recursive.hooks() == iterative.hooks()) && (traversed == walked) && (walked * 2 == iterative.hooks().size());
+
+            if (!same)
+                failed++;
+
+            printf("%s: %zu nodes, traversed in %.3f ms (%.2f Mnode/s), walked in %.3f ms (%.2f Mnode/s), %s\n",
+                   argv[i], walked,
+                   traverse * 1e3, walked / traverse / 1e6,
+                   walk * 1e3, walked / walk / 1e6,
+                   same ? "identical" : "DIFFERENT");
+        }
+        catch (const Exception::SyntaxError &e)
+        {
+            failed++;
+            fprintf(stderr, "%s:%d:%d: %s\n", argv[i], e.row(), e.col(), e.message().c_str());
+        }
+        catch (const std::system_error &e)
+        {
+            failed++;
+            fprintf(stderr, "%s: %s\n", argv[i], e.code().message().c_str());
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -5,8 +5,10 @@
 #include <vector>
 #include <utility>
 
+#include "Arena.h"
 #include "Strings.h"
 #include "Tokenizer.h"
+#include "SymbolTable.h"
 #include "NonMovable.h"
 #include "NonCopyable.h"
 
@@ -14,35 +16,45 @@ namespace CommandScript
 {
 namespace Compiler
 {
+class Dumper;
+
 namespace AST
 {
 struct Node : public NonMovable, public NonCopyable
 {
-    int row = -1;
-    int col = -1;
+    /* byte offset in source, rows and columns can be resolved with the tokenizer, only the root and top-level statements
+     * are located in the source though, every other node is located relative to the top-level statement it belongs to,
+     * so a statement can be moved after an edit without touching any of it's nodes, see `Parser::reparse()` */
+    uint32_t offset = 0;
+
+protected:
+    /* not virtual, nodes are never deleted but released along with their arena, so nodes without owning members are
+     * trivially destructible, and the arena keeps no cleanup records for them */
+    ~Node() = default;
 
 public:
-    virtual ~Node() {}
     explicit Node() {}
 
 public:
-    virtual std::string toString(size_t level = 0) const = 0;
+    /* `toString()` is a tree dump into a string, for the other sinks and formats see `Dumper` */
+    std::string toString(void) const;
+    virtual void dump(Dumper &dumper) const = 0;
 
 private:
     template <typename NodeType>
     NodeType *bindTokenizer(const std::shared_ptr<Tokenizer> &tk)
     {
-        row = tk->row();
-        col = tk->col();
+        offset = tk->offset();
         return static_cast<NodeType *>(this);
     }
 
 public:
+    /* nodes are owned by the arena, and released all together along with it */
     template <typename NodeType, typename ... Args>
-    static std::shared_ptr<NodeType> create(const std::shared_ptr<Tokenizer> &tk, Args && ... args)
+    static NodeType *create(Arena &arena, const std::shared_ptr<Tokenizer> &tk, Args && ... args)
     {
         static_assert(std::is_convertible<NodeType *, Node *>::value, "`NodeType *` must be convertiable to `Node *`");
-        return std::shared_ptr<NodeType>((new NodeType(std::forward<Args>(args) ...))->template bindTokenizer<NodeType>(tk));
+        return arena.create<NodeType>(std::forward<Args>(args) ...)->template bindTokenizer<NodeType>(tk);
     }
 };
 
@@ -101,81 +113,86 @@ struct Expression;
 
 struct If final : public Node
 {
-    std::shared_ptr<Expression> expr;
+    Expression *expr = nullptr;
 
 public:
-    std::shared_ptr<Statement> positive;
-    std::shared_ptr<Statement> negative;
+    Statement *positive = nullptr;
+    Statement *negative = nullptr;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct For final : public Node
 {
-    std::shared_ptr<Sequence> seq;
-    std::shared_ptr<Statement> body;
-    std::shared_ptr<Expression> expr;
+    Sequence *seq = nullptr;
+    Statement *body = nullptr;
+    Expression *expr = nullptr;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct While final : public Node
 {
-    std::shared_ptr<Statement> body;
-    std::shared_ptr<Expression> expr;
+    Statement *body = nullptr;
+    Expression *expr = nullptr;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Define final : public Node
 {
-    std::shared_ptr<Name> name;
-    std::shared_ptr<Statement> body;
+    Name *name = nullptr;
+    Statement *body = nullptr;
+
+public:
+    std::vector<Name *> args;
 
 public:
-    std::vector<std::shared_ptr<Name>> args;
+    /* token range of the body, when parsing it is deferred `body` stays null until `Parser::parseDeferred()` */
+    size_t bodyBegin = 0;
+    size_t bodyEnd = 0;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Import final : public Node
 {
-    std::vector<std::shared_ptr<Name>> names;
+    std::vector<Name *> names;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Try final : public Node
 {
     bool haveWildcard = false;
-    std::shared_ptr<Statement> body;
-    std::shared_ptr<Statement> finally;
-    std::vector<std::shared_ptr<Except>> excepts;
+    Statement *body = nullptr;
+    Statement *finally = nullptr;
+    std::vector<Except *> excepts;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Except final : public Node
 {
     bool isWildcard;
-    std::shared_ptr<Statement> body;
-    std::shared_ptr<Component> target;
-    std::vector<std::vector<std::shared_ptr<Name>>> exceptions;
+    Statement *body = nullptr;
+    Component *target = nullptr;
+    std::vector<std::vector<Name *>> exceptions;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
@@ -184,31 +201,31 @@ public:
 struct Assign final : public Node
 {
     bool isSeq;
-    std::shared_ptr<Tuple> tuple;
-    std::shared_ptr<Sequence> target;
+    Tuple *tuple = nullptr;
+    Sequence *target = nullptr;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Delete final : public Node
 {
-    std::shared_ptr<Component> target;
+    Component *target = nullptr;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Inplace final : public Node
 {
     Token::Operator op;
-    std::shared_ptr<Component> target;
-    std::shared_ptr<Expression> expression;
+    Component *target = nullptr;
+    Expression *expression = nullptr;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
@@ -224,12 +241,17 @@ public:
     struct Item
     {
         Type type;
-        std::shared_ptr<Sequence > sequence;
-        std::shared_ptr<Component> component;
 
     public:
-        Item(const std::shared_ptr<Sequence > &value) : type(Type::SequenceSequence ), sequence (value) {}
-        Item(const std::shared_ptr<Component> &value) : type(Type::SequenceComponent), component(value) {}
+        union
+        {
+            Sequence  *sequence;
+            Component *component;
+        };
+
+    public:
+        Item(Sequence  *value) : type(Type::SequenceSequence ), sequence (value) {}
+        Item(Component *value) : type(Type::SequenceComponent), component(value) {}
 
     };
 
@@ -238,16 +260,16 @@ public:
     std::vector<Item> items;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Compond final : public Node
 {
-    std::vector<std::shared_ptr<Statement>> statements;
+    std::vector<Statement *> statements;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
@@ -279,47 +301,48 @@ public:
     Type type;
 
 public:
-    std::shared_ptr<If       > ifStatement;
-    std::shared_ptr<For      > forStatement;
-    std::shared_ptr<Try      > tryStatement;
-    std::shared_ptr<While    > whileStatement;
-    std::shared_ptr<Compond  > compondStatement;
-
-public:
-    std::shared_ptr<Define   > defineStatement;
-    std::shared_ptr<Delete   > deleteStatement;
-    std::shared_ptr<Import   > importStatement;
-
-public:
-    std::shared_ptr<Break    > breakStatement;
-    std::shared_ptr<Raise    > raiseStatement;
-    std::shared_ptr<Return   > returnStatement;
-    std::shared_ptr<Continue > continueStatement;
-
-public:
-    std::shared_ptr<Assign   > assignStatement;
-    std::shared_ptr<Inplace  > inplaceStatement;
-    std::shared_ptr<Component> componentStatement;
+    /* exactly one of them is valid, selected by `type` */
+    union
+    {
+        If        *ifStatement = nullptr;
+        For       *forStatement;
+        Try       *tryStatement;
+        While     *whileStatement;
+        Compond   *compondStatement;
+
+        Define    *defineStatement;
+        Delete    *deleteStatement;
+        Import    *importStatement;
+
+        Break     *breakStatement;
+        Raise     *raiseStatement;
+        Return    *returnStatement;
+        Continue  *continueStatement;
+
+        Assign    *assignStatement;
+        Inplace   *inplaceStatement;
+        Component *componentStatement;
+    };
 
 public:
-    void setStatement(const std::shared_ptr<If      > &value) { type = Type::StatementIf      ; ifStatement       = value; }
-    void setStatement(const std::shared_ptr<For     > &value) { type = Type::StatementFor     ; forStatement      = value; }
-    void setStatement(const std::shared_ptr<Try     > &value) { type = Type::StatementTry     ; tryStatement      = value; }
-    void setStatement(const std::shared_ptr<While   > &value) { type = Type::StatementWhile   ; whileStatement    = value; }
+    void setStatement(If       *value) { type = Type::StatementIf      ; ifStatement       = value; }
+    void setStatement(For      *value) { type = Type::StatementFor     ; forStatement      = value; }
+    void setStatement(Try      *value) { type = Type::StatementTry     ; tryStatement      = value; }
+    void setStatement(While    *value) { type = Type::StatementWhile   ; whileStatement    = value; }
 
 public:
-    void setStatement(const std::shared_ptr<Define  > &value) { type = Type::StatementDefine  ; defineStatement   = value; }
-    void setStatement(const std::shared_ptr<Delete  > &value) { type = Type::StatementDelete  ; deleteStatement   = value; }
-    void setStatement(const std::shared_ptr<Import  > &value) { type = Type::StatementImport  ; importStatement   = value; }
+    void setStatement(Define   *value) { type = Type::StatementDefine  ; defineStatement   = value; }
+    void setStatement(Delete   *value) { type = Type::StatementDelete  ; deleteStatement   = value; }
+    void setStatement(Import   *value) { type = Type::StatementImport  ; importStatement   = value; }
 
 public:
-    void setStatement(const std::shared_ptr<Break   > &value) { type = Type::StatementBreak   ; breakStatement    = value; }
-    void setStatement(const std::shared_ptr<Raise   > &value) { type = Type::StatementRaise   ; raiseStatement    = value; }
-    void setStatement(const std::shared_ptr<Return  > &value) { type = Type::StatementReturn  ; returnStatement   = value; }
-    void setStatement(const std::shared_ptr<Continue> &value) { type = Type::StatementContinue; continueStatement = value; }
+    void setStatement(Break    *value) { type = Type::StatementBreak   ; breakStatement    = value; }
+    void setStatement(Raise    *value) { type = Type::StatementRaise   ; raiseStatement    = value; }
+    void setStatement(Return   *value) { type = Type::StatementReturn  ; returnStatement   = value; }
+    void setStatement(Continue *value) { type = Type::StatementContinue; continueStatement = value; }
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
@@ -327,68 +350,69 @@ public:
 
 struct Break final : public Node
 {
-    std::string toString(size_t level) const override { return Strings::repeat("| ", level) + "Break\n"; }
+    void dump(Dumper &dumper) const override;
 };
 
 struct Raise final : public Node
 {
-    std::shared_ptr<Expression> expr;
+    Expression *expr = nullptr;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Return final : public Node
 {
     bool isSeq;
-    std::shared_ptr<Tuple> tuple;
+    Tuple *tuple = nullptr;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Continue final : public Node
 {
-    std::string toString(size_t level) const override { return Strings::repeat("| ", level) + "Continue\n"; }
+    void dump(Dumper &dumper) const override;
 };
 
 /** Expression Components **/
 
 struct Name final : public Node
 {
-    std::string name;
+    /* interned, owned by the symbol table of the compilation */
+    const Symbol *symbol = nullptr;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Index final : public Node
 {
-    std::shared_ptr<Expression> index;
+    Expression *index = nullptr;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Invoke final : public Node
 {
-    std::vector<std::shared_ptr<Expression>> args;
+    std::vector<Expression *> args;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Attribute final : public Node
 {
-    std::shared_ptr<Name> attribute;
+    Name *attribute = nullptr;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
@@ -396,28 +420,28 @@ public:
 
 struct Map final : public Node
 {
-    std::vector<std::pair<std::shared_ptr<Expression>, std::shared_ptr<Expression>>> items;
+    std::vector<std::pair<Expression *, Expression *>> items;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct List final : public Node
 {
-    std::vector<std::shared_ptr<Expression>> items;
+    std::vector<Expression *> items;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Tuple final : public Node
 {
-    std::vector<std::shared_ptr<Expression>> items;
+    std::vector<Expression *> items;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
@@ -436,24 +460,27 @@ public:
     Type type;
 
 public:
-    std::shared_ptr<Map       > map;
-    std::shared_ptr<List      > list;
-    std::shared_ptr<Tuple     > tuple;
-    std::shared_ptr<Define    > lambda;
-    std::shared_ptr<Expression> expression;
+    union
+    {
+        Map        *map = nullptr;
+        List       *list;
+        Tuple      *tuple;
+        Define     *lambda;
+        Expression *expression;
+    };
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
 struct Pair final : public Node
 {
-    std::shared_ptr<Name> name;
-    std::shared_ptr<Expression> value;
+    Name *name = nullptr;
+    Expression *value = nullptr;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
@@ -472,10 +499,13 @@ public:
 public:
     double floatValue;
     int64_t integerValue;
-    std::string stringValue;
 
 public:
-    std::string toString(size_t level) const override;
+    /* points into the arena of the tree, or into the symbol table it keeps alive */
+    StringView stringValue;
+
+public:
+    void dump(Dumper &dumper) const override;
 
 };
 
@@ -501,14 +531,19 @@ public:
     struct Modifier
     {
         ModType type;
-        std::shared_ptr<Index    > index;
-        std::shared_ptr<Invoke   > invoke;
-        std::shared_ptr<Attribute> attribute;
 
     public:
-        Modifier(const std::shared_ptr<Index    > &value) : type(ModType::ModifierIndex    ), index    (value) {}
-        Modifier(const std::shared_ptr<Invoke   > &value) : type(ModType::ModifierInvoke   ), invoke   (value) {}
-        Modifier(const std::shared_ptr<Attribute> &value) : type(ModType::ModifierAttribute), attribute(value) {}
+        union
+        {
+            Index     *index;
+            Invoke    *invoke;
+            Attribute *attribute;
+        };
+
+    public:
+        Modifier(Index     *value) : type(ModType::ModifierIndex    ), index    (value) {}
+        Modifier(Invoke    *value) : type(ModType::ModifierInvoke   ), invoke   (value) {}
+        Modifier(Attribute *value) : type(ModType::ModifierAttribute), attribute(value) {}
 
     };
 
@@ -517,16 +552,19 @@ public:
     bool isStandalone = false;
 
 public:
-    std::shared_ptr<Name    > name;
-    std::shared_ptr<Pair    > pair;
-    std::shared_ptr<Unit    > unit;
-    std::shared_ptr<Constant> constant;
+    union
+    {
+        Name     *name = nullptr;
+        Pair     *pair;
+        Unit     *unit;
+        Constant *constant;
+    };
 
 public:
-    std::vector<Modifier> modifiers;
+    ArenaVector<Modifier> modifiers;
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 
@@ -542,34 +580,43 @@ public:
     struct Term
     {
         Type type;
-        std::shared_ptr<Component > component;
-        std::shared_ptr<Expression> expression;
 
     public:
-        Term(const std::shared_ptr<Component > &value) : type(Type::TermComponent ), component (value) {}
-        Term(const std::shared_ptr<Expression> &value) : type(Type::TermExpression), expression(value) {}
+        union
+        {
+            Component  *component;
+            Expression *expression;
+        };
+
+    public:
+        Term(Component  *value) : type(Type::TermComponent ), component (value) {}
+        Term(Expression *value) : type(Type::TermExpression), expression(value) {}
 
     };
 
 public:
     Term first;
     Token::Operator op;
-    std::vector<std::pair<Token::Operator, Term>> remains;
+    ArenaVector<std::pair<Token::Operator, Term>> remains;
 
 public:
     bool isUnary;
     bool isRelations;
 
 public:
-    explicit Expression(const std::shared_ptr<Component > &value) : first(value), isUnary(false), isRelations(false) {}
-    explicit Expression(const std::shared_ptr<Expression> &value) : first(value), isUnary(false), isRelations(false) {}
+    explicit Expression(Component  *value) : first(value), isUnary(false), isRelations(false) {}
+    explicit Expression(Expression *value) : first(value), isUnary(false), isRelations(false) {}
+
+public:
+    explicit Expression(Token::Operator op, Component  *value) : first(value), op(op), isUnary(true), isRelations(false) {}
+    explicit Expression(Token::Operator op, Expression *value) : first(value), op(op), isUnary(true), isRelations(false) {}
 
 public:
-    explicit Expression(Token::Operator op, const std::shared_ptr<Component > &value) : first(value), op(op), isUnary(true), isRelations(false) {}
-    explicit Expression(Token::Operator op, const std::shared_ptr<Expression> &value) : first(value), op(op), isUnary(true), isRelations(false) {}
+    explicit Expression(const Term &value) : first(value), isUnary(false), isRelations(false) {}
+    explicit Expression(Token::Operator op, const Term &value) : first(value), op(op), isUnary(true), isRelations(false) {}
 
 public:
-    std::string toString(size_t level) const override;
+    void dump(Dumper &dumper) const override;
 
 };
 }
@@ -0,0 +1,183 @@
+#ifndef COMMANDSCRIPT_COMPILER_DUMPER_H
+#define COMMANDSCRIPT_COMPILER_DUMPER_H
+
+#include <iosfwd>
+#include <string>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Strings.h"
+#include "StringView.h"
+#include "NonMovable.h"
+#include "NonCopyable.h"
+
+namespace CommandScript
+{
+namespace Compiler
+{
+namespace AST
+{
+struct Node;
+}
+
+/* writes trees into a single sink in one pass, nodes describe themselves with the methods below, each format only
+ * picks what it needs from them : titles and labels are for the indented tree, keys and scalars are for JSON and
+ * S-expressions, which are compact single-line dumps meant for diffing */
+class Dumper : public NonMovable, public NonCopyable
+{
+public:
+    enum class Format : int
+    {
+        Tree,
+        Json,
+        SExpr,
+    };
+
+private:
+    /* files and streams are written through the local buffer, strings are appended in place */
+    FILE *_file = nullptr;
+    std::ostream *_stream = nullptr;
+
+private:
+    std::string _local;
+    std::string *_buffer;
+
+private:
+    bool _first = true;
+    size_t _level = 0;
+    Format _format;
+
+public:
+    ~Dumper() { flush(); }
+    explicit Dumper(std::string &buffer, Format format = Format::Tree) : _buffer(&buffer), _format(format) {}
+    explicit Dumper(std::ostream &stream, Format format = Format::Tree) : _stream(&stream), _buffer(&_local), _format(format) {}
+    explicit Dumper(FILE *file, Format format = Format::Tree) : _file(file), _buffer(&_local), _format(format) {}
+
+public:
+    Format format(void) const { return _format; }
+
+public:
+    /* dumps an entire tree, structured formats end it with a new line */
+    void dump(const AST::Node *node);
+    void flush(void);
+
+private:
+    void put(char ch) { _buffer->push_back(ch); }
+    void put(const char *data, size_t size) { _buffer->append(data, size); }
+
+private:
+    void line(const char *text, size_t size);
+    void quote(const char *data, size_t size);
+
+private:
+    void open(const char *type);
+    void separate(void);
+
+/** Nodes **/
+
+public:
+    /* every node is enclosed by `begin()` and `end()`, the title is the line of the node in the tree */
+    void begin(const char *type, const char *title);
+    void end(void);
+
+public:
+    template <typename ... Args>
+    void begin(const char *type, const char *title, const Args & ... args)
+    {
+        if (_format != Format::Tree)
+            open(type);
+        else
+            begin(type, Strings::format(title, args ...).c_str());
+    }
+
+/** Children **/
+
+public:
+    /* name of the next child or scalar, not shown in the tree */
+    void key(const char *name);
+
+public:
+    /* a child node, null children are kept in structured formats, and skipped in the tree */
+    void node(const AST::Node *node);
+
+public:
+    /* children between `section()` and `endSection()` are nested under `label` in the tree, `key` can be null */
+    void section(const char *key, const char *label);
+    void endSection(void);
+
+public:
+    template <typename ... Args>
+    void section(const char *key, const char *label, const Args & ... args)
+    {
+        if (_format != Format::Tree)
+            this->key(key);
+        else
+            section(key, Strings::format(label, args ...).c_str());
+    }
+
+public:
+    /* a line of it's own in the tree, which structured formats don't have */
+    void label(const char *label);
+
+    template <typename ... Args>
+    void label(const char *label, const Args & ... args)
+    {
+        if (_format == Format::Tree)
+            this->label(Strings::format(label, args ...).c_str());
+    }
+
+public:
+    /* arrays in structured formats, the tree has no brackets */
+    void list(void);
+    void endList(void);
+
+/** Scalars **/
+
+public:
+    /* scalars are only in structured formats, the tree shows them in titles and labels, strings which are not
+     * well-formed UTF-8 are dumped as a `Bytes` record instead, with their `text`, where each byte which is not
+     * UTF-8 is U+FFFD, and all of their `bytes` in hex, so a dumped string always stands for exactly it's bytes,
+     * `{"type":"Bytes","text":"caf<U+FFFD>","bytes":"636166e9"}` in JSON, `(Bytes :text ... :bytes ...)` otherwise */
+    void boolean(bool value);
+    void integer(int64_t value);
+    void real(double value);
+    void string(StringView value);
+
+public:
+    void boolean(const char *key, bool value)       { this->key(key); boolean(value); }
+    void integer(const char *key, int64_t value)    { this->key(key); integer(value); }
+    void real(const char *key, double value)        { this->key(key); real(value); }
+    void string(const char *key, StringView value)  { this->key(key); string(value); }
+
+/** Shorthands **/
+
+public:
+    void field(const char *key, const AST::Node *value)
+    {
+        this->key(key);
+        node(value);
+    }
+
+    void field(const char *key, const char *label, const AST::Node *value)
+    {
+        section(key, label);
+        node(value);
+        endSection();
+    }
+
+public:
+    template <typename Container>
+    void items(const char *key, const Container &values)
+    {
+        this->key(key);
+        list();
+        for (const auto &value : values) node(value);
+        endList();
+    }
+
+};
+}
+}
+
+#endif /* COMMANDSCRIPT_COMPILER_DUMPER_H */
@@ -0,0 +1,83 @@
+#ifndef COMMANDSCRIPT_COMPILER_LINEINDEX_H
+#define COMMANDSCRIPT_COMPILER_LINEINDEX_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace CommandScript
+{
+namespace Compiler
+{
+/* maps byte offsets back to rows and columns, so tokens and nodes only need to carry an offset,
+ * rows and columns follows exactly the same rules as `Tokenizer::nextChar()` */
+class LineIndex
+{
+    struct Line
+    {
+        uint32_t begin;     /* first offset which belongs to this row */
+        uint32_t origin;    /* columns of this row are counted from here */
+    };
+
+private:
+    /* scanner states, a line break may straddle two consecutive pieces of source */
+    enum class State : int
+    {
+        Normal,
+        Break,              /* right after '\r' or '\n', may be paired with the next char */
+        Slash,              /* right after '\', may start a line continuation */
+        Continue,           /* right after a line continuation, may be paired with '\n' */
+        Verbatim,           /* char after a line continuation, taken as-is */
+        Stopped,            /* hit a NUL, nothing after it can ever be reached */
+    };
+
+private:
+    char _last;
+    State _state;
+
+private:
+    size_t _size;
+    size_t _limit;
+    size_t _dropped;
+    std::vector<Line> _lines;
+
+private:
+    /* an edited source only indexes the rows around the edit, offsets before them, or from `_to` on, are looked up in
+     * `_previous` instead, the latter `_delta` bytes earlier, and `_shift` rows off */
+    size_t _to;
+    ptrdiff_t _delta;
+    ptrdiff_t _shift;
+    const LineIndex *_previous;
+
+public:
+    explicit LineIndex();
+    explicit LineIndex(const char *data, size_t size);
+
+public:
+    /* rows of an edited source, `data` of `size` bytes, in which `removed` bytes at `offset` of the source indexed by
+     * `previous` were replaced, only rows from the last line break before the edit, until the rows line up again with
+     * the ones of `previous` after the edit, are indexed, the others are looked up in `previous`, which must outlive
+     * this one, and must not be fed any more */
+    explicit LineIndex(const LineIndex &previous, const char *data, size_t size, size_t offset, size_t removed);
+
+public:
+    /* source may also be fed piece by piece, `finish()` must be called after the last piece */
+    void append(const char *data, size_t size);
+    void finish(void);
+
+public:
+    /* rows before the one `offset` is in are no longer needed, offsets before it resolve to that row from now on */
+    void discard(size_t offset);
+
+public:
+    int row(size_t offset) const;
+    int col(size_t offset) const;
+
+public:
+    size_t rows(void) const { return _dropped + _lines.size(); }
+
+};
+}
+}
+
+#endif /* COMMANDSCRIPT_COMPILER_LINEINDEX_H */
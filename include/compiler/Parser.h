@@ -2,10 +2,11 @@
 #define COMMANDSCRIPT_COMPILER_PARSER_H
 
 #include <memory>
-#include <unordered_set>
 
 #include "AST.h"
+#include "Arena.h"
 #include "Tokenizer.h"
+#include "ThreadPool.h"
 #include "NonMovable.h"
 #include "NonCopyable.h"
 
@@ -15,16 +16,131 @@ namespace Compiler
 {
 class Parser : public NonCopyable
 {
+    std::shared_ptr<Arena> _arena;
     std::shared_ptr<Tokenizer> _tk;
 
+private:
+    /* bodies of functions and lambdas in blocks are skipped over, and only parsed on demand */
+    bool _lazy;
+
+private:
+    /* tokens of a top-level statement, where it's located, and how many nodes it's made of */
+    struct Span
+    {
+        size_t begin;
+        size_t end;
+        size_t furthest;
+
+    public:
+        size_t base;
+        size_t nodes;
+    };
+
+private:
+    /* kept from the last successful parse for `reparse()`, nodes are located relative to the top-level statement
+     * they belong to, so reused statements are moved without touching their nodes, arenas are chained by reuse */
+    size_t _generation = 0;
+    AST::Compond *_root = nullptr;
+    std::vector<Span> _spans;
+
+private:
+    /* nodes created by the last parse, and where the top-level statement being parsed is located */
+    size_t _nodes = 0;
+    size_t _base = 0;
+
+private:
+    /* names created by the last parse, not including those reused by `reparse()`, chunks of a parallel parse intern
+     * into symbol tables of their own, their names are pointed to the merged symbols without walking the trees */
+    std::vector<AST::Name *> _names;
+
+private:
+    /* tokens read by chunks of the last parse, `0` if it was read by `_tk` alone */
+    size_t _tokens = 0;
+
+private:
+    /* reparsing keeps at most this many generations of arenas alive, then starts over */
+    static constexpr size_t MaxGenerations = 16;
+
+public:
+    /* parallel parsing cuts the source into a few chunks per worker to even out the load, chunks smaller than
+     * `MinChunkSize` are not worth a task on their own */
+    static constexpr size_t MinChunkSize = 64 * 1024;
+    static constexpr size_t ChunksPerWorker = 4;
+
+public:
+    /* binary operator precedences, from lowest (BoolOr) to highest (Power) */
+    enum class Precedence : int
+    {
+        BoolOr,
+        BoolAnd,
+        BoolNot,
+        Relations,
+        BitOr,
+        BitXor,
+        BitAnd,
+        BitShift,
+        Term,
+        Factor,
+        Unary,
+        Power,
+        None,
+    };
+
 private:
     size_t _breakable = 0;
     size_t _returnable = 0;
     size_t _continuable = 0;
 
+public:
+    /* statements, expressions and target lists nest by recursion, each level takes up to about 1K of native stack in
+     * optimized builds, and 1.5K in debug ones, so the default needs about 256K to 384K, see `setMaxDepth()` for smaller
+     * stacks */
+    static constexpr size_t DefaultMaxDepth = 256;
+
+private:
+    size_t _depth = 0;
+    size_t _maxDepth = DefaultMaxDepth;
+
+private:
+    /* one level of nesting during it's lifetime, deeper sources are rejected rather than overflowing the stack */
+    struct Nesting : public NonCopyable
+    {
+        Parser *parser;
+
+    public:
+        ~Nesting() { parser->_depth--; }
+        explicit Nesting(Parser *parser);
+
+    };
+
 public:
     virtual ~Parser() {}
-    explicit Parser(const std::shared_ptr<Tokenizer> &tk) : _tk(tk) {}
+    explicit Parser(const std::shared_ptr<Tokenizer> &tk) : Parser(tk, false) {}
+    explicit Parser(const std::shared_ptr<Tokenizer> &tk, bool lazy) : _arena(std::make_shared<Arena>()), _tk(tk), _lazy(lazy) {}
+
+public:
+    /* nodes created by the last parse, including those reused by `reparse()` */
+    size_t nodes(void) const { return _nodes; }
+
+public:
+    /* tokens read by the last parse, the same whether it's parsed in chunks or not */
+    size_t tokens(void) const { return _tokens ? _tokens : _tk->count(); }
+
+public:
+    /* the native stack needed by parsing grows linearly with `depth`, sources nesting deeper raise a syntax error,
+     * so parsing can run on small stacks given a depth they can afford, such as 32 for fibers with 64K stacks */
+    size_t maxDepth(void) const { return _maxDepth; }
+    void setMaxDepth(size_t depth) { _maxDepth = depth; }
+
+private:
+    template <typename NodeType, typename ... Args>
+    NodeType *create(Args && ... args)
+    {
+        NodeType *node = AST::Node::create<NodeType>(*_arena, _tk, std::forward<Args>(args) ...);
+        node->offset -= static_cast<uint32_t>(_base);
+        _nodes++;
+        return node;
+    }
 
 private:
     void expect(Token::Keyword expect);
@@ -37,83 +153,106 @@ private:
 private:
     bool isOperator(Token::Operator expected);
     bool skipOperator(Token::Operator expected);
-    bool readOperators(Token::Operator &op, const std::unordered_set<Token::Operator> &operators);
+    bool readOperator(Token::Operator &op, Precedence level);
+
+private:
+    bool unpackPointerPair(AST::Expression *&expr, AST::Name *&name);
+    bool extractArgumentName(AST::Expression *expr, AST::Name *&name);
 
 private:
-    bool unpackPointerPair(std::shared_ptr<AST::Expression> &expr, std::shared_ptr<AST::Name> &name);
-    bool extractArgumentName(std::shared_ptr<AST::Expression> expr, std::shared_ptr<AST::Name> &name);
+    void parseBody(AST::Define *define);
 
 /** Language Structures **/
 private:
-    std::shared_ptr<AST::If         > parseIf               (void);
-    std::shared_ptr<AST::For        > parseFor              (void);
-    std::shared_ptr<AST::While      > parseWhile            (void);
-    std::shared_ptr<AST::Define     > parseDefine           (void);
-    std::shared_ptr<AST::Import     > parseImport           (void);
+    AST::If              *parseIf               (void);
+    AST::For             *parseFor              (void);
+    AST::While           *parseWhile            (void);
+    AST::Define          *parseDefine           (void);
+    AST::Import          *parseImport           (void);
 
 private:
-    std::shared_ptr<AST::Try        > parseTry              (void);
-    std::shared_ptr<AST::Except     > parseExcept           (void);
+    AST::Try             *parseTry              (void);
+    AST::Except          *parseExcept           (void);
 
 /** Statements **/
 private:
-    std::shared_ptr<AST::Tuple      > parseTupleExpression  (bool &isSeq);
-    std::shared_ptr<AST::Component  > parseMutableComponent (void);
+    AST::Tuple           *parseTupleExpression  (bool &isSeq);
+    AST::Component       *parseMutableComponent (void);
 
 public:
-    std::shared_ptr<AST::Assign     > parseAssign           (bool &isRewindable);
-    std::shared_ptr<AST::Inplace    > parseInplace          (bool &isRewindable);
+    AST::Assign          *parseAssign           (void);
+    AST::Inplace         *parseInplace          (void);
 
 private:
-    std::shared_ptr<AST::Delete     > parseDelete           (void);
-    std::shared_ptr<AST::Sequence   > parseSequence         (void);
+    AST::Delete          *parseDelete           (void);
+    AST::Sequence        *parseSequence         (void);
 
 private:
-    std::shared_ptr<AST::Compond    > parseCompond          (void);
-    std::shared_ptr<AST::Statement  > parseStatement        (void);
+    AST::Statement::Type  classifyStatement     (void);
+    AST::Compond         *parseCompond          (void);
+    AST::Statement       *parseStatement        (void);
+    AST::Statement       *parseTopLevel         (void);
 
 /** Control Flows **/
 private:
-    std::shared_ptr<AST::Break      > parseBreak            (void);
-    std::shared_ptr<AST::Raise      > parseRaise            (void);
-    std::shared_ptr<AST::Return     > parseReturn           (void);
-    std::shared_ptr<AST::Continue   > parseContinue         (void);
+    AST::Break           *parseBreak            (void);
+    AST::Raise           *parseRaise            (void);
+    AST::Return          *parseReturn           (void);
+    AST::Continue        *parseContinue         (void);
 
 /** Expression Components **/
 private:
-    std::shared_ptr<AST::Name       > parseName             (void);
-    std::shared_ptr<AST::Index      > parseIndex            (void);
-    std::shared_ptr<AST::Invoke     > parseInvoke           (void);
-    std::shared_ptr<AST::Attribute  > parseAttribute        (void);
+    AST::Name            *parseName             (void);
+    AST::Index           *parseIndex            (void);
+    AST::Invoke          *parseInvoke           (void);
+    AST::Attribute       *parseAttribute        (void);
 
 /** Expressions **/
 private:
-    std::shared_ptr<AST::Map        > parseMap              (void);
-    std::shared_ptr<AST::List       > parseList             (void);
-    std::shared_ptr<AST::Unit       > parseUnit             (void);
-    std::shared_ptr<AST::Constant   > parseConstant         (void);
-    std::shared_ptr<AST::Component  > parseComponent        (void);
-    std::shared_ptr<AST::Expression > parseExpression       (void) { return parseBoolOr(); }
-
-/** Operator Precedence Parsers, from highest precedence (Power) to lowest precedence (BoolOr) **/
-private:
-    std::shared_ptr<AST::Expression > parsePower            (void);
-    std::shared_ptr<AST::Expression > parseUnary            (void);
-    std::shared_ptr<AST::Expression > parseFactor           (void);
-    std::shared_ptr<AST::Expression > parseTerm             (void);
-    std::shared_ptr<AST::Expression > parseBitShift         (void);
-    std::shared_ptr<AST::Expression > parseBitAnd           (void);
-    std::shared_ptr<AST::Expression > parseBitXor           (void);
-    std::shared_ptr<AST::Expression > parseBitOr            (void);
-    std::shared_ptr<AST::Expression > parseRelations        (void);
-    std::shared_ptr<AST::Expression > parseBoolNot          (void);
-    std::shared_ptr<AST::Expression > parseBoolAnd          (void);
-    std::shared_ptr<AST::Expression > parseBoolOr           (void);
+    AST::Map             *parseMap              (void);
+    AST::List            *parseList             (void);
+    AST::Unit            *parseUnit             (void);
+    AST::Constant        *parseConstant         (void);
+    AST::Component       *parseComponent        (void);
+    AST::Expression      *parseExpression       (void) { return parseExpression(Precedence::BoolOr); }
+
+/** Operator Precedence Parser, climbs from the highest precedence (Power) up to `level` **/
+private:
+    AST::Expression      *parseExpression       (Precedence level);
 
 /** parser wrapper method **/
 public:
     std::shared_ptr<AST::Node> parse(void);
 
+private:
+    /* parse top-level statements which begin before `end`, `stopped` tells whether it stopped at a token rather than `EOF` */
+    std::shared_ptr<AST::Node> parseUntil(size_t end, bool &stopped);
+
+private:
+    /* tokens of a chunk parsed by `parseUntil()`, the ones ending no later than `end`, or all of them in the `last` chunk */
+    size_t tokensUntil(size_t end, bool last);
+
+public:
+    /* parse the chunks of a large source on `pool` concurrently, the result is exactly the same as `parse()`, which is
+     * used instead when the source is too small or not resident, whenever a chunk fails, to report the same error, and
+     * in lazy mode, nothing is kept for `reparse()` though, it starts over with a full parse */
+    std::shared_ptr<AST::Node> parse(ThreadPool &pool);
+
+public:
+    /* the body of `define`, which is parsed on first use if it was deferred, `define` must belong to the last tree
+     * parsed by this parser, since bodies are located by token indexes, errors in the body are only reported here */
+    AST::Statement *parseDeferred(AST::Define *define);
+
+public:
+    /* parse `source` again after an edit, in which `removed` bytes at `offset` of the previous source were replaced,
+     * only top-level statements around the edit are parsed again, the others are reused from the previous tree,
+     * which shares nodes with the new tree and must not be used any more, since reused statements are moved in place,
+     * in lazy mode nothing is reused, since deferred bodies are located by token indexes, it's always a full parse,
+     * otherwise only the source around the edit is read, and only rows around it are indexed, tokens and nodes away
+     * from it are left where they are, so the cost follows the size of the statements around the edit, apart from
+     * a few words for each top-level statement */
+    std::shared_ptr<AST::Node> reparse(const std::string &source, size_t offset, size_t removed);
+
 };
 }
 }
@@ -0,0 +1,183 @@
+#ifndef COMMANDSCRIPT_COMPILER_SERIALIZER_H
+#define COMMANDSCRIPT_COMPILER_SERIALIZER_H
+
+#include <memory>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "AST.h"
+#include "MappedFile.h"
+#include "SymbolTable.h"
+#include "NonCopyable.h"
+
+namespace CommandScript
+{
+namespace Compiler
+{
+/* a binary snapshot of a parsed tree, mapped read-only, records are fixed-sized and used in place, straight from the
+ * mapping, children are referenced by record indexes, and always come before their parents, strings are views into the
+ * mapping, which is kept alive as long as the snapshot, or any tree decoded from it */
+class Snapshot : public NonCopyable
+{
+public:
+    enum class Kind : uint8_t
+    {
+        If,
+        For,
+        While,
+        Define,
+        Import,
+        Try,
+        Except,
+        Assign,
+        Delete,
+        Inplace,
+        Sequence,
+        Compond,
+        Statement,
+        Break,
+        Raise,
+        Return,
+        Continue,
+        Name,
+        Index,
+        Invoke,
+        Attribute,
+        Map,
+        List,
+        Tuple,
+        Unit,
+        Pair,
+        Constant,
+        Component,
+        Expression,
+    };
+
+public:
+    /* a node, where `kind` tells how the rest is used :
+     *
+     *   - `type` is the type of statements, units, constants and components, or the operator of inplace statements and
+     *     unary expressions
+     *   - `flags` are the boolean fields of the node, the first one declared in the lowest bit
+     *   - `size` words of the link table from `link` on are the children, in the order they're declared, as references,
+     *     which are record indexes plus one, or `0` for null, groups of names of excepts are each preceded by their
+     *     size, and the remaining terms of expressions by their operator
+     *   - names and string constants refer to a string by `link` instead, integer and float constants have their
+     *     value across `link` and `size` */
+    struct Record
+    {
+        Kind kind;
+        uint8_t flags;
+        uint16_t type;
+        uint32_t offset;
+
+    public:
+        uint32_t link;
+        uint32_t size;
+    };
+
+public:
+    /* a range of the blob */
+    struct String
+    {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+private:
+    uint64_t _hash;
+    std::shared_ptr<MappedFile> _file;
+
+private:
+    size_t _nodes;
+    size_t _tokens;
+
+private:
+    size_t _size;
+    const Record *_records;
+
+private:
+    size_t _links;
+    const uint32_t *_link;
+
+private:
+    size_t _strings;
+    const String *_string;
+
+private:
+    uint64_t _bytes;
+    const char *_blob;
+
+private:
+    friend class Serializer;
+    explicit Snapshot(const std::shared_ptr<MappedFile> &file);
+
+public:
+    /* content hash of the source, and the number of records, one for each node */
+    uint64_t hash(void) const { return _hash; }
+    size_t size(void) const { return _size; }
+
+public:
+    /* tokens and nodes counted when the source was parsed, so a snapshot stands for the same work as a parse */
+    size_t nodes(void) const { return _nodes; }
+    size_t tokens(void) const { return _tokens; }
+
+public:
+    /* nothing but the header is checked when opened, records are checked as they're used instead, links and strings
+     * must be in range, and references must refer to an earlier record, so following them always ends, otherwise
+     * `std::out_of_range` is thrown, kinds of the records referred to are up to the caller to check */
+    const Record &root(void) const { return _records[_size - 1]; }
+    const Record *child(const Record &record, uint32_t index) const;
+
+public:
+    /* words of the link table which are not references, names and constants have no links */
+    uint32_t link(const Record &record, uint32_t index) const;
+    StringView string(const Record &record) const;
+
+public:
+    template <typename T>
+    T value(const Record &record) const
+    {
+        T result;
+        static_assert(sizeof(T) == sizeof(uint64_t), "constants are 64-bit");
+        memcpy(&result, &record.link, sizeof(T));
+        return result;
+    }
+
+public:
+    /* decode the records into nodes of a fresh arena, for everything that works on trees rather than records, every
+     * record is checked right before it's decoded, returns null if they don't make a tree, names are interned into
+     * `symbols`, strings of constants still point into the mapping */
+    std::shared_ptr<AST::Node> tree(const std::shared_ptr<SymbolTable> &symbols) const;
+
+};
+
+class Serializer : public NonCopyable
+{
+public:
+    /* content hash of a source, which snapshots are keyed by */
+    static uint64_t hash(const char *data, size_t size);
+    static uint64_t hash(const std::string &source) { return hash(source.data(), source.size()); }
+
+public:
+    /* write `tree` into `path`, tagged with the `hash` of it's source, and the numbers of `tokens` and `nodes` parsing
+     * it counted, the file is replaced atomically, so concurrent readers never see a partial snapshot, deferred bodies
+     * must be parsed before, since there are no tokens to refer */
+    static void save(const std::string &path, const AST::Node *tree, uint64_t hash, size_t tokens, size_t nodes);
+
+public:
+    /* map the snapshot in `path`, returns null if the file is missing, isn't a snapshot, or is one of a source other
+     * than the one with `hash`, only the header is read, nothing is decoded or copied */
+    static std::shared_ptr<Snapshot> open(const std::string &path, uint64_t hash);
+
+public:
+    /* `open()` and decode it into a tree of nodes, returns null just like `open()` and `Snapshot::tree()` */
+    static std::shared_ptr<AST::Node> load(const std::string &path, uint64_t hash, const std::shared_ptr<SymbolTable> &symbols);
+
+};
+}
+}
+
+#endif /* COMMANDSCRIPT_COMPILER_SERIALIZER_H */
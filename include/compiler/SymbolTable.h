@@ -0,0 +1,55 @@
+#ifndef COMMANDSCRIPT_COMPILER_SYMBOLTABLE_H
+#define COMMANDSCRIPT_COMPILER_SYMBOLTABLE_H
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <unordered_map>
+
+#include "StringView.h"
+#include "NonCopyable.h"
+
+namespace CommandScript
+{
+namespace Compiler
+{
+struct Symbol
+{
+    uint32_t id;
+    StringView name;
+
+public:
+    /* symbols are unique within a table, so identity is just the id */
+    bool operator==(const Symbol &other) const { return id == other.id; }
+    bool operator!=(const Symbol &other) const { return id != other.id; }
+
+};
+
+/* a table is only ever used by one thread at a time, tokenizers which run concurrently intern into tables of their
+ * own, which are merged afterwards, so the hot path never takes a lock */
+class SymbolTable : public NonCopyable
+{
+    /* `std::deque` never relocates it's elements, so both names and symbols keep their address */
+    std::deque<Symbol> _symbols;
+    std::deque<std::string> _names;
+    std::unordered_map<StringView, const Symbol *> _index;
+
+public:
+    size_t size(void) const { return _symbols.size(); }
+    const Symbol &operator[](uint32_t id) const { return _symbols[id]; }
+
+public:
+    /* returns the unique symbol of `name`, registers it on first sight */
+    const Symbol *intern(StringView name);
+
+public:
+    /* intern every symbol of `other` in the order they were registered there, the result is indexed by ids of `other`,
+     * merging the tables of consecutive pieces of a source in order gives the same ids as a single table would */
+    std::vector<const Symbol *> merge(const SymbolTable &other);
+
+};
+}
+}
+
+#endif /* COMMANDSCRIPT_COMPILER_SYMBOLTABLE_H */
@@ -1,12 +1,18 @@
 #ifndef COMMANDSCRIPT_COMPILER_TOKENIZER_H
 #define COMMANDSCRIPT_COMPILER_TOKENIZER_H
 
+#include <algorithm>
 #include <deque>
-#include <stack>
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "Strings.h"
+#include "LineIndex.h"
+#include "MappedFile.h"
+#include "StringView.h"
+#include "SymbolTable.h"
 #include "NonCopyable.h"
 #include "SyntaxError.h"
 
@@ -14,10 +20,10 @@ namespace CommandScript
 {
 namespace Compiler
 {
-class Token : public NonCopyable
+class Token
 {
-    int _row;
-    int _col;
+    /* byte offset of the end of this token in source, rows and columns are resolved from it on demand */
+    uint32_t _offset;
 
 public:
     enum class Type : int
@@ -118,49 +124,62 @@ public:
 
 private:
     Type _type;
+    uint32_t _size;
 
 private:
-    double _float = 0.0;
-    int64_t _integer = 0;
-    std::string _string = "";
-
-private:
-    Keyword _keyword;
-    Operator _operator;
-
-private:
-    /* tag structure to prevent public constructors being accessed by others
-     * we need to make those constructors public in order to enable `std::make_shared` */
-    struct Tag {};
+    /* payload of the token, selected by `_type`, strings reference either the tokenizer source or the
+     * decoded literal storage of the tokenizer, identifiers reference the symbol table, all outlive the token */
+    union
+    {
+        double _float;
+        int64_t _integer;
+        Keyword _keyword;
+        Operator _operator;
+        const char *_string;
+        const Symbol *_symbol;
+    };
 
 public:
-    explicit Token(Tag, int row, int col) : _row(row), _col(col), _type(Type::Eof) {}
-    explicit Token(Tag, int row, int col, Type type, const std::string &value) : _row(row), _col(col), _type(type), _string(value) {}
+    explicit Token(uint32_t offset) : _offset(offset), _type(Type::Eof), _size(0), _integer(0) {}
+    explicit Token(uint32_t offset, StringView value) : _offset(offset), _type(Type::String), _size(static_cast<uint32_t>(value.size())), _string(value.data()) {}
+    explicit Token(uint32_t offset, const Symbol *value) : _offset(offset), _type(Type::Identifiers), _size(0), _symbol(value) {}
 
 public:
-    explicit Token(Tag, int row, int col, double value) : _row(row), _col(col), _type(Type::Float), _float(value) {}
-    explicit Token(Tag, int row, int col, int64_t value) : _row(row), _col(col), _type(Type::Integer), _integer(value) {}
+    explicit Token(uint32_t offset, double value) : _offset(offset), _type(Type::Float), _size(0), _float(value) {}
+    explicit Token(uint32_t offset, int64_t value) : _offset(offset), _type(Type::Integer), _size(0), _integer(value) {}
 
 public:
-    explicit Token(Tag, int row, int col, Keyword value) : _row(row), _col(col), _type(Type::Keywords), _keyword(value) {}
-    explicit Token(Tag, int row, int col, Operator value) : _row(row), _col(col), _type(Type::Operators), _operator(value) {}
+    explicit Token(uint32_t offset, Keyword value) : _offset(offset), _type(Type::Keywords), _size(0), _keyword(value) {}
+    explicit Token(uint32_t offset, Operator value) : _offset(offset), _type(Type::Operators), _size(0), _operator(value) {}
 
 public:
-    int row(void) const { return _row; }
-    int col(void) const { return _col; }
     Type type(void) const { return _type; }
+    uint32_t offset(void) const { return _offset; }
+
+public:
+    /* the same token, moved by `delta` bytes in source */
+    Token relocate(ptrdiff_t delta) const
+    {
+        Token result(*this);
+        result._offset = static_cast<uint32_t>(_offset + delta);
+        return result;
+    }
 
 public:
     template <Type T>
     bool is(void) const { return _type == T; }
 
+public:
+    bool isKeyword(Keyword value) const { return (_type == Type::Keywords) && (_keyword == value); }
+    bool isOperator(Operator value) const { return (_type == Type::Operators) && (_operator == value); }
+
 public:
     double asFloat(void) const
     {
         if (_type == Type::Float)
             return _float;
         else
-            throw Exception::SyntaxError(_row, _col, Strings::format("\"Float\" expected, but got \"%s\"", toString()));
+            throw Exception::SyntaxError(_offset, Strings::format("\"Float\" expected, but got \"%s\"", toString()));
     }
 
 public:
@@ -169,7 +188,7 @@ public:
         if (_type == Type::Integer)
             return _integer;
         else
-            throw Exception::SyntaxError(_row, _col, Strings::format("\"Integer\" expected, but got \"%s\"", toString()));
+            throw Exception::SyntaxError(_offset, Strings::format("\"Integer\" expected, but got \"%s\"", toString()));
     }
 
 public:
@@ -178,7 +197,7 @@ public:
         if (_type == Type::Keywords)
             return _keyword;
         else
-            throw Exception::SyntaxError(_row, _col, Strings::format("\"Keyword\" expected, but got \"%s\"", toString()));
+            throw Exception::SyntaxError(_offset, Strings::format("\"Keyword\" expected, but got \"%s\"", toString()));
     }
 
 public:
@@ -187,32 +206,41 @@ public:
         if (_type == Type::Operators)
             return _operator;
         else
-            throw Exception::SyntaxError(_row, _col, Strings::format("\"Operator\" expected, but got \"%s\"", toString()));
+            throw Exception::SyntaxError(_offset, Strings::format("\"Operator\" expected, but got \"%s\"", toString()));
     }
 
 public:
-    const std::string &asString(void) const
+    StringView asString(void) const
     {
         if (_type == Type::String)
-            return _string;
+            return StringView(_string, _size);
         else
-            throw Exception::SyntaxError(_row, _col, Strings::format("\"String\" expected, but got \"%s\"", toString()));
+            throw Exception::SyntaxError(_offset, Strings::format("\"String\" expected, but got \"%s\"", toString()));
     }
 
 public:
-    const std::string &asIdentifier(void) const
+    StringView asIdentifier(void) const
     {
         if (_type == Type::Identifiers)
-            return _string;
+            return _symbol->name;
         else
-            throw Exception::SyntaxError(_row, _col, Strings::format("\"Identifier\" expected, but got \"%s\"", toString()));
+            throw Exception::SyntaxError(_offset, Strings::format("\"Identifier\" expected, but got \"%s\"", toString()));
+    }
+
+public:
+    const Symbol *asSymbol(void) const
+    {
+        if (_type == Type::Identifiers)
+            return _symbol;
+        else
+            throw Exception::SyntaxError(_offset, Strings::format("\"Identifier\" expected, but got \"%s\"", toString()));
     }
 
 public:
     void asEof(void) const
     {
         if (_type != Type::Eof)
-            throw Exception::SyntaxError(_row, _col, Strings::format("\"Eof\" expected, but got \"%s\"", toString()));
+            throw Exception::SyntaxError(_offset, Strings::format("\"Eof\" expected, but got \"%s\"", toString()));
     }
 
 public:
@@ -222,9 +250,9 @@ public:
         {
             case Type::Eof          : return "<Eof>";
             case Type::Float        : return Strings::format("<Float %f>"       , _float);
-            case Type::String       : return Strings::format("<String %s>"      , Strings::repr(_string.data(), _string.size()));
+            case Type::String       : return Strings::format("<String %s>"      , Strings::repr(_string, _size));
             case Type::Integer      : return Strings::format("<Integer %ld>"    , _integer);
-            case Type::Identifiers  : return Strings::format("<Identifier %s>"  , _string);
+            case Type::Identifiers  : return Strings::format("<Identifier %s>"  , _symbol->name.str());
 
             case Type::Keywords     : return Strings::format("<Keyword %s>"     , keywordName(_keyword));
             case Type::Operators    : return Strings::format("<Operator '%s'>"  , operatorName(_operator));
@@ -232,29 +260,19 @@ public:
     }
 
 public:
-    static inline std::shared_ptr<Token> createEof(int row, int col) { return std::make_shared<Token>(Tag(), row, col); }
-
-public:
-    static inline std::shared_ptr<Token> createValue(int row, int col, double value) { return std::make_shared<Token>(Tag(), row, col, value); }
-    static inline std::shared_ptr<Token> createValue(int row, int col, int64_t value) { return std::make_shared<Token>(Tag(), row, col, value); }
+    static inline Token createEof(uint32_t offset) { return Token(offset); }
 
 public:
-    static inline std::shared_ptr<Token> createKeyword(int row, int col, Keyword value) { return std::make_shared<Token>(Tag(), row, col, value); }
-    static inline std::shared_ptr<Token> createOperator(int row, int col, Operator value) { return std::make_shared<Token>(Tag(), row, col, value); }
+    static inline Token createValue(uint32_t offset, double value) { return Token(offset, value); }
+    static inline Token createValue(uint32_t offset, int64_t value) { return Token(offset, value); }
 
 public:
-    static inline std::shared_ptr<Token> createString(int row, int col, const std::string &value)
-    {
-        /* simply delegate to constructor */
-        return std::make_shared<Token>(Tag(), row, col, Type::String, value);
-    }
+    static inline Token createKeyword(uint32_t offset, Keyword value) { return Token(offset, value); }
+    static inline Token createOperator(uint32_t offset, Operator value) { return Token(offset, value); }
 
 public:
-    static inline std::shared_ptr<Token> createIdentifier(int row, int col, const std::string &value)
-    {
-        /* simply delegate to constructor */
-        return std::make_shared<Token>(Tag(), row, col, Type::Identifiers, value);
-    }
+    static inline Token createString(uint32_t offset, StringView value) { return Token(offset, value); }
+    static inline Token createIdentifier(uint32_t offset, const Symbol *value) { return Token(offset, value); }
 
 public:
     static constexpr const char *typeName(Type value)
@@ -367,29 +385,164 @@ public:
 
 class Tokenizer : public NonCopyable
 {
-    struct State
+public:
+    /* fills at most `size` bytes into `buffer`, returns how many were actually filled, 0 means end of input */
+    typedef std::function<size_t(char *buffer, size_t size)> Reader;
+
+private:
+    size_t _pos;
+
+private:
+    /* the source is either an owned copy of a string, or a read-only mapping of a file,
+     * it is not NUL-terminated, every read checks against its size instead, offsets are 32-bit,
+     * so sources of more than 4 GiB throw `std::system_error` with `EFBIG`, streams once they get that far */
+    std::string _buffer;
+    std::shared_ptr<MappedFile> _file;
+
+private:
+    /* streaming mode, `_source` is only a window of the input which starts at offset `_base`, chunks
+     * are pulled from `_reader` on demand, and consumed ones are dropped between tokens */
+    bool _eof;
+    size_t _base;
+    size_t _chunk;
+    Reader _reader;
+
+private:
+    /* size of the whole source, which is not resident any more after an edit */
+    size_t _size;
+    StringView _source;
+
+private:
+    /* built once for the whole source, only consulted when row and column are actually needed,
+     * in streaming mode it's built as the source arrives, and rows of released tokens are dropped */
+    LineIndex _lines;
+
+private:
+    /* every token ever read lives in `_tokens`, the parser walks it with `_index` and
+     * backtracks by restoring a saved index, so nothing is ever read twice, `_furthest` is
+     * the highest index ever looked at, what has been parsed so far depends on nothing beyond it,
+     * indexes are absolute, `_tokens` begins at `_first`, tokens before it were released */
+    size_t _last;
+    size_t _first;
+    size_t _index;
+    size_t _furthest;
+    std::vector<Token> _tokens;
+
+private:
+    /* the token right after `_tokens` could not be read, it's reported only when fetched, so errors earlier
+     * in the source are found first, no matter how far ahead the tokens were read */
+    std::unique_ptr<Exception::SyntaxError> _error;
+
+public:
+    /* how the tokens of a previous tokenizer were carried over after an edit, tokens before `kept` are
+     * exactly the same, tokens from `moved` on are the same but `shift` positions and `delta` bytes later,
+     * source offsets at or beyond `limit` in the previous source moved by `delta` bytes as well */
+    struct Reuse
     {
-        int row;
-        int col;
-        int pos;
+        size_t kept;
+        size_t moved;
+        size_t limit;
+        ptrdiff_t shift;
+        ptrdiff_t delta;
+    };
 
-    public:
-        std::deque<std::shared_ptr<Token>> cache;
+private:
+    Reuse _reuse;
 
+private:
+    /* after an edit, tokens outside of `_tokens` are left where they are, in the buffers of previous tokenizers, which
+     * are kept alive by `_previous`, each piece is a run of `count` of them from index `first` on, `delta` bytes off */
+    struct Piece
+    {
+        const Token *tokens;
+        size_t first;
+        size_t count;
+        ptrdiff_t delta;
     };
 
 private:
-    State *_state;
-    std::string _source;
-    std::stack<State> _stack;
+    std::vector<Piece> _pieces;
+    std::shared_ptr<const Tokenizer> _previous;
+
+private:
+    /* index of the matching closing bracket for each token of `_tokens`, every token matches itself by default,
+     * tokens are paired only as far as `_paired` as the parser asks for them, `_opened` are the opening
+     * brackets before it which are not closed yet */
+    size_t _paired;
+    std::vector<size_t> _opened;
+    std::vector<uint32_t> _pairs;
+
+private:
+    /* decoded copies of literals that can't reference the source directly,
+     * `std::deque` never relocates it's elements, so tokens can safely point into it */
+    std::deque<std::string> _strings;
+
+private:
+    /* identifiers are interned, the table may be shared by several tokenizers of the same compilation, one at a time */
+    std::shared_ptr<SymbolTable> _symbols;
+
+public:
+    explicit Tokenizer(const std::string &source) : Tokenizer(source, std::make_shared<SymbolTable>()) {}
+    explicit Tokenizer(const std::string &source, const std::shared_ptr<SymbolTable> &symbols);
 
 public:
-    explicit Tokenizer(const std::string &source);
+    /* tokenize directly over a file mapping, without ever copying the file */
+    explicit Tokenizer(const std::shared_ptr<MappedFile> &file) : Tokenizer(file, std::make_shared<SymbolTable>()) {}
+    explicit Tokenizer(const std::shared_ptr<MappedFile> &file, const std::shared_ptr<SymbolTable> &symbols);
 
 public:
-    int row(void) const { return _state->row; }
-    int col(void) const { return _state->col; }
-    int pos(void) const { return _state->pos; }
+    /* pull the source from `reader` in `chunk` bytes at a time, only a few chunks are kept in memory */
+    explicit Tokenizer(const Reader &reader, size_t chunk) : Tokenizer(reader, chunk, std::make_shared<SymbolTable>()) {}
+    explicit Tokenizer(const Reader &reader, size_t chunk, const std::shared_ptr<SymbolTable> &symbols);
+
+public:
+    /* tokenize an edited version of the source of `previous`, in which `removed` bytes at `offset` were replaced, only
+     * tokens around the edit are read again, the others are left in the buffers of `previous`, and only those from
+     * token `from` on, which is no later than `previous->unchanged(offset)`, are copied into `_tokens` as they're asked
+     * for, `previous` must be fully tokenized and resident, `source` is only referenced during the constructor, so
+     * the edited source is never resident as a whole, and can't be split into chunks */
+    explicit Tokenizer(const std::shared_ptr<const Tokenizer> &previous, const std::string &source, size_t offset, size_t removed, size_t from);
+
+public:
+    /* tokenize `end - begin` bytes at `begin` of the source of `whole`, which must be resident and must outlive this one,
+     * offsets are still relative to the whole source, but rows and columns are not tracked, so errors can't be resolved,
+     * names are interned into `symbols`, so pieces tokenized concurrently don't have to share a table */
+    explicit Tokenizer(const Tokenizer &whole, size_t begin, size_t end, const std::shared_ptr<SymbolTable> &symbols);
+
+public:
+    /* cut the source into at most `count` chunks of at least `least` bytes, each of them begins with a word at the start
+     * of a line at top-level, and overlaps the next one by the word the next one begins with, so the statement before the
+     * cut can see the same token after it as it would with the whole source, chunks are `(begin, end)` pairs of offsets */
+    std::vector<std::pair<size_t, size_t>> split(size_t count, size_t least) const;
+
+public:
+    /* tokens before the returned index are left exactly the same by an edit at `offset`, it's a fully tokenized source */
+    size_t unchanged(size_t offset) const;
+
+public:
+    const Reuse &reuse(void) const { return _reuse; }
+    const std::shared_ptr<SymbolTable> &symbols(void) const { return _symbols; }
+
+public:
+    int pos(void) const { return static_cast<int>(_pos); }
+    uint32_t offset(void) const { return _tokens.empty() ? static_cast<uint32_t>(_pos) : _tokens[_last - _first].offset(); }
+
+public:
+    int row(void) const { return _lines.row(offset()); }
+    int col(void) const { return _lines.col(offset()); }
+
+public:
+    int row(size_t offset) const { return _lines.row(offset); }
+    int col(size_t offset) const { return _lines.col(offset); }
+
+private:
+    /* window access by absolute offsets, `within()` pulls more chunks when streaming */
+    char at(size_t pos) const { return _source[pos - _base]; }
+    bool within(size_t pos) { return (pos < _base + _source.size()) || (!_eof && fill(pos)); }
+
+private:
+    bool fill(size_t pos);
+    void compact(void);
 
 private:
     char peekChar(void);
@@ -400,47 +553,94 @@ private:
     void skipComments(void);
 
 private:
-    std::shared_ptr<Token> read(void);
-    std::shared_ptr<Token> readString(void);
-    std::shared_ptr<Token> readNumber(void);
-    std::shared_ptr<Token> readOperator(void);
-    std::shared_ptr<Token> readIdentifier(void);
+    Token read(void);
+    Token readString(void);
+    Token readNumber(void);
+    size_t readDigits(unsigned int base, uint64_t &value, size_t &dropped);
+    Token readOperator(void);
+    Token readIdentifier(void);
+    Token readIdentifierSlow(void);
+
+private:
+    Token createIdentifier(StringView token);
+    Token readUntil(size_t index);
+
+private:
+    /* the token after `_tokens`, carried over from a previous tokenizer if there's one, read otherwise */
+    Token advance(void);
+
+private:
+    /* tokens of any index, inside `_tokens` or not, the piece an index is in, if any, and every token as pieces */
+    Token stored(size_t index) const;
+    const Piece *locate(size_t index) const;
+    std::vector<Piece> pieces(void) const;
+
+private:
+    /* pair the next token with the opening brackets before it */
+    void pair(void);
 
 public:
-    void popState(void)
+    Token fetch(size_t index)
     {
-        _stack.pop();
-        _state = &(_stack.top());
+        /* remember how far the parser has ever looked */
+        if (index > _furthest)
+            _furthest = index;
+
+        /* fast path, token already in buffer */
+        if (index - _first < _tokens.size())
+            return _tokens[index - _first];
+        else
+            return readUntil(index);
     }
 
 public:
-    void pushState(void)
-    {
-        _stack.push(static_cast<const State &>(_stack.top()));
-        _state = &(_stack.top());
-    }
+    /* read all remaining tokens into buffer at once, stops at the first invalid token, which throws when fetched */
+    void tokenize(void);
+
+public:
+    /* tokens read so far, including `EOF` once reached, and the released ones, or carried over from a previous tokenizer */
+    size_t count(void) const { return std::max(_first + _tokens.size(), _pieces.empty() ? 0 : _pieces.back().first + _pieces.back().count); }
+
+public:
+    /* whether the source is pulled from a reader, rather than being resident as a whole */
+    bool streaming(void) const { return static_cast<bool>(_reader); }
+
+public:
+    /* index of the bracket which closes the one at `index`, or the index of `EOF` if it never closes,
+     * tokens are only read as far as the closing bracket */
+    size_t match(size_t index);
+
+public:
+    /* drop tokens before `index`, which the parser must never look at again, along with their decoded literals and
+     * rows, this is what keeps memory bounded in streaming mode, restoring checkpoints before `index` is not allowed */
+    void release(size_t index);
 
 public:
-    void killState(void)
+    /* checkpoints are the cursor, and the last token read, which is where positions are reported,
+     * restoring one never re-reads anything */
+    struct State
     {
-        /* must save before pop */
-        State state = std::move(*_state);
+        size_t index;
+        size_t last;
+    };
 
-        /* discard previous state */
-        _stack.pop();
-        _stack.top() = std::move(state);
+public:
+    State save(void) const { return State { _index, _last }; }
+    void restore(const State &state) { _index = state.index; _last = state.last; }
 
-        /* reset current state pointer */
-        _state = &(_stack.top());
-    }
+public:
+    /* the cursor as a buffer index, `seek()` moves it without touching the reported position */
+    size_t index(void) const { return _index; }
+    size_t furthest(void) const { return _furthest; }
+    void seek(size_t index) { _index = index; }
 
 public:
-    std::shared_ptr<Token> next(void);
-    std::shared_ptr<Token> peek(void);
+    Token next(void);
+    Token peek(void);
 
 public:
-    std::shared_ptr<Token> nextOrLine(void);
-    std::shared_ptr<Token> peekOrLine(void);
+    Token nextOrLine(void);
+    Token peekOrLine(void);
 
 };
 }
@@ -0,0 +1,670 @@
+#ifndef COMMANDSCRIPT_COMPILER_VISITOR_H
+#define COMMANDSCRIPT_COMPILER_VISITOR_H
+
+#include <vector>
+#include <algorithm>
+
+#include "AST.h"
+
+namespace CommandScript
+{
+namespace Compiler
+{
+/* walks trees with static dispatch, `Derived` hides the hooks it's interested in :
+ *
+ *   - `visitXXX()` is called before the children of a node, returning false skips them
+ *   - `leaveXXX()` is called after the children, and returns the node which replaces it in it's parent
+ *
+ * specific hooks fall back to `visitNode()` and `leaveNode()`, so passes that treat every node alike only need these
+ * two, children are visited in source order, null children, such as deferred bodies, are skipped, and nodes must not
+ * be changed before their parents are left, except by replacing them
+ *
+ * `traverse()` recurses once per level of the tree, `walk()` keeps an explicit stack instead, so arbitrarily deep
+ * trees can be walked on small stacks, both of them call the hooks in exactly the same order */
+template <typename Derived>
+class Visitor
+{
+    enum class Kind : int
+    {
+        If,
+        For,
+        While,
+        Define,
+        Import,
+
+        Try,
+        Except,
+
+        Assign,
+        Delete,
+        Inplace,
+        Sequence,
+
+        Compond,
+        Statement,
+
+        Break,
+        Raise,
+        Return,
+        Continue,
+
+        Name,
+        Index,
+        Invoke,
+        Attribute,
+
+        Map,
+        List,
+        Tuple,
+
+        Unit,
+        Pair,
+        Constant,
+        Component,
+        Expression,
+    };
+
+private:
+    /* the slot in the parent which holds the node, so `leaveXXX()` can replace it */
+    struct Entry
+    {
+        Kind kind;
+        bool leave;
+        void *slot;
+    };
+
+private:
+    std::vector<Entry> _stack;
+
+private:
+    Derived &self(void) { return *static_cast<Derived *>(this); }
+
+/** Generic Hooks **/
+
+public:
+    bool visitNode(AST::Node *) { return true; }
+    void leaveNode(AST::Node *) {}
+
+/** Language Structures **/
+
+public:
+    bool visitIf        (AST::If         *node) { return self().visitNode(node); }
+    bool visitFor       (AST::For        *node) { return self().visitNode(node); }
+    bool visitWhile     (AST::While      *node) { return self().visitNode(node); }
+    bool visitDefine    (AST::Define     *node) { return self().visitNode(node); }
+    bool visitImport    (AST::Import     *node) { return self().visitNode(node); }
+
+public:
+    bool visitTry       (AST::Try        *node) { return self().visitNode(node); }
+    bool visitExcept    (AST::Except     *node) { return self().visitNode(node); }
+
+/** Statements **/
+
+public:
+    bool visitAssign    (AST::Assign     *node) { return self().visitNode(node); }
+    bool visitDelete    (AST::Delete     *node) { return self().visitNode(node); }
+    bool visitInplace   (AST::Inplace    *node) { return self().visitNode(node); }
+    bool visitSequence  (AST::Sequence   *node) { return self().visitNode(node); }
+
+public:
+    bool visitCompond   (AST::Compond    *node) { return self().visitNode(node); }
+    bool visitStatement (AST::Statement  *node) { return self().visitNode(node); }
+
+/** Control Flows **/
+
+public:
+    bool visitBreak     (AST::Break      *node) { return self().visitNode(node); }
+    bool visitRaise     (AST::Raise      *node) { return self().visitNode(node); }
+    bool visitReturn    (AST::Return     *node) { return self().visitNode(node); }
+    bool visitContinue  (AST::Continue   *node) { return self().visitNode(node); }
+
+/** Expression Components **/
+
+public:
+    bool visitName      (AST::Name       *node) { return self().visitNode(node); }
+    bool visitIndex     (AST::Index      *node) { return self().visitNode(node); }
+    bool visitInvoke    (AST::Invoke     *node) { return self().visitNode(node); }
+    bool visitAttribute (AST::Attribute  *node) { return self().visitNode(node); }
+
+/** Expressions **/
+
+public:
+    bool visitMap       (AST::Map        *node) { return self().visitNode(node); }
+    bool visitList      (AST::List       *node) { return self().visitNode(node); }
+    bool visitTuple     (AST::Tuple      *node) { return self().visitNode(node); }
+
+public:
+    bool visitUnit      (AST::Unit       *node) { return self().visitNode(node); }
+    bool visitPair      (AST::Pair       *node) { return self().visitNode(node); }
+    bool visitConstant  (AST::Constant   *node) { return self().visitNode(node); }
+    bool visitComponent (AST::Component  *node) { return self().visitNode(node); }
+    bool visitExpression(AST::Expression *node) { return self().visitNode(node); }
+
+/** Language Structures **/
+
+public:
+    AST::If         *leaveIf        (AST::If         *node) { self().leaveNode(node); return node; }
+    AST::For        *leaveFor       (AST::For        *node) { self().leaveNode(node); return node; }
+    AST::While      *leaveWhile     (AST::While      *node) { self().leaveNode(node); return node; }
+    AST::Define     *leaveDefine    (AST::Define     *node) { self().leaveNode(node); return node; }
+    AST::Import     *leaveImport    (AST::Import     *node) { self().leaveNode(node); return node; }
+
+public:
+    AST::Try        *leaveTry       (AST::Try        *node) { self().leaveNode(node); return node; }
+    AST::Except     *leaveExcept    (AST::Except     *node) { self().leaveNode(node); return node; }
+
+/** Statements **/
+
+public:
+    AST::Assign     *leaveAssign    (AST::Assign     *node) { self().leaveNode(node); return node; }
+    AST::Delete     *leaveDelete    (AST::Delete     *node) { self().leaveNode(node); return node; }
+    AST::Inplace    *leaveInplace   (AST::Inplace    *node) { self().leaveNode(node); return node; }
+    AST::Sequence   *leaveSequence  (AST::Sequence   *node) { self().leaveNode(node); return node; }
+
+public:
+    AST::Compond    *leaveCompond   (AST::Compond    *node) { self().leaveNode(node); return node; }
+    AST::Statement  *leaveStatement (AST::Statement  *node) { self().leaveNode(node); return node; }
+
+/** Control Flows **/
+
+public:
+    AST::Break      *leaveBreak     (AST::Break      *node) { self().leaveNode(node); return node; }
+    AST::Raise      *leaveRaise     (AST::Raise      *node) { self().leaveNode(node); return node; }
+    AST::Return     *leaveReturn    (AST::Return     *node) { self().leaveNode(node); return node; }
+    AST::Continue   *leaveContinue  (AST::Continue   *node) { self().leaveNode(node); return node; }
+
+/** Expression Components **/
+
+public:
+    AST::Name       *leaveName      (AST::Name       *node) { self().leaveNode(node); return node; }
+    AST::Index      *leaveIndex     (AST::Index      *node) { self().leaveNode(node); return node; }
+    AST::Invoke     *leaveInvoke    (AST::Invoke     *node) { self().leaveNode(node); return node; }
+    AST::Attribute  *leaveAttribute (AST::Attribute  *node) { self().leaveNode(node); return node; }
+
+/** Expressions **/
+
+public:
+    AST::Map        *leaveMap       (AST::Map        *node) { self().leaveNode(node); return node; }
+    AST::List       *leaveList      (AST::List       *node) { self().leaveNode(node); return node; }
+    AST::Tuple      *leaveTuple     (AST::Tuple      *node) { self().leaveNode(node); return node; }
+
+public:
+    AST::Unit       *leaveUnit      (AST::Unit       *node) { self().leaveNode(node); return node; }
+    AST::Pair       *leavePair      (AST::Pair       *node) { self().leaveNode(node); return node; }
+    AST::Constant   *leaveConstant  (AST::Constant   *node) { self().leaveNode(node); return node; }
+    AST::Component  *leaveComponent (AST::Component  *node) { self().leaveNode(node); return node; }
+    AST::Expression *leaveExpression(AST::Expression *node) { self().leaveNode(node); return node; }
+
+/** Dispatching **/
+
+private:
+    static Kind kind(AST::If         **) { return Kind::If        ; }
+    static Kind kind(AST::For        **) { return Kind::For       ; }
+    static Kind kind(AST::While      **) { return Kind::While     ; }
+    static Kind kind(AST::Define     **) { return Kind::Define    ; }
+    static Kind kind(AST::Import     **) { return Kind::Import    ; }
+    static Kind kind(AST::Try        **) { return Kind::Try       ; }
+    static Kind kind(AST::Except     **) { return Kind::Except    ; }
+    static Kind kind(AST::Assign     **) { return Kind::Assign    ; }
+    static Kind kind(AST::Delete     **) { return Kind::Delete    ; }
+    static Kind kind(AST::Inplace    **) { return Kind::Inplace   ; }
+    static Kind kind(AST::Sequence   **) { return Kind::Sequence  ; }
+    static Kind kind(AST::Compond    **) { return Kind::Compond   ; }
+    static Kind kind(AST::Statement  **) { return Kind::Statement ; }
+    static Kind kind(AST::Break      **) { return Kind::Break     ; }
+    static Kind kind(AST::Raise      **) { return Kind::Raise     ; }
+    static Kind kind(AST::Return     **) { return Kind::Return    ; }
+    static Kind kind(AST::Continue   **) { return Kind::Continue  ; }
+    static Kind kind(AST::Name       **) { return Kind::Name      ; }
+    static Kind kind(AST::Index      **) { return Kind::Index     ; }
+    static Kind kind(AST::Invoke     **) { return Kind::Invoke    ; }
+    static Kind kind(AST::Attribute  **) { return Kind::Attribute ; }
+    static Kind kind(AST::Map        **) { return Kind::Map       ; }
+    static Kind kind(AST::List       **) { return Kind::List      ; }
+    static Kind kind(AST::Tuple      **) { return Kind::Tuple     ; }
+    static Kind kind(AST::Unit       **) { return Kind::Unit      ; }
+    static Kind kind(AST::Pair       **) { return Kind::Pair      ; }
+    static Kind kind(AST::Constant   **) { return Kind::Constant  ; }
+    static Kind kind(AST::Component  **) { return Kind::Component ; }
+    static Kind kind(AST::Expression **) { return Kind::Expression; }
+
+private:
+    bool visit(AST::If         *node) { return self().visitIf        (node); }
+    bool visit(AST::For        *node) { return self().visitFor       (node); }
+    bool visit(AST::While      *node) { return self().visitWhile     (node); }
+    bool visit(AST::Define     *node) { return self().visitDefine    (node); }
+    bool visit(AST::Import     *node) { return self().visitImport    (node); }
+    bool visit(AST::Try        *node) { return self().visitTry       (node); }
+    bool visit(AST::Except     *node) { return self().visitExcept    (node); }
+    bool visit(AST::Assign     *node) { return self().visitAssign    (node); }
+    bool visit(AST::Delete     *node) { return self().visitDelete    (node); }
+    bool visit(AST::Inplace    *node) { return self().visitInplace   (node); }
+    bool visit(AST::Sequence   *node) { return self().visitSequence  (node); }
+    bool visit(AST::Compond    *node) { return self().visitCompond   (node); }
+    bool visit(AST::Statement  *node) { return self().visitStatement (node); }
+    bool visit(AST::Break      *node) { return self().visitBreak     (node); }
+    bool visit(AST::Raise      *node) { return self().visitRaise     (node); }
+    bool visit(AST::Return     *node) { return self().visitReturn    (node); }
+    bool visit(AST::Continue   *node) { return self().visitContinue  (node); }
+    bool visit(AST::Name       *node) { return self().visitName      (node); }
+    bool visit(AST::Index      *node) { return self().visitIndex     (node); }
+    bool visit(AST::Invoke     *node) { return self().visitInvoke    (node); }
+    bool visit(AST::Attribute  *node) { return self().visitAttribute (node); }
+    bool visit(AST::Map        *node) { return self().visitMap       (node); }
+    bool visit(AST::List       *node) { return self().visitList      (node); }
+    bool visit(AST::Tuple      *node) { return self().visitTuple     (node); }
+    bool visit(AST::Unit       *node) { return self().visitUnit      (node); }
+    bool visit(AST::Pair       *node) { return self().visitPair      (node); }
+    bool visit(AST::Constant   *node) { return self().visitConstant  (node); }
+    bool visit(AST::Component  *node) { return self().visitComponent (node); }
+    bool visit(AST::Expression *node) { return self().visitExpression(node); }
+
+private:
+    AST::If         *leave(AST::If         *node) { return self().leaveIf        (node); }
+    AST::For        *leave(AST::For        *node) { return self().leaveFor       (node); }
+    AST::While      *leave(AST::While      *node) { return self().leaveWhile     (node); }
+    AST::Define     *leave(AST::Define     *node) { return self().leaveDefine    (node); }
+    AST::Import     *leave(AST::Import     *node) { return self().leaveImport    (node); }
+    AST::Try        *leave(AST::Try        *node) { return self().leaveTry       (node); }
+    AST::Except     *leave(AST::Except     *node) { return self().leaveExcept    (node); }
+    AST::Assign     *leave(AST::Assign     *node) { return self().leaveAssign    (node); }
+    AST::Delete     *leave(AST::Delete     *node) { return self().leaveDelete    (node); }
+    AST::Inplace    *leave(AST::Inplace    *node) { return self().leaveInplace   (node); }
+    AST::Sequence   *leave(AST::Sequence   *node) { return self().leaveSequence  (node); }
+    AST::Compond    *leave(AST::Compond    *node) { return self().leaveCompond   (node); }
+    AST::Statement  *leave(AST::Statement  *node) { return self().leaveStatement (node); }
+    AST::Break      *leave(AST::Break      *node) { return self().leaveBreak     (node); }
+    AST::Raise      *leave(AST::Raise      *node) { return self().leaveRaise     (node); }
+    AST::Return     *leave(AST::Return     *node) { return self().leaveReturn    (node); }
+    AST::Continue   *leave(AST::Continue   *node) { return self().leaveContinue  (node); }
+    AST::Name       *leave(AST::Name       *node) { return self().leaveName      (node); }
+    AST::Index      *leave(AST::Index      *node) { return self().leaveIndex     (node); }
+    AST::Invoke     *leave(AST::Invoke     *node) { return self().leaveInvoke    (node); }
+    AST::Attribute  *leave(AST::Attribute  *node) { return self().leaveAttribute (node); }
+    AST::Map        *leave(AST::Map        *node) { return self().leaveMap       (node); }
+    AST::List       *leave(AST::List       *node) { return self().leaveList      (node); }
+    AST::Tuple      *leave(AST::Tuple      *node) { return self().leaveTuple     (node); }
+    AST::Unit       *leave(AST::Unit       *node) { return self().leaveUnit      (node); }
+    AST::Pair       *leave(AST::Pair       *node) { return self().leavePair      (node); }
+    AST::Constant   *leave(AST::Constant   *node) { return self().leaveConstant  (node); }
+    AST::Component  *leave(AST::Component  *node) { return self().leaveComponent (node); }
+    AST::Expression *leave(AST::Expression *node) { return self().leaveExpression(node); }
+
+/** Children of Language Structures **/
+
+private:
+    template <typename Function>
+    static void children(AST::If *node, const Function &fn)
+    {
+        fn(&node->expr);
+        fn(&node->positive);
+        fn(&node->negative);
+    }
+
+    template <typename Function>
+    static void children(AST::For *node, const Function &fn)
+    {
+        fn(&node->seq);
+        fn(&node->expr);
+        fn(&node->body);
+    }
+
+    template <typename Function>
+    static void children(AST::While *node, const Function &fn)
+    {
+        fn(&node->expr);
+        fn(&node->body);
+    }
+
+    template <typename Function>
+    static void children(AST::Define *node, const Function &fn)
+    {
+        fn(&node->name);
+        for (auto &arg : node->args) fn(&arg);
+        fn(&node->body);
+    }
+
+    template <typename Function>
+    static void children(AST::Import *node, const Function &fn)
+    {
+        for (auto &name : node->names)
+            fn(&name);
+    }
+
+    template <typename Function>
+    static void children(AST::Try *node, const Function &fn)
+    {
+        fn(&node->body);
+        for (auto &except : node->excepts) fn(&except);
+        fn(&node->finally);
+    }
+
+    template <typename Function>
+    static void children(AST::Except *node, const Function &fn)
+    {
+        for (auto &except : node->exceptions)
+            for (auto &name : except)
+                fn(&name);
+
+        fn(&node->target);
+        fn(&node->body);
+    }
+
+/** Children of Statements **/
+
+private:
+    template <typename Function>
+    static void children(AST::Assign *node, const Function &fn)
+    {
+        fn(&node->target);
+        fn(&node->tuple);
+    }
+
+    template <typename Function>
+    static void children(AST::Delete *node, const Function &fn)
+    {
+        fn(&node->target);
+    }
+
+    template <typename Function>
+    static void children(AST::Inplace *node, const Function &fn)
+    {
+        fn(&node->target);
+        fn(&node->expression);
+    }
+
+    template <typename Function>
+    static void children(AST::Sequence *node, const Function &fn)
+    {
+        for (auto &item : node->items)
+        {
+            switch (item.type)
+            {
+                case AST::Sequence::Type::SequenceSequence  : fn(&item.sequence); break;
+                case AST::Sequence::Type::SequenceComponent : fn(&item.component); break;
+            }
+        }
+    }
+
+    template <typename Function>
+    static void children(AST::Compond *node, const Function &fn)
+    {
+        for (auto &statement : node->statements)
+            fn(&statement);
+    }
+
+    template <typename Function>
+    static void children(AST::Statement *node, const Function &fn)
+    {
+        switch (node->type)
+        {
+            case AST::Statement::Type::StatementIf        : fn(&node->ifStatement); break;
+            case AST::Statement::Type::StatementFor       : fn(&node->forStatement); break;
+            case AST::Statement::Type::StatementTry       : fn(&node->tryStatement); break;
+            case AST::Statement::Type::StatementWhile     : fn(&node->whileStatement); break;
+            case AST::Statement::Type::StatementCompond   : fn(&node->compondStatement); break;
+
+            case AST::Statement::Type::StatementDefine    : fn(&node->defineStatement); break;
+            case AST::Statement::Type::StatementDelete    : fn(&node->deleteStatement); break;
+            case AST::Statement::Type::StatementImport    : fn(&node->importStatement); break;
+
+            case AST::Statement::Type::StatementBreak     : fn(&node->breakStatement); break;
+            case AST::Statement::Type::StatementRaise     : fn(&node->raiseStatement); break;
+            case AST::Statement::Type::StatementReturn    : fn(&node->returnStatement); break;
+            case AST::Statement::Type::StatementContinue  : fn(&node->continueStatement); break;
+
+            case AST::Statement::Type::StatementAssign    : fn(&node->assignStatement); break;
+            case AST::Statement::Type::StatementInplace   : fn(&node->inplaceStatement); break;
+            case AST::Statement::Type::StatementComponent : fn(&node->componentStatement); break;
+        }
+    }
+
+/** Children of Control Flows **/
+
+private:
+    template <typename Function> static void children(AST::Break    *, const Function &) {}
+    template <typename Function> static void children(AST::Continue *, const Function &) {}
+
+private:
+    template <typename Function>
+    static void children(AST::Raise *node, const Function &fn)
+    {
+        fn(&node->expr);
+    }
+
+    template <typename Function>
+    static void children(AST::Return *node, const Function &fn)
+    {
+        fn(&node->tuple);
+    }
+
+/** Children of Expression Components **/
+
+private:
+    template <typename Function> static void children(AST::Name *, const Function &) {}
+
+private:
+    template <typename Function>
+    static void children(AST::Index *node, const Function &fn)
+    {
+        fn(&node->index);
+    }
+
+    template <typename Function>
+    static void children(AST::Invoke *node, const Function &fn)
+    {
+        for (auto &arg : node->args)
+            fn(&arg);
+    }
+
+    template <typename Function>
+    static void children(AST::Attribute *node, const Function &fn)
+    {
+        fn(&node->attribute);
+    }
+
+/** Children of Expressions **/
+
+private:
+    template <typename Function>
+    static void children(AST::Map *node, const Function &fn)
+    {
+        for (auto &item : node->items)
+        {
+            fn(&item.first);
+            fn(&item.second);
+        }
+    }
+
+    template <typename Function>
+    static void children(AST::List *node, const Function &fn)
+    {
+        for (auto &item : node->items)
+            fn(&item);
+    }
+
+    template <typename Function>
+    static void children(AST::Tuple *node, const Function &fn)
+    {
+        for (auto &item : node->items)
+            fn(&item);
+    }
+
+    template <typename Function>
+    static void children(AST::Unit *node, const Function &fn)
+    {
+        switch (node->type)
+        {
+            case AST::Unit::Type::UnitMap        : fn(&node->map); break;
+            case AST::Unit::Type::UnitList       : fn(&node->list); break;
+            case AST::Unit::Type::UnitTuple      : fn(&node->tuple); break;
+            case AST::Unit::Type::UnitLambda     : fn(&node->lambda); break;
+            case AST::Unit::Type::UnitExpression : fn(&node->expression); break;
+        }
+    }
+
+    template <typename Function>
+    static void children(AST::Pair *node, const Function &fn)
+    {
+        fn(&node->name);
+        fn(&node->value);
+    }
+
+    template <typename Function>
+    static void children(AST::Constant *, const Function &) {}
+
+    template <typename Function>
+    static void children(AST::Component *node, const Function &fn)
+    {
+        switch (node->type)
+        {
+            case AST::Component::Type::ComponentName     : fn(&node->name); break;
+            case AST::Component::Type::ComponentPair     : fn(&node->pair); break;
+            case AST::Component::Type::ComponentUnit     : fn(&node->unit); break;
+            case AST::Component::Type::ComponentConstant : fn(&node->constant); break;
+        }
+
+        for (auto &mod : node->modifiers)
+        {
+            switch (mod.type)
+            {
+                case AST::Component::ModType::ModifierIndex     : fn(&mod.index); break;
+                case AST::Component::ModType::ModifierInvoke    : fn(&mod.invoke); break;
+                case AST::Component::ModType::ModifierAttribute : fn(&mod.attribute); break;
+            }
+        }
+    }
+
+    template <typename Function>
+    static void children(AST::Expression *node, const Function &fn)
+    {
+        switch (node->first.type)
+        {
+            case AST::Expression::Type::TermComponent  : fn(&node->first.component); break;
+            case AST::Expression::Type::TermExpression : fn(&node->first.expression); break;
+        }
+
+        for (auto &term : node->remains)
+        {
+            switch (term.second.type)
+            {
+                case AST::Expression::Type::TermComponent  : fn(&term.second.component); break;
+                case AST::Expression::Type::TermExpression : fn(&term.second.expression); break;
+            }
+        }
+    }
+
+/** Iterative Walking **/
+
+private:
+    template <typename NodeType>
+    void step(NodeType **slot, bool leaving)
+    {
+        /* children are all done, replace the node in it's parent */
+        if (leaving)
+        {
+            *slot = leave(*slot);
+            return;
+        }
+
+        /* leave the node after all of it's children, which are pushed above it */
+        size_t top = _stack.size() + 1;
+        _stack.push_back(Entry { kind(slot), true, slot });
+
+        if (!visit(*slot))
+            return;
+
+        children(*slot, [this](auto **child)
+        {
+            if (*child != nullptr)
+                _stack.push_back(Entry { kind(child), false, child });
+        });
+
+        /* the last child pushed is the first popped, so reverse them to keep the source order */
+        std::reverse(_stack.begin() + top, _stack.end());
+    }
+
+    void step(const Entry &entry)
+    {
+        switch (entry.kind)
+        {
+            case Kind::If         : step(static_cast<AST::If         **>(entry.slot), entry.leave); break;
+            case Kind::For        : step(static_cast<AST::For        **>(entry.slot), entry.leave); break;
+            case Kind::While      : step(static_cast<AST::While      **>(entry.slot), entry.leave); break;
+            case Kind::Define     : step(static_cast<AST::Define     **>(entry.slot), entry.leave); break;
+            case Kind::Import     : step(static_cast<AST::Import     **>(entry.slot), entry.leave); break;
+
+            case Kind::Try        : step(static_cast<AST::Try        **>(entry.slot), entry.leave); break;
+            case Kind::Except     : step(static_cast<AST::Except     **>(entry.slot), entry.leave); break;
+
+            case Kind::Assign     : step(static_cast<AST::Assign     **>(entry.slot), entry.leave); break;
+            case Kind::Delete     : step(static_cast<AST::Delete     **>(entry.slot), entry.leave); break;
+            case Kind::Inplace    : step(static_cast<AST::Inplace    **>(entry.slot), entry.leave); break;
+            case Kind::Sequence   : step(static_cast<AST::Sequence   **>(entry.slot), entry.leave); break;
+
+            case Kind::Compond    : step(static_cast<AST::Compond    **>(entry.slot), entry.leave); break;
+            case Kind::Statement  : step(static_cast<AST::Statement  **>(entry.slot), entry.leave); break;
+
+            case Kind::Break      : step(static_cast<AST::Break      **>(entry.slot), entry.leave); break;
+            case Kind::Raise      : step(static_cast<AST::Raise      **>(entry.slot), entry.leave); break;
+            case Kind::Return     : step(static_cast<AST::Return     **>(entry.slot), entry.leave); break;
+            case Kind::Continue   : step(static_cast<AST::Continue   **>(entry.slot), entry.leave); break;
+
+            case Kind::Name       : step(static_cast<AST::Name       **>(entry.slot), entry.leave); break;
+            case Kind::Index      : step(static_cast<AST::Index      **>(entry.slot), entry.leave); break;
+            case Kind::Invoke     : step(static_cast<AST::Invoke     **>(entry.slot), entry.leave); break;
+            case Kind::Attribute  : step(static_cast<AST::Attribute  **>(entry.slot), entry.leave); break;
+
+            case Kind::Map        : step(static_cast<AST::Map        **>(entry.slot), entry.leave); break;
+            case Kind::List       : step(static_cast<AST::List       **>(entry.slot), entry.leave); break;
+            case Kind::Tuple      : step(static_cast<AST::Tuple      **>(entry.slot), entry.leave); break;
+
+            case Kind::Unit       : step(static_cast<AST::Unit       **>(entry.slot), entry.leave); break;
+            case Kind::Pair       : step(static_cast<AST::Pair       **>(entry.slot), entry.leave); break;
+            case Kind::Constant   : step(static_cast<AST::Constant   **>(entry.slot), entry.leave); break;
+            case Kind::Component  : step(static_cast<AST::Component  **>(entry.slot), entry.leave); break;
+            case Kind::Expression : step(static_cast<AST::Expression **>(entry.slot), entry.leave); break;
+        }
+    }
+
+/** Traversals **/
+
+public:
+    /* both return the replacement of `node`, trees from the parser are rooted at `AST::Compond` */
+    template <typename NodeType>
+    NodeType *traverse(NodeType *node)
+    {
+        if (visit(node))
+        {
+            children(node, [this](auto **child)
+            {
+                if (*child != nullptr)
+                    *child = this->traverse(*child);
+            });
+        }
+
+        return leave(node);
+    }
+
+    template <typename NodeType>
+    NodeType *walk(NodeType *node)
+    {
+        /* the stack is kept across walks, so it's only grown once */
+        _stack.clear();
+        _stack.push_back(Entry { kind(&node), false, &node });
+
+        while (!_stack.empty())
+        {
+            Entry entry = _stack.back();
+            _stack.pop_back();
+            step(entry);
+        }
+
+        return node;
+    }
+
+};
+}
+}
+
+#endif /* COMMANDSCRIPT_COMPILER_VISITOR_H */
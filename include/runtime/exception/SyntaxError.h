@@ -3,6 +3,7 @@
 
 #include <string>
 #include <exception>
+#include <stddef.h>
 
 namespace CommandScript
 {
@@ -12,16 +13,26 @@ class SyntaxError : public std::exception
 {
     int _row;
     int _col;
+    size_t _offset;
     std::string _message;
 
 public:
-    explicit SyntaxError(int row, int col, const std::string &message) : _row(row), _col(col), _message(message) {}
+    explicit SyntaxError(int row, int col, const std::string &message) : _row(row), _col(col), _offset(0), _message(message) {}
+
+public:
+    /* tokens only know their offset, row and column are resolved later by whoever owns the source */
+    explicit SyntaxError(size_t offset, const std::string &message) : _row(-1), _col(-1), _offset(offset), _message(message) {}
 
 public:
     int row(void) const { return _row; }
     int col(void) const { return _col; }
+    size_t offset(void) const { return _offset; }
     const std::string &message(void) const { return _message; }
 
+public:
+    bool isResolved(void) const { return _row >= 0; }
+    void resolve(int row, int col) { _row = row; _col = col; }
+
 public:
     const char *what() const noexcept override { return _message.c_str(); }
 
@@ -0,0 +1,166 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <new>
+#include <utility>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "NonMovable.h"
+#include "NonCopyable.h"
+
+/* bump allocator, objects are laid out in allocation order and released all at once */
+class Arena : public NonMovable, public NonCopyable
+{
+    struct Block
+    {
+        Block *prev;
+        size_t size;
+    };
+
+private:
+    struct Cleanup
+    {
+        void *object;
+        Cleanup *prev;
+        void (*destroy)(void *object);
+    };
+
+private:
+    char *_pos = nullptr;
+    char *_end = nullptr;
+    Block *_blocks = nullptr;
+    Cleanup *_cleanups = nullptr;
+
+private:
+    size_t _used = 0;
+    size_t _reserved = 0;
+
+public:
+    static constexpr size_t BlockSize = 64 * 1024;
+
+public:
+    ~Arena();
+    explicit Arena() {}
+
+public:
+    size_t used(void) const { return _used; }
+    size_t reserved(void) const { return _reserved; }
+
+private:
+    void *allocateSlow(size_t size, size_t align);
+
+public:
+    void *allocate(size_t size, size_t align)
+    {
+        char *ptr = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(_pos) + align - 1) & ~(uintptr_t)(align - 1));
+
+        /* fast path, fits in current block */
+        if (_pos && (ptr + size <= _end))
+        {
+            _pos = ptr + size;
+            _used += size;
+            return ptr;
+        }
+
+        return allocateSlow(size, align);
+    }
+
+public:
+    template <typename T, typename ... Args>
+    T *create(Args && ... args)
+    {
+        /* trivially destructible objects need no bookkeeping at all */
+        if (std::is_trivially_destructible<T>::value)
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args) ...);
+
+        /* otherwise keep a cleanup record in front of the object, destructors run in reverse order */
+        static constexpr size_t align = alignof(T) > alignof(Cleanup) ? alignof(T) : alignof(Cleanup);
+        static constexpr size_t offset = (sizeof(Cleanup) + alignof(T) - 1) & ~(alignof(T) - 1);
+
+        char *mem = static_cast<char *>(allocate(offset + sizeof(T), align));
+        T *result = new (mem + offset) T(std::forward<Args>(args) ...);
+        Cleanup *cleanup = reinterpret_cast<Cleanup *>(mem);
+
+        cleanup->prev = _cleanups;
+        cleanup->object = result;
+        cleanup->destroy = [](void *object){ static_cast<T *>(object)->~T(); };
+
+        _cleanups = cleanup;
+        return result;
+    }
+
+public:
+    /* a copy of `size` bytes at `data`, which lives as long as the arena, it's not NUL-terminated */
+    const char *copy(const char *data, size_t size)
+    {
+        char *result = static_cast<char *>(allocate(size, 1));
+        memcpy(result, data, size);
+        return result;
+    }
+};
+
+/* growable array with it's items in an arena, it's trivially destructible, so objects holding one need no cleanup
+ * records, storage outgrown is only released along with the arena, so it's meant for short lists built only once */
+template <typename T>
+class ArenaVector
+{
+    T *_data = nullptr;
+    uint32_t _size = 0;
+    uint32_t _capacity = 0;
+
+private:
+    static_assert(std::is_trivially_destructible<T>::value, "Items of `ArenaVector` must be trivially destructible");
+
+public:
+    bool empty(void) const { return _size == 0; }
+    size_t size(void) const { return _size; }
+
+public:
+    T *begin(void) { return _data; }
+    T *end(void) { return _data + _size; }
+    const T *begin(void) const { return _data; }
+    const T *end(void) const { return _data + _size; }
+
+public:
+    T &back(void) { return _data[_size - 1]; }
+    const T &back(void) const { return _data[_size - 1]; }
+
+public:
+    T &operator[](size_t index) { return _data[index]; }
+    const T &operator[](size_t index) const { return _data[index]; }
+
+public:
+    void reserve(Arena &arena, size_t count)
+    {
+        /* items are copied, the old ones need no destruction */
+        if (count <= _capacity)
+            return;
+
+        T *data = static_cast<T *>(arena.allocate(count * sizeof(T), alignof(T)));
+        for (uint32_t i = 0; i < _size; i++) new (data + i) T(_data[i]);
+
+        _data = data;
+        _capacity = static_cast<uint32_t>(count);
+    }
+
+public:
+    template <typename ... Args>
+    void emplace_back(Arena &arena, Args && ... args)
+    {
+        /* most lists have only a few items */
+        if (_size == _capacity)
+            reserve(arena, _capacity ? _capacity * 2 : 2);
+
+        new (_data + _size++) T(std::forward<Args>(args) ...);
+    }
+
+    void push_back(Arena &arena, const T &value)
+    {
+        emplace_back(arena, value);
+    }
+};
+
+#endif /* ARENA_H */
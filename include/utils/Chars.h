@@ -0,0 +1,116 @@
+#ifndef CHARS_H
+#define CHARS_H
+
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* byte scanning helpers, works in 32-byte strides with AVX2, 16-byte strides with SSE2,
+ * and falls back to plain loops otherwise (as well as for the tail shorter than a stride) */
+namespace Chars
+{
+static inline bool isBlank(char ch) { return (ch == ' ') || (ch == '\t') || (ch == '\v') || (ch == '\f'); }
+static inline bool isAny(char ch, char a, char b, char c, char d, char e) { return (ch == a) || (ch == b) || (ch == c) || (ch == d) || (ch == e); }
+
+/* first character in [begin, end) which is not a blank (space, tab, vertical tab or form feed) */
+static inline const char *skipBlanks(const char *begin, const char *end)
+{
+#if defined(__AVX2__)
+    const __m256i sp = _mm256_set1_epi8(' ');
+    const __m256i ht = _mm256_set1_epi8('\t');
+    const __m256i vt = _mm256_set1_epi8('\v');
+    const __m256i ff = _mm256_set1_epi8('\f');
+
+    while (end - begin >= 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+        __m256i a = _mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, ht));
+        __m256i b = _mm256_or_si256(_mm256_cmpeq_epi8(v, vt), _mm256_cmpeq_epi8(v, ff));
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(a, b)));
+
+        if (mask)
+            return begin + __builtin_ctz(mask);
+
+        begin += 32;
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i sp16 = _mm_set1_epi8(' ');
+    const __m128i ht16 = _mm_set1_epi8('\t');
+    const __m128i vt16 = _mm_set1_epi8('\v');
+    const __m128i ff16 = _mm_set1_epi8('\f');
+
+    while (end - begin >= 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        __m128i a = _mm_or_si128(_mm_cmpeq_epi8(v, sp16), _mm_cmpeq_epi8(v, ht16));
+        __m128i b = _mm_or_si128(_mm_cmpeq_epi8(v, vt16), _mm_cmpeq_epi8(v, ff16));
+        uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(a, b))) & 0xffff;
+
+        if (mask)
+            return begin + __builtin_ctz(mask);
+
+        begin += 16;
+    }
+#endif
+
+    while ((begin < end) && isBlank(*begin)) begin++;
+    return begin;
+}
+
+/* first character in [begin, end) which equals to any of `a` to `e`, or `end` if there is none */
+static inline const char *findAny(const char *begin, const char *end, char a, char b, char c, char d, char e)
+{
+#if defined(__AVX2__)
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    const __m256i vc = _mm256_set1_epi8(c);
+    const __m256i vd = _mm256_set1_epi8(d);
+    const __m256i ve = _mm256_set1_epi8(e);
+
+    while (end - begin >= 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+        __m256i x = _mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb));
+        __m256i y = _mm256_or_si256(_mm256_cmpeq_epi8(v, vc), _mm256_cmpeq_epi8(v, vd));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(x, y), _mm256_cmpeq_epi8(v, ve))));
+
+        if (mask)
+            return begin + __builtin_ctz(mask);
+
+        begin += 32;
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i va16 = _mm_set1_epi8(a);
+    const __m128i vb16 = _mm_set1_epi8(b);
+    const __m128i vc16 = _mm_set1_epi8(c);
+    const __m128i vd16 = _mm_set1_epi8(d);
+    const __m128i ve16 = _mm_set1_epi8(e);
+
+    while (end - begin >= 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        __m128i x = _mm_or_si128(_mm_cmpeq_epi8(v, va16), _mm_cmpeq_epi8(v, vb16));
+        __m128i y = _mm_or_si128(_mm_cmpeq_epi8(v, vc16), _mm_cmpeq_epi8(v, vd16));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(x, y), _mm_cmpeq_epi8(v, ve16))));
+
+        if (mask)
+            return begin + __builtin_ctz(mask);
+
+        begin += 16;
+    }
+#endif
+
+    while ((begin < end) && !isAny(*begin, a, b, c, d, e)) begin++;
+    return begin;
+}
+}
+
+#endif /* CHARS_H */
@@ -0,0 +1,27 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <stddef.h>
+
+#include "NonMovable.h"
+#include "NonCopyable.h"
+
+/* read-only memory mapping of a whole file, pages are loaded by the kernel on demand
+ * and shared with the page cache, so nothing is copied into the process */
+class MappedFile : public NonMovable, public NonCopyable
+{
+    size_t _size;
+    const char *_data;
+
+public:
+    ~MappedFile();
+    explicit MappedFile(const std::string &path);
+
+public:
+    size_t size(void) const { return _size; }
+    const char *data(void) const { return _data; }
+
+};
+
+#endif /* MAPPEDFILE_H */
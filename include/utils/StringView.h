@@ -0,0 +1,56 @@
+#ifndef STRINGVIEW_H
+#define STRINGVIEW_H
+
+#include <string>
+#include <string.h>
+#include <stdint.h>
+
+class StringView
+{
+    const char *_data;
+    size_t _size;
+
+public:
+    StringView() : _data(""), _size(0) {}
+    StringView(const char *data) : _data(data), _size(strlen(data)) {}
+    StringView(const char *data, size_t size) : _data(data), _size(size) {}
+    StringView(const std::string &str) : _data(str.data()), _size(str.size()) {}
+
+public:
+    bool empty(void) const { return _size == 0; }
+    size_t size(void) const { return _size; }
+    const char *data(void) const { return _data; }
+
+public:
+    char operator[](size_t index) const { return _data[index]; }
+    std::string str(void) const { return std::string(_data, _size); }
+
+public:
+    bool operator==(const StringView &other) const { return (_size == other._size) && !memcmp(_data, other._data, _size); }
+    bool operator!=(const StringView &other) const { return (_size != other._size) ||  memcmp(_data, other._data, _size); }
+
+};
+
+namespace std
+{
+template <>
+struct hash<StringView>
+{
+    size_t operator()(const StringView &value) const
+    {
+        /* FNV-1a, good enough for short identifiers */
+        uint64_t hash = 0xcbf29ce484222325ull;
+        const char *data = value.data();
+
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 0x100000001b3ull;
+        }
+
+        return static_cast<size_t>(hash);
+    }
+};
+}
+
+#endif /* STRINGVIEW_H */
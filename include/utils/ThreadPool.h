@@ -0,0 +1,43 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <deque>
+#include <mutex>
+#include <future>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include "NonMovable.h"
+#include "NonCopyable.h"
+
+/* fixed set of worker threads, tasks are run in submission order by whichever worker is free */
+class ThreadPool : public NonMovable, public NonCopyable
+{
+    bool _stop;
+    std::mutex _mutex;
+    std::condition_variable _ready;
+
+private:
+    std::deque<std::function<void(void)>> _tasks;
+    std::vector<std::thread> _workers;
+
+public:
+    ~ThreadPool();
+    explicit ThreadPool() : ThreadPool(std::thread::hardware_concurrency()) {}
+    explicit ThreadPool(size_t count);
+
+public:
+    size_t size(void) const { return _workers.size(); }
+
+private:
+    void work(void);
+
+public:
+    /* the future becomes ready when `task` finishes, and rethrows whatever it has thrown */
+    std::future<void> submit(const std::function<void(void)> &task);
+
+};
+
+#endif /* THREADPOOL_H */
@@ -1,4 +1,5 @@
 #include "AST.h"
+#include "Dumper.h"
 
 namespace CommandScript
 {
@@ -6,351 +7,454 @@ namespace Compiler
 {
 namespace AST
 {
+std::string Node::toString(void) const
+{
+    std::string result;
+    Dumper(result).dump(this);
+    return result;
+}
+
 /** Language Structures **/
 
-std::string If::toString(size_t level) const
+void If::dump(Dumper &dumper) const
 {
-    std::string result = Strings::repeat("| ", level) + "If\n";
-
-    result += Strings::repeat("| ", level + 1);
-    result += "Condition\n";
-    result += expr->toString(level + 2);
-    result += Strings::repeat("| ", level + 1);
-    result += "Positive\n";
-    result += positive->toString(level + 2);
+    dumper.begin("If", "If");
+    dumper.field("condition", "Condition", expr);
+    dumper.field("positive", "Positive", positive);
 
     if (negative != nullptr)
-    {
-        result += Strings::repeat("| ", level + 1);
-        result += "Negative\n";
-        result += negative->toString(level + 2);
-    }
+        dumper.field("negative", "Negative", negative);
 
-    return result;
+    dumper.end();
 }
 
-std::string For::toString(size_t level) const
+void For::dump(Dumper &dumper) const
 {
-    return Strings::repeat("| ", level    ) + "For\n"
-         + Strings::repeat("| ", level + 1) + "Seq\n"  + seq->toString(level + 2)
-         + Strings::repeat("| ", level + 1) + "Expr\n" + expr->toString(level + 2)
-         + Strings::repeat("| ", level + 1) + "Body\n" + body->toString(level + 2);
+    dumper.begin("For", "For");
+    dumper.field("seq", "Seq", seq);
+    dumper.field("expr", "Expr", expr);
+    dumper.field("body", "Body", body);
+    dumper.end();
 }
 
-std::string While::toString(size_t level) const
+void While::dump(Dumper &dumper) const
 {
-    return Strings::repeat("| ", level    ) + "While\n"
-         + Strings::repeat("| ", level + 1) + "Expr\n" + expr->toString(level + 2)
-         + Strings::repeat("| ", level + 1) + "Body\n" + body->toString(level + 2);
+    dumper.begin("While", "While");
+    dumper.field("expr", "Expr", expr);
+    dumper.field("body", "Body", body);
+    dumper.end();
 }
 
-std::string Define::toString(size_t level) const
+void Define::dump(Dumper &dumper) const
 {
-    std::string result = Strings::repeat("| ", level) + ((name == nullptr)
-        ? "Define Lambda\n"
-        : Strings::format("Define Function %s\n", name->name));
+    if (name == nullptr)
+    {
+        dumper.begin("Define", "Define Lambda");
+    }
+    else
+    {
+        dumper.begin("Define", "Define Function %s", name->symbol->name.str());
+        dumper.string("name", name->symbol->name);
+    }
 
-    result += Strings::repeat("| ", level + 1);
-    result += Strings::format("Args %d\n", args.size());
+    dumper.section("args", "Args %d", args.size());
+    dumper.list();
 
     for (const auto &arg : args)
-        result += arg->toString(level + 2);
+        dumper.node(arg);
 
-    result += Strings::repeat("| ", level + 1);
-    result += "Body\n";
-    result += body->toString(level + 2);
-    return result;
+    dumper.endList();
+    dumper.endSection();
+
+    /* deferred bodies can only be parsed by the parser which deferred them */
+    if (body == nullptr)
+    {
+        dumper.label("Deferred Body %d-%d", bodyBegin, bodyEnd);
+        dumper.integer("bodyBegin", static_cast<int64_t>(bodyBegin));
+        dumper.integer("bodyEnd", static_cast<int64_t>(bodyEnd));
+        dumper.end();
+        return;
+    }
+
+    dumper.field("body", "Body", body);
+    dumper.end();
 }
 
-std::string Import::toString(size_t level) const
+void Import::dump(Dumper &dumper) const
 {
-    std::string result = Strings::repeat("| ", level) + "Import\n";
-    std::for_each(names.begin(), names.end(), [&](const auto &x){ result += x->toString(level + 1); });
-    return result;
+    dumper.begin("Import", "Import");
+    dumper.items("names", names);
+    dumper.end();
 }
 
-std::string Try::toString(size_t level) const
+void Try::dump(Dumper &dumper) const
 {
-    std::string result = Strings::repeat("| ", level) + (finally == nullptr
-        ? Strings::format("Try %d%s\n", excepts.size(), haveWildcard ? " + Wildcard" : "")
-        : Strings::format("Try-Finally %d%s\n", excepts.size(), haveWildcard ? " + Wildcard" : ""));
+    if (finally == nullptr)
+        dumper.begin("Try", "Try %d%s", excepts.size(), haveWildcard ? " + Wildcard" : "");
+    else
+        dumper.begin("Try", "Try-Finally %d%s", excepts.size(), haveWildcard ? " + Wildcard" : "");
 
-    for (const auto &except : excepts)
-        result += except->toString(level + 1);
+    dumper.boolean("wildcard", haveWildcard);
+    dumper.field("body", "Body", body);
+    dumper.items("excepts", excepts);
 
     if (finally != nullptr)
-    {
-        result += Strings::repeat("| ", level + 1);
-        result += "Finally\n";
-        result += finally->toString(level + 2);
-    }
+        dumper.field("finally", "Finally", finally);
 
-    return result;
+    dumper.end();
 }
 
-std::string Except::toString(size_t level) const
+void Except::dump(Dumper &dumper) const
 {
-    std::string result = Strings::repeat("| ", level)
-        + Strings::format(isWildcard ? "Except Wildcard %d\n" : "Except %d\n", exceptions.size());
+    dumper.begin("Except", isWildcard ? "Except Wildcard %d" : "Except %d", exceptions.size());
+    dumper.boolean("wildcard", isWildcard);
 
     if (target != nullptr)
-    {
-        result += Strings::repeat("| ", level + 1);
-        result += "Target\n";
-        result += target->toString(level + 2);
-    }
+        dumper.field("target", "Target", target);
+
+    dumper.key("exceptions");
+    dumper.list();
 
     for (const auto &except : exceptions)
     {
-        result += Strings::repeat("| ", level + 1);
-        result += "Exception Item\n";
+        dumper.section(nullptr, "Exception Item");
+        dumper.list();
 
         for (const auto &name : except)
-            result += name->toString(level + 2);
+            dumper.node(name);
+
+        dumper.endList();
+        dumper.endSection();
     }
 
-    result += Strings::repeat("| ", level + 1);
-    result += "Body\n";
-    result += body->toString(level + 2);
-    return result;
+    dumper.endList();
+    dumper.field("body", "Body", body);
+    dumper.end();
 }
 
 /** Statements **/
 
-std::string Assign::toString(size_t level) const
+void Assign::dump(Dumper &dumper) const
 {
-    return Strings::repeat("| ", level) + "Assign\n"
-         + Strings::repeat("| ", level + 1) + "Target\n" + target->toString(level + 2)
-         + Strings::repeat("| ", level + 1) + (isSeq ? "Sequence\n" : "Expression\n") + tuple->toString(level + 2);
+    dumper.begin("Assign", "Assign");
+    dumper.boolean("seq", isSeq);
+    dumper.field("target", "Target", target);
+    dumper.field("value", isSeq ? "Sequence" : "Expression", tuple);
+    dumper.end();
 }
 
-std::string Delete::toString(size_t level) const
+void Delete::dump(Dumper &dumper) const
 {
-    return Strings::repeat("| ", level) + "Delete\n"
-         + target->toString(level + 1);
+    dumper.begin("Delete", "Delete");
+    dumper.field("target", target);
+    dumper.end();
 }
 
-std::string Inplace::toString(size_t level) const
+void Inplace::dump(Dumper &dumper) const
 {
-    return Strings::repeat("| ", level) + Strings::format("Inplace %s\n", Token::operatorName(op))
-         + Strings::repeat("| ", level + 1) + "Target\n" + target->toString(level + 2)
-         + Strings::repeat("| ", level + 1) + "Expression\n" + expression->toString(level + 2);
+    dumper.begin("Inplace", "Inplace %s", Token::operatorName(op));
+    dumper.string("op", Token::operatorName(op));
+    dumper.field("target", "Target", target);
+    dumper.field("expression", "Expression", expression);
+    dumper.end();
 }
 
-std::string Sequence::toString(size_t level) const
+void Sequence::dump(Dumper &dumper) const
 {
-    std::string result = Strings::repeat("| ", level) + Strings::format("Sequence %d\n", items.size());
+    dumper.begin("Sequence", "Sequence %d", items.size());
+    dumper.boolean("seq", isSeq);
 
     if (!isSeq)
     {
-        result += Strings::repeat("| ", level + 1) + "Simple\n";
-        result += items[0].component->toString(level + 2);
+        dumper.section("items", "Simple");
+        dumper.list();
+        dumper.node(items[0].component);
+        dumper.endList();
+        dumper.endSection();
     }
     else
     {
+        dumper.key("items");
+        dumper.list();
+
         for (const auto &item : items)
         {
             switch (item.type)
             {
-                case Type::SequenceSequence  : result += item.sequence->toString(level + 1); break;
-                case Type::SequenceComponent : result += item.component->toString(level + 1); break;
+                case Type::SequenceSequence  : dumper.node(item.sequence); break;
+                case Type::SequenceComponent : dumper.node(item.component); break;
             }
         }
+
+        dumper.endList();
     }
 
-    return result;
+    dumper.end();
 }
 
-std::string Compond::toString(size_t level) const
+void Compond::dump(Dumper &dumper) const
 {
-    std::string result = Strings::repeat("| ", level) + Strings::format("Compond Statement %d\n", statements.size());
-    std::for_each(statements.begin(), statements.end(), [&](const auto &x){ result += x->toString(level + 1); });
-    return result;
+    dumper.begin("Compond", "Compond Statement %d", statements.size());
+    dumper.items("statements", statements);
+    dumper.end();
 }
 
-std::string Statement::toString(size_t level) const
+void Statement::dump(Dumper &dumper) const
 {
+    /* statements are transparent, only the actual ones are shown */
     switch (type)
     {
-        case Type::StatementIf        : return ifStatement->toString(level);
-        case Type::StatementFor       : return forStatement->toString(level);
-        case Type::StatementTry       : return tryStatement->toString(level);
-        case Type::StatementWhile     : return whileStatement->toString(level);
-        case Type::StatementCompond   : return compondStatement->toString(level);
-
-        case Type::StatementDefine    : return defineStatement->toString(level);
-        case Type::StatementDelete    : return deleteStatement->toString(level);
-        case Type::StatementImport    : return importStatement->toString(level);
-
-        case Type::StatementBreak     : return breakStatement->toString(level);
-        case Type::StatementRaise     : return raiseStatement->toString(level);
-        case Type::StatementReturn    : return returnStatement->toString(level);
-        case Type::StatementContinue  : return continueStatement->toString(level);
-
-        case Type::StatementAssign    : return assignStatement->toString(level);
-        case Type::StatementInplace   : return inplaceStatement->toString(level);
-        case Type::StatementComponent : return componentStatement->toString(level);
+        case Type::StatementIf        : dumper.node(ifStatement); break;
+        case Type::StatementFor       : dumper.node(forStatement); break;
+        case Type::StatementTry       : dumper.node(tryStatement); break;
+        case Type::StatementWhile     : dumper.node(whileStatement); break;
+        case Type::StatementCompond   : dumper.node(compondStatement); break;
+
+        case Type::StatementDefine    : dumper.node(defineStatement); break;
+        case Type::StatementDelete    : dumper.node(deleteStatement); break;
+        case Type::StatementImport    : dumper.node(importStatement); break;
+
+        case Type::StatementBreak     : dumper.node(breakStatement); break;
+        case Type::StatementRaise     : dumper.node(raiseStatement); break;
+        case Type::StatementReturn    : dumper.node(returnStatement); break;
+        case Type::StatementContinue  : dumper.node(continueStatement); break;
+
+        case Type::StatementAssign    : dumper.node(assignStatement); break;
+        case Type::StatementInplace   : dumper.node(inplaceStatement); break;
+        case Type::StatementComponent : dumper.node(componentStatement); break;
     }
 }
 
 /** Control Flows **/
 
-std::string Raise::toString(size_t level) const
+void Break::dump(Dumper &dumper) const
 {
-    return Strings::repeat("| ", level) + "Raise\n"
-         + expr->toString(level + 1);
+    dumper.begin("Break", "Break");
+    dumper.end();
 }
 
-std::string Return::toString(size_t level) const
+void Raise::dump(Dumper &dumper) const
+{
+    dumper.begin("Raise", "Raise");
+    dumper.field("expr", expr);
+    dumper.end();
+}
+
+void Return::dump(Dumper &dumper) const
 {
     if (isSeq)
-        return Strings::repeat("| ", level) + "Return Seq\n" + tuple->toString(level + 1);
+    {
+        dumper.begin("Return", "Return Seq");
+        dumper.boolean("seq", true);
+        dumper.field("value", tuple);
+    }
     else
-        return Strings::repeat("| ", level) + "Return Simple\n" + tuple->items[0]->toString(level + 1);
+    {
+        dumper.begin("Return", "Return Simple");
+        dumper.boolean("seq", false);
+        dumper.field("value", tuple->items[0]);
+    }
+
+    dumper.end();
+}
+
+void Continue::dump(Dumper &dumper) const
+{
+    dumper.begin("Continue", "Continue");
+    dumper.end();
 }
 
 /** Expression Components **/
 
-std::string Name::toString(size_t level) const
+void Name::dump(Dumper &dumper) const
 {
-    return Strings::repeat("| ", level)
-         + Strings::format("Name %s\n", name);
+    dumper.begin("Name", "Name %s", symbol->name.str());
+    dumper.string("name", symbol->name);
+    dumper.end();
 }
 
-std::string Index::toString(size_t level) const
+void Index::dump(Dumper &dumper) const
 {
-    return Strings::repeat("| ", level) + "Index\n"
-         + index->toString(level + 1);
+    dumper.begin("Index", "Index");
+    dumper.field("index", index);
+    dumper.end();
 }
 
-std::string Invoke::toString(size_t level) const
+void Invoke::dump(Dumper &dumper) const
 {
-    std::string result = Strings::repeat("| ", level) + Strings::format("Invoke %d\n", args.size());
-    std::for_each(args.begin(), args.end(), [&](const auto &x){ result += x->toString(level + 1); });
-    return result;
+    dumper.begin("Invoke", "Invoke %d", args.size());
+    dumper.items("args", args);
+    dumper.end();
 }
 
-std::string Attribute::toString(size_t level) const
+void Attribute::dump(Dumper &dumper) const
 {
-    return Strings::repeat("| ", level) + "Attribute\n"
-         + attribute->toString(level + 1);
+    dumper.begin("Attribute", "Attribute");
+    dumper.field("attribute", attribute);
+    dumper.end();
 }
 
 /** Expressions **/
 
-std::string Map::toString(size_t level) const
+void Map::dump(Dumper &dumper) const
 {
-    std::string result = Strings::repeat("| ", level) + Strings::format("Map %d\n", items.size());
+    dumper.begin("Map", "Map %d", items.size());
+    dumper.key("items");
+    dumper.list();
 
+    /* pairs are lists of two in structured formats */
     for (const auto &item : items)
     {
-        result += Strings::repeat("| ", level + 1);
-        result += "Key\n";
-        result += item.first->toString(level + 2);
-        result += Strings::repeat("| ", level + 1);
-        result += "Value\n";
-        result += item.second->toString(level + 2);
+        dumper.list();
+        dumper.field(nullptr, "Key", item.first);
+        dumper.field(nullptr, "Value", item.second);
+        dumper.endList();
     }
 
-    return result;
+    dumper.endList();
+    dumper.end();
 }
 
-std::string List::toString(size_t level) const
+void List::dump(Dumper &dumper) const
 {
-    std::string result = Strings::repeat("| ", level) + Strings::format("List %d\n", items.size());
-    std::for_each(items.begin(), items.end(), [&](const auto &x){ result += x->toString(level + 1); });
-    return result;
+    dumper.begin("List", "List %d", items.size());
+    dumper.items("items", items);
+    dumper.end();
 }
 
-std::string Tuple::toString(size_t level) const
+void Tuple::dump(Dumper &dumper) const
 {
-    std::string result = Strings::repeat("| ", level) + Strings::format("Tuple %d\n", items.size());
-    std::for_each(items.begin(), items.end(), [&](const auto &x){ result += x->toString(level + 1); });
-    return result;
+    dumper.begin("Tuple", "Tuple %d", items.size());
+    dumper.items("items", items);
+    dumper.end();
 }
 
-std::string Unit::toString(size_t level) const
+void Unit::dump(Dumper &dumper) const
 {
     switch (type)
     {
-        case Type::UnitMap        : return Strings::repeat("| ", level) + "Map\n" + map->toString(level + 1);
-        case Type::UnitList       : return Strings::repeat("| ", level) + "List\n" + list->toString(level + 1);
-        case Type::UnitTuple      : return Strings::repeat("| ", level) + "Tuple\n" + tuple->toString(level + 1);
-        case Type::UnitLambda     : return Strings::repeat("| ", level) + "Lambda\n" + lambda->toString(level + 1);
-        case Type::UnitExpression : return Strings::repeat("| ", level) + "Expression\n" + expression->toString(level + 1);
+        case Type::UnitMap        : dumper.begin("Unit", "Map"); dumper.field("value", map); break;
+        case Type::UnitList       : dumper.begin("Unit", "List"); dumper.field("value", list); break;
+        case Type::UnitTuple      : dumper.begin("Unit", "Tuple"); dumper.field("value", tuple); break;
+        case Type::UnitLambda     : dumper.begin("Unit", "Lambda"); dumper.field("value", lambda); break;
+        case Type::UnitExpression : dumper.begin("Unit", "Expression"); dumper.field("value", expression); break;
     }
+
+    dumper.end();
 }
 
-std::string Pair::toString(size_t level) const
+void Pair::dump(Dumper &dumper) const
 {
-    return Strings::repeat("| ", level) + "Pair\n"
-         + name->toString(level + 1)
-         + value->toString(level + 1);
+    dumper.begin("Pair", "Pair");
+    dumper.field("name", name);
+    dumper.field("value", value);
+    dumper.end();
 }
 
-std::string Constant::toString(size_t level) const
+void Constant::dump(Dumper &dumper) const
 {
     switch (type)
     {
-        case Type::ConstantFloat   : return Strings::repeat("| ", level) + Strings::format("Float %f\n", floatValue);
-        case Type::ConstantString  : return Strings::repeat("| ", level) + Strings::format("String %s\n", Strings::repr(stringValue));
-        case Type::ConstantInteger : return Strings::repeat("| ", level) + Strings::format("Integer %ld\n", integerValue);
+        case Type::ConstantFloat:
+        {
+            dumper.begin("Constant", "Float %f", floatValue);
+            dumper.real("float", floatValue);
+            break;
+        }
+
+        case Type::ConstantInteger:
+        {
+            dumper.begin("Constant", "Integer %ld", integerValue);
+            dumper.integer("integer", integerValue);
+            break;
+        }
+
+        case Type::ConstantString:
+        {
+            /* don't quote it twice, structured formats escape strings by themselves */
+            if (dumper.format() != Dumper::Format::Tree)
+                dumper.begin("Constant", nullptr);
+            else
+                dumper.begin("Constant", "String %s", Strings::repr(stringValue.data(), stringValue.size()));
+
+            dumper.string("string", stringValue);
+            break;
+        }
     }
+
+    dumper.end();
 }
 
-std::string Component::toString(size_t level) const
+void Component::dump(Dumper &dumper) const
 {
-    std::string result;
+    dumper.begin("Component", "Component");
+    dumper.boolean("standalone", isStandalone);
 
     switch (type)
     {
-        case Type::ComponentName     : result += Strings::repeat("| ", level) + "Component\n" + name->toString(level + 1);       break;
-        case Type::ComponentPair     : result += Strings::repeat("| ", level) + "Component\n" + pair->toString(level + 1);       break;
-        case Type::ComponentUnit     : result += Strings::repeat("| ", level) + "Component\n" + unit->toString(level + 1);       break;
-        case Type::ComponentConstant : result += Strings::repeat("| ", level) + "Component\n" + constant->toString(level + 1);   break;
+        case Type::ComponentName     : dumper.field("value", name); break;
+        case Type::ComponentPair     : dumper.field("value", pair); break;
+        case Type::ComponentUnit     : dumper.field("value", unit); break;
+        case Type::ComponentConstant : dumper.field("value", constant); break;
     }
 
-    result += Strings::repeat("| ", level + 1);
-    result += Strings::format("Modifiers %d\n", modifiers.size());
+    dumper.section("modifiers", "Modifiers %d", modifiers.size());
+    dumper.list();
 
     for (const auto &mod : modifiers)
     {
         switch (mod.type)
         {
-            case ModType::ModifierIndex     : result += mod.index->toString(level + 2); break;
-            case ModType::ModifierInvoke    : result += mod.invoke->toString(level + 2); break;
-            case ModType::ModifierAttribute : result += mod.attribute->toString(level + 2); break;
+            case ModType::ModifierIndex     : dumper.node(mod.index); break;
+            case ModType::ModifierInvoke    : dumper.node(mod.invoke); break;
+            case ModType::ModifierAttribute : dumper.node(mod.attribute); break;
         }
     }
 
-    return result;
+    dumper.endList();
+    dumper.endSection();
+    dumper.end();
 }
 
-std::string Expression::toString(size_t level) const
+void Expression::dump(Dumper &dumper) const
 {
-    std::string result = Strings::repeat("| ", level) + (!isUnary
-        ? Strings::format("%s Chain %d\n", (isRelations ? "Relation" : "Expression"), remains.size() + 1)
-        : Strings::format("%s Operator %s\n", (isRelations ? "Relation" : "Expression"), Token::operatorName(op)));
+    if (!isUnary)
+        dumper.begin("Expression", "%s Chain %d", (isRelations ? "Relation" : "Expression"), remains.size() + 1);
+    else
+        dumper.begin("Expression", "%s Operator %s", (isRelations ? "Relation" : "Expression"), Token::operatorName(op));
+
+    dumper.boolean("relations", isRelations);
+
+    if (isUnary)
+        dumper.string("op", Token::operatorName(op));
 
     switch (first.type)
     {
-        case Type::TermComponent  : result += Strings::repeat("| ", level + 1) + "Term\n" + first.component->toString(level + 2); break;
-        case Type::TermExpression : result += Strings::repeat("| ", level + 1) + "Expr\n" + first.expression->toString(level + 2); break;
+        case Type::TermComponent  : dumper.field("first", "Term", first.component); break;
+        case Type::TermExpression : dumper.field("first", "Expr", first.expression); break;
     }
 
+    dumper.key("remains");
+    dumper.list();
+
+    /* operator and term pairs, as lists of two in structured formats */
     for (const auto &term : remains)
     {
-        result += Strings::repeat("| ", level + 1);
-        result += Strings::format("Operator %s\n", Token::operatorName(term.first));
+        dumper.list();
+        dumper.label("Operator %s", Token::operatorName(term.first));
+        dumper.string(Token::operatorName(term.first));
 
         switch (term.second.type)
         {
-            case Type::TermComponent  : result += Strings::repeat("| ", level + 1) + "Term\n" + term.second.component->toString(level + 2); break;
-            case Type::TermExpression : result += Strings::repeat("| ", level + 1) + "Expr\n" + term.second.expression->toString(level + 2); break;
+            case Type::TermComponent  : dumper.field(nullptr, "Term", term.second.component); break;
+            case Type::TermExpression : dumper.field(nullptr, "Expr", term.second.expression); break;
         }
+
+        dumper.endList();
     }
 
-    return result;
+    dumper.endList();
+    dumper.end();
 }
 }
 }
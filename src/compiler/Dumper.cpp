@@ -0,0 +1,367 @@
+#include <cmath>
+#include <ostream>
+#include <string.h>
+
+#include "AST.h"
+#include "Dumper.h"
+
+namespace CommandScript
+{
+namespace Compiler
+{
+/* files and streams are written in blocks of about this size */
+static const size_t FlushSize = 64 * 1024;
+
+void Dumper::dump(const AST::Node *node)
+{
+    _first = true;
+    _level = 0;
+    this->node(node);
+
+    if (_format != Format::Tree)
+        put('\n');
+
+    flush();
+}
+
+void Dumper::flush(void)
+{
+    if (_buffer != &_local)
+        return;
+
+    if (_file != nullptr)
+        fwrite(_local.data(), 1, _local.size(), _file);
+    else
+        _stream->write(_local.data(), _local.size());
+
+    _local.clear();
+}
+
+void Dumper::line(const char *text, size_t size)
+{
+    for (size_t i = 0; i < _level; i++)
+        put("| ", 2);
+
+    put(text, size);
+    put('\n');
+}
+
+/* length of the well-formed UTF-8 sequence at `data`, or 0 if there's none, overlong forms and surrogates are not */
+static size_t sequence(const unsigned char *data, size_t size)
+{
+    unsigned char lo = 0x80;
+    unsigned char hi = 0xbf;
+    size_t length;
+
+    /* the range of the second byte is narrower for a few leading bytes */
+    if ((data[0] >= 0xc2) && (data[0] <= 0xdf))
+        length = 2;
+    else if ((data[0] & 0xf0) == 0xe0)
+    {
+        length = 3;
+        if (data[0] == 0xe0) lo = 0xa0;
+        if (data[0] == 0xed) hi = 0x9f;
+    }
+    else if ((data[0] >= 0xf0) && (data[0] <= 0xf4))
+    {
+        length = 4;
+        if (data[0] == 0xf0) lo = 0x90;
+        if (data[0] == 0xf4) hi = 0x8f;
+    }
+    else
+        return 0;
+
+    if ((size < length) || (data[1] < lo) || (data[1] > hi))
+        return 0;
+
+    for (size_t i = 2; i < length; i++)
+        if ((data[i] & 0xc0) != 0x80)
+            return 0;
+
+    return length;
+}
+
+/* whether all of `data` is well-formed UTF-8 */
+static bool valid(const char *data, size_t size)
+{
+    size_t length;
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+
+    for (size_t i = 0; i < size; i += length)
+        if ((length = (p[i] < 0x80) ? 1 : sequence(p + i, size - i)) == 0)
+            return false;
+
+    return true;
+}
+
+void Dumper::quote(const char *data, size_t size)
+{
+    static const char HexTable[] = "0123456789abcdef";
+
+    /* JSON escapes, which S-expression readers understand as well, and the output is always valid UTF-8 */
+    put('"');
+
+    for (size_t i = 0; i < size; i++)
+    {
+        switch (data[i])
+        {
+            case '"'  : put("\\\"", 2); break;
+            case '\\' : put("\\\\", 2); break;
+            case '\b' : put("\\b", 2); break;
+            case '\f' : put("\\f", 2); break;
+            case '\n' : put("\\n", 2); break;
+            case '\r' : put("\\r", 2); break;
+            case '\t' : put("\\t", 2); break;
+
+            default:
+            {
+                unsigned char ch = static_cast<unsigned char>(data[i]);
+                size_t length = (ch < 0x80) ? 1 : sequence(reinterpret_cast<const unsigned char *>(data + i), size - i);
+
+                /* well-formed UTF-8 as-is */
+                if ((ch >= ' ') && (length != 0))
+                {
+                    put(data + i, length);
+                    i += length - 1;
+                    break;
+                }
+
+                /* bytes which are not UTF-8 as U+FFFD, `string()` dumps the actual bytes next to them */
+                if (length == 0)
+                {
+                    put("\xef\xbf\xbd", 3);
+                    break;
+                }
+
+                /* control chars as their code points */
+                put("\\u00", 4);
+                put(HexTable[(ch & 0xf0) >> 4]);
+                put(HexTable[(ch & 0x0f) >> 0]);
+                break;
+            }
+        }
+    }
+
+    put('"');
+}
+
+void Dumper::open(const char *type)
+{
+    separate();
+
+    if (_format == Format::SExpr)
+    {
+        put('(');
+        put(type, strlen(type));
+    }
+    else
+    {
+        put("{\"type\":", 8);
+        quote(type, strlen(type));
+    }
+}
+
+void Dumper::separate(void)
+{
+    /* right after an opening bracket or a key */
+    if (_first)
+    {
+        _first = false;
+        return;
+    }
+
+    put(_format == Format::SExpr ? ' ' : ',');
+}
+
+/** Nodes **/
+
+void Dumper::begin(const char *type, const char *title)
+{
+    if (_format != Format::Tree)
+    {
+        open(type);
+        return;
+    }
+
+    line(title, strlen(title));
+    _level++;
+}
+
+void Dumper::end(void)
+{
+    switch (_format)
+    {
+        case Format::Tree  : _level--; break;
+        case Format::Json  : put('}'); break;
+        case Format::SExpr : put(')'); break;
+    }
+
+    /* keeps memory bounded for large trees, strings are never flushed */
+    if (_buffer->size() >= FlushSize)
+        flush();
+}
+
+/** Children **/
+
+void Dumper::key(const char *name)
+{
+    /* keyless children, such as the ones in lists */
+    if (name == nullptr)
+        return;
+
+    switch (_format)
+    {
+        case Format::Tree:
+            return;
+
+        case Format::Json:
+        {
+            put(',');
+            quote(name, strlen(name));
+            put(':');
+            _first = true;
+            break;
+        }
+
+        case Format::SExpr:
+        {
+            put(" :", 2);
+            put(name, strlen(name));
+            break;
+        }
+    }
+}
+
+void Dumper::node(const AST::Node *node)
+{
+    if (node != nullptr)
+    {
+        node->dump(*this);
+        return;
+    }
+
+    switch (_format)
+    {
+        case Format::Tree  : break;
+        case Format::Json  : separate(); put("null", 4); break;
+        case Format::SExpr : separate(); put("nil", 3); break;
+    }
+}
+
+void Dumper::section(const char *key, const char *label)
+{
+    if (_format != Format::Tree)
+    {
+        this->key(key);
+        return;
+    }
+
+    line(label, strlen(label));
+    _level++;
+}
+
+void Dumper::endSection(void)
+{
+    if (_format == Format::Tree)
+        _level--;
+}
+
+void Dumper::label(const char *label)
+{
+    if (_format == Format::Tree)
+        line(label, strlen(label));
+}
+
+void Dumper::list(void)
+{
+    if (_format == Format::Tree)
+        return;
+
+    separate();
+    put(_format == Format::SExpr ? '(' : '[');
+    _first = true;
+}
+
+void Dumper::endList(void)
+{
+    if (_format == Format::Tree)
+        return;
+
+    _first = false;
+    put(_format == Format::SExpr ? ')' : ']');
+}
+
+/** Scalars **/
+
+void Dumper::boolean(bool value)
+{
+    if (_format == Format::Tree)
+        return;
+
+    separate();
+    value ? put("true", 4) : put("false", 5);
+}
+
+void Dumper::integer(int64_t value)
+{
+    char buf[32];
+
+    if (_format == Format::Tree)
+        return;
+
+    separate();
+    put(buf, snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(value)));
+}
+
+void Dumper::real(double value)
+{
+    char buf[32];
+
+    if (_format == Format::Tree)
+        return;
+
+    /* JSON has no infinities, nor NaNs */
+    separate();
+
+    if ((_format == Format::Json) && !std::isfinite(value))
+        put("null", 4);
+    else
+        put(buf, snprintf(buf, sizeof(buf), "%.17g", value));
+}
+
+void Dumper::string(StringView value)
+{
+    static const char HexTable[] = "0123456789abcdef";
+
+    if (_format == Format::Tree)
+        return;
+
+    /* the common case, a plain string */
+    if (valid(value.data(), value.size()))
+    {
+        separate();
+        quote(value.data(), value.size());
+        return;
+    }
+
+    /* replaced bytes can't be told apart from actual replacement chars, so the bytes themselves are kept as well */
+    open("Bytes");
+    key("text");
+    separate();
+    quote(value.data(), value.size());
+    key("bytes");
+    separate();
+    put('"');
+
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        unsigned char ch = static_cast<unsigned char>(value.data()[i]);
+        put(HexTable[(ch & 0xf0) >> 4]);
+        put(HexTable[(ch & 0x0f) >> 0]);
+    }
+
+    put('"');
+    end();
+}
+}
+}
@@ -0,0 +1,272 @@
+#include <algorithm>
+
+#include "Chars.h"
+#include "LineIndex.h"
+
+namespace CommandScript
+{
+namespace Compiler
+{
+LineIndex::LineIndex() :
+    _last(0),
+    _state(State::Normal),
+    _size(0),
+    _limit(0),
+    _dropped(0),
+    _to(SIZE_MAX),
+    _delta(0),
+    _shift(0),
+    _previous(nullptr)
+{
+    /* first row starts at the very beginning */
+    _lines.push_back(Line { 0, 0 });
+}
+
+LineIndex::LineIndex(const char *data, size_t size) : LineIndex()
+{
+    append(data, size);
+    finish();
+}
+
+LineIndex::LineIndex(const LineIndex &previous, const char *data, size_t size, size_t offset, size_t removed) : LineIndex()
+{
+    size_t pos = std::min(offset, previous._limit);
+    size_t end = offset + size - (previous._size - removed);
+
+    /* scanning can only start over right after a line break, or at the very beginning, rows which begin right
+     * after a line continuation are a part of the same line, the break must be before the edit, or it may be
+     * paired with the first edited char */
+    size_t from = 0;
+
+    while (pos-- > 0)
+    {
+        int row = previous.row(pos);
+        size_t origin = pos - previous.col(pos);
+
+        /* the first row, or a row which begins right after a line break, which is the first column of it */
+        if (row == 1)
+            break;
+
+        if (previous.row(origin) < row)
+        {
+            from = origin + 1;
+            break;
+        }
+
+        /* a row after a line continuation begins at it's origin, go on with the row before it */
+        pos = origin;
+    }
+
+    _delta = static_cast<ptrdiff_t>(size) - static_cast<ptrdiff_t>(previous._size);
+    _previous = &previous;
+
+    /* rows are counted from the one `from` begins */
+    _size = from;
+    _limit = from;
+    _dropped = from ? previous.row(from) - 1 : 0;
+    _lines.front() = Line { static_cast<uint32_t>(from), static_cast<uint32_t>(from ? from - 1 : 0) };
+
+    /* index the edited source a piece at a time, until a row after the edit begins right after a line break, which
+     * is exactly where a row of `previous` begins, both of them scan the same chars from there on */
+    for (size_t line = 1, step = 256; (_size < size) && (_state != State::Stopped); step *= 2)
+    {
+        append(data + _size, std::min(step, size - _size));
+
+        for (; line < _lines.size(); line++)
+        {
+            size_t begin = _lines[line].begin;
+            size_t at = begin - _delta;
+
+            /* still inside the edit, or after a line continuation */
+            if ((begin < end) || (_lines[line].origin != begin - 1) || (at == 0) || (at > previous._limit))
+                continue;
+
+            /* a row of `previous` which begins at the same place, right after a line break as well */
+            if ((previous.row(at) > previous.row(at - 1)) && (previous.col(at) == 1))
+            {
+                _to = begin;
+                _shift = static_cast<ptrdiff_t>(_dropped + line + 1) - previous.row(at);
+                _limit = previous._limit + _delta;
+                _lines.resize(line);
+                _state = State::Stopped;
+                _size = size;
+                return;
+            }
+        }
+    }
+
+    /* never lined up again, every row after the edit is indexed */
+    finish();
+    _size = size;
+}
+
+void LineIndex::append(const char *data, size_t size)
+{
+    const char *p = data;
+    const char *end = data + size;
+
+    /* offsets are counted from the very first piece */
+    auto offset = [&](const char *x){ return static_cast<uint32_t>(_size + (x - data)); };
+
+    /* nothing after a NUL matters, but it's still counted */
+    if (_state == State::Stopped)
+    {
+        _size += size;
+        return;
+    }
+
+    while (p < end)
+    {
+        switch (_state)
+        {
+            /* only line breaks, back-slashes and NULs are interesting, skip everything in between */
+            case State::Normal:
+            {
+                if ((p = Chars::findAny(p, end, '\n', '\r', '\\', '\0', '\0')) >= end)
+                    break;
+
+                switch ((_last = *p++))
+                {
+                    /* '\0' means EOF, nothing after it can ever be reached */
+                    case 0:
+                    {
+                        _state = State::Stopped;
+                        _limit = offset(p - 1);
+                        _size += size;
+                        return;
+                    }
+
+                    case '\r':
+                    case '\n':
+                    {
+                        _state = State::Break;
+                        break;
+                    }
+
+                    case '\\':
+                    {
+                        _state = State::Slash;
+                        break;
+                    }
+                }
+
+                break;
+            }
+
+            /* '\r\n' or '\n\r', the line break itself is the first column of next row */
+            case State::Break:
+            {
+                if (*p == (_last == '\n' ? '\r' : '\n'))
+                    p++;
+
+                _state = State::Normal;
+                _lines.push_back(Line { offset(p), offset(p) - 1 });
+                break;
+            }
+
+            /* line continuation, takes no column at all, otherwise just an ordinary back-slash */
+            case State::Slash:
+            {
+                if ((*p != '\r') && (*p != '\n'))
+                    _state = State::Normal;
+                else
+                {
+                    p++;
+                    _state = State::Continue;
+                }
+
+                break;
+            }
+
+            /* same pairing rule as `nextChar()`, which pairs against the back-slash */
+            case State::Continue:
+            {
+                if (*p == '\n')
+                    p++;
+
+                _state = State::Verbatim;
+                _lines.push_back(Line { offset(p), offset(p) });
+                break;
+            }
+
+            /* character right after the continuation is taken as-is, even if it's a NUL */
+            case State::Verbatim:
+            {
+                if (!*p++)
+                {
+                    _state = State::Stopped;
+                    _limit = offset(p);
+                    _size += size;
+                    return;
+                }
+
+                _state = State::Normal;
+                break;
+            }
+
+            case State::Stopped:
+                return;
+        }
+    }
+
+    _size += size;
+    _limit = _size;
+}
+
+void LineIndex::finish(void)
+{
+    /* a pending line break at the very end still starts a new row */
+    switch (_state)
+    {
+        case State::Break    : _lines.push_back(Line { static_cast<uint32_t>(_size), static_cast<uint32_t>(_size) - 1 }); break;
+        case State::Continue : _lines.push_back(Line { static_cast<uint32_t>(_size), static_cast<uint32_t>(_size)     }); break;
+        default              : break;
+    }
+
+    _state = State::Stopped;
+}
+
+void LineIndex::discard(size_t offset)
+{
+    /* rows entirely before `offset` */
+    auto line = std::upper_bound(_lines.begin(), _lines.end(), offset, [](size_t x, const Line &y){ return x < y.begin; });
+    size_t count = (line == _lines.begin()) ? 0 : (line - _lines.begin() - 1);
+
+    /* only worth it when at least half of the rows can go, so every row is moved at most once on average */
+    if ((count == 0) || (2 * count < _lines.size()))
+        return;
+
+    _lines.erase(_lines.begin(), _lines.begin() + count);
+    _dropped += count;
+}
+
+int LineIndex::row(size_t offset) const
+{
+    offset = std::min(offset, _limit);
+
+    /* rows of an edited source which are not indexed again */
+    if (_previous && (offset < _lines.front().begin))
+        return _previous->row(offset);
+    else if (_previous && (offset >= _to))
+        return static_cast<int>(_previous->row(offset - _delta) + _shift);
+
+    /* the last row which begins at or before `offset`, or the first row kept */
+    auto line = std::upper_bound(_lines.begin(), _lines.end(), std::min(offset, _limit), [](size_t x, const Line &y){ return x < y.begin; });
+    return static_cast<int>(_dropped + std::max<ptrdiff_t>(line - _lines.begin(), 1));
+}
+
+int LineIndex::col(size_t offset) const
+{
+    offset = std::min(offset, _limit);
+
+    /* rows of an edited source which are not indexed again, rows after the edit begin after it as well */
+    if (_previous && (offset < _lines.front().begin))
+        return _previous->col(offset);
+    else if (_previous && (offset >= _to))
+        return _previous->col(offset - _delta);
+
+    offset = std::max<size_t>(std::min(offset, _limit), _lines.front().begin);
+    return static_cast<int>(offset - _lines[row(offset) - 1 - _dropped].origin);
+}
+}
+}
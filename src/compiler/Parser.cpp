@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "Parser.h"
 #include "SyntaxError.h"
 
@@ -7,22 +9,118 @@ namespace Compiler
 {
 /** Generic Parser **/
 
+struct PrecedenceTable
+{
+    static constexpr size_t Size = static_cast<size_t>(Token::Operator::Decorator) + 1;
+    Parser::Precedence levels[Size];
+
+public:
+    constexpr PrecedenceTable() : levels()
+    {
+        /* not a binary operator by default */
+        for (size_t i = 0; i < Size; i++)
+            levels[i] = Parser::Precedence::None;
+
+        /* boolean operators, `not` is an unary operator, handled seperately */
+        set(Token::Operator::BoolOr     , Parser::Precedence::BoolOr    );
+        set(Token::Operator::BoolAnd    , Parser::Precedence::BoolAnd   );
+
+        /* relations, `not in` and `is not` are composed by the parser */
+        set(Token::Operator::Is         , Parser::Precedence::Relations );
+        set(Token::Operator::In         , Parser::Precedence::Relations );
+        set(Token::Operator::Leq        , Parser::Precedence::Relations );
+        set(Token::Operator::Geq        , Parser::Precedence::Relations );
+        set(Token::Operator::Neq        , Parser::Precedence::Relations );
+        set(Token::Operator::Equ        , Parser::Precedence::Relations );
+        set(Token::Operator::Less       , Parser::Precedence::Relations );
+        set(Token::Operator::Greater    , Parser::Precedence::Relations );
+
+        /* bit operators */
+        set(Token::Operator::BitOr      , Parser::Precedence::BitOr     );
+        set(Token::Operator::BitXor     , Parser::Precedence::BitXor    );
+        set(Token::Operator::BitAnd     , Parser::Precedence::BitAnd    );
+        set(Token::Operator::ShiftLeft  , Parser::Precedence::BitShift  );
+        set(Token::Operator::ShiftRight , Parser::Precedence::BitShift  );
+
+        /* arithmetic operators, unary `+`, `-` and `~` are handled seperately */
+        set(Token::Operator::Plus       , Parser::Precedence::Term      );
+        set(Token::Operator::Minus      , Parser::Precedence::Term      );
+        set(Token::Operator::Divide     , Parser::Precedence::Factor    );
+        set(Token::Operator::Multiply   , Parser::Precedence::Factor    );
+        set(Token::Operator::Module     , Parser::Precedence::Factor    );
+        set(Token::Operator::Power      , Parser::Precedence::Power     );
+    }
+
+public:
+    constexpr void set(Token::Operator op, Parser::Precedence level) { levels[static_cast<size_t>(op)] = level; }
+    constexpr Parser::Precedence operator[](size_t op) const { return levels[op]; }
+
+};
+
+static constexpr PrecedenceTable Precedences;
+
+static inline bool isInplaceOperator(Token::Operator op)
+{
+    switch (op)
+    {
+        case Token::Operator::InplaceAdd:
+        case Token::Operator::InplaceSub:
+        case Token::Operator::InplaceMul:
+        case Token::Operator::InplaceDiv:
+        case Token::Operator::InplaceMod:
+        case Token::Operator::InplacePower:
+        case Token::Operator::InplaceBitOr:
+        case Token::Operator::InplaceBitXor:
+        case Token::Operator::InplaceBitAnd:
+        case Token::Operator::InplaceShiftLeft:
+        case Token::Operator::InplaceShiftRight:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static inline bool isPassThrough(const AST::Expression *expr)
+{
+    /* a bare component without any operator, carries nothing on it's own */
+    return !expr->isUnary && expr->remains.empty() && (expr->first.type == AST::Expression::Type::TermComponent);
+}
+
+static inline AST::Expression::Term flattenTerm(AST::Expression *expr)
+{
+    if (isPassThrough(expr))
+        return AST::Expression::Term(expr->first.component);
+    else
+        return AST::Expression::Term(expr);
+}
+
+Parser::Nesting::Nesting(Parser *parser) : parser(parser)
+{
+    /* the destructor won't run if the constructor throws */
+    if (++parser->_depth > parser->_maxDepth)
+    {
+        parser->_depth--;
+        throw Exception::SyntaxError(parser->_tk->row(), parser->_tk->col(), "Nesting too deep");
+    }
+}
+
 void Parser::expect(Token::Keyword expect)
 {
-    if (_tk->next()->asKeyword() != expect)
+    if (_tk->next().asKeyword() != expect)
         throw Exception::SyntaxError(_tk->row(), _tk->col(), Strings::format("Keyword \"%s\" expected", Token::keywordName(expect)));
 }
 
 void Parser::expect(Token::Operator expect)
 {
-    if (_tk->next()->asOperator() != expect)
+    if (_tk->next().asOperator() != expect)
         throw Exception::SyntaxError(_tk->row(), _tk->col(), Strings::format("Operator \"%s\" expected", Token::operatorName(expect)));
 }
 
 bool Parser::isKeyword(Token::Keyword expected)
 {
-    std::shared_ptr<Token> token = _tk->peek();
-    return token->is<Token::Type::Keywords>() && (token->asKeyword() == expected);
+    Token token = _tk->peek();
+    return token.is<Token::Type::Keywords>() && (token.asKeyword() == expected);
 }
 
 bool Parser::skipKeyword(Token::Keyword expected)
@@ -36,8 +134,8 @@ bool Parser::skipKeyword(Token::Keyword expected)
 
 bool Parser::isOperator(Token::Operator expected)
 {
-    std::shared_ptr<Token> token = _tk->peek();
-    return token->is<Token::Type::Operators>() && (token->asOperator() == expected);
+    Token token = _tk->peek();
+    return token.is<Token::Type::Operators>() && (token.asOperator() == expected);
 }
 
 bool Parser::skipOperator(Token::Operator expected)
@@ -49,20 +147,21 @@ bool Parser::skipOperator(Token::Operator expected)
     return true;
 }
 
-bool Parser::readOperators(Token::Operator &op, const std::unordered_set<Token::Operator> &operators)
+bool Parser::readOperator(Token::Operator &op, Precedence level)
 {
     /* peek next token */
-    std::shared_ptr<Token> token = _tk->peek();
+    Token token = _tk->peek();
 
-    if (!token->is<Token::Type::Operators>() ||
-        (operators.find(token->asOperator()) == operators.end()))
+    /* a single table lookup decides whether it belongs to this level */
+    if (!token.is<Token::Type::Operators>() ||
+        (Precedences[static_cast<size_t>(token.asOperator())] != level))
         return false;
 
-    op = _tk->next()->asOperator();
+    op = _tk->next().asOperator();
     return true;
 }
 
-bool Parser::unpackPointerPair(std::shared_ptr<AST::Expression> &expr, std::shared_ptr<AST::Name> &name)
+bool Parser::unpackPointerPair(AST::Expression *&expr, AST::Name *&name)
 {
     while (expr->first.type == AST::Expression::Type::TermExpression)
     {
@@ -85,7 +184,7 @@ bool Parser::unpackPointerPair(std::shared_ptr<AST::Expression> &expr, std::shar
     return true;
 }
 
-bool Parser::extractArgumentName(std::shared_ptr<AST::Expression> expr, std::shared_ptr<AST::Name> &name)
+bool Parser::extractArgumentName(AST::Expression *expr, AST::Name *&name)
 {
     while (expr->first.type == AST::Expression::Type::TermExpression)
     {
@@ -107,12 +206,50 @@ bool Parser::extractArgumentName(std::shared_ptr<AST::Expression> expr, std::sha
     return true;
 }
 
+void Parser::parseBody(AST::Define *define)
+{
+    /* only blocks can be skipped without parsing, their extent is known from the bracket pairs */
+    if (!_lazy || !isOperator(Token::Operator::BlockLeft))
+    {
+        define->body = parseStatement();
+        return;
+    }
+
+    /* the body is parsed later from right here, leading new-lines included, just like `parseStatement()` does now */
+    define->bodyBegin = _tk->index();
+    _tk->next();
+
+    /* brackets must at least be balanced, everything else is checked when the body is parsed */
+    size_t end = _tk->match(_tk->index() - 1);
+    const Token &token = _tk->fetch(end);
+
+    /* unclosed block */
+    if (token.is<Token::Type::Eof>())
+    {
+        _tk->seek(end);
+        _tk->peek();
+        throw Exception::SyntaxError(_tk->row(), _tk->col(), "Unexpected \"EOF\"");
+    }
+
+    /* closed by another kind of bracket */
+    if (!token.isOperator(Token::Operator::BlockRight))
+    {
+        _tk->seek(end);
+        _tk->next();
+        throw Exception::SyntaxError(_tk->row(), _tk->col(), "Operator \"}\" expected");
+    }
+
+    /* skip the whole block, blocks need no terminator */
+    _tk->seek(end + 1);
+    define->bodyEnd = end + 1;
+}
+
 /** Language Structures **/
 
-std::shared_ptr<AST::If> Parser::parseIf(void)
+AST::If *Parser::parseIf(void)
 {
     expect(Token::Keyword::If);
-    std::shared_ptr<AST::If> result = AST::Node::create<AST::If>(_tk);
+    AST::If *result = create<AST::If>();
 
     expect(Token::Operator::BracketLeft);
     result->expr = parseExpression();
@@ -126,13 +263,13 @@ std::shared_ptr<AST::If> Parser::parseIf(void)
     return result;
 }
 
-std::shared_ptr<AST::For> Parser::parseFor(void)
+AST::For *Parser::parseFor(void)
 {
     expect(Token::Keyword::For);
-    std::shared_ptr<AST::For> result = AST::Node::create<AST::For>(_tk);
+    AST::For *result = create<AST::For>();
 
     expect(Token::Operator::BracketLeft);
-    result->seq = AST::Node::create<AST::Sequence>(_tk);
+    result->seq = create<AST::Sequence>();
     result->seq->isSeq = false;
 
     do
@@ -162,10 +299,10 @@ std::shared_ptr<AST::For> Parser::parseFor(void)
     return result;
 }
 
-std::shared_ptr<AST::While> Parser::parseWhile(void)
+AST::While *Parser::parseWhile(void)
 {
     expect(Token::Keyword::While);
-    std::shared_ptr<AST::While> result = AST::Node::create<AST::While>(_tk);
+    AST::While *result = create<AST::While>();
 
     expect(Token::Operator::BracketLeft);
     result->expr = parseExpression();
@@ -174,10 +311,10 @@ std::shared_ptr<AST::While> Parser::parseWhile(void)
     return result;
 }
 
-std::shared_ptr<AST::Define> Parser::parseDefine(void)
+AST::Define *Parser::parseDefine(void)
 {
     expect(Token::Keyword::Def);
-    std::shared_ptr<AST::Define> result = AST::Node::create<AST::Define>(_tk);
+    AST::Define *result = create<AST::Define>();
 
     result->name = parseName();
     expect(Token::Operator::BracketLeft);
@@ -189,24 +326,24 @@ std::shared_ptr<AST::Define> Parser::parseDefine(void)
     }
 
     expect(Token::Operator::BracketRight);
-    result->body = parseStatement();
+    parseBody(result);
     return result;
 }
 
-std::shared_ptr<AST::Import> Parser::parseImport(void)
+AST::Import *Parser::parseImport(void)
 {
     expect(Token::Keyword::Import);
-    std::shared_ptr<AST::Import> result = AST::Node::create<AST::Import>(_tk);
+    AST::Import *result = create<AST::Import>();
 
     do result->names.push_back(parseName());
     while (skipOperator(Token::Operator::Point));
     return result;
 }
 
-std::shared_ptr<AST::Try> Parser::parseTry(void)
+AST::Try *Parser::parseTry(void)
 {
     expect(Token::Keyword::Try);
-    std::shared_ptr<AST::Try> result = AST::Node::create<AST::Try>(_tk);
+    AST::Try *result = create<AST::Try>();
 
     result->body = parseStatement();
     result->haveWildcard = false;
@@ -215,7 +352,7 @@ std::shared_ptr<AST::Try> Parser::parseTry(void)
     while (isKeyword(Token::Keyword::Except))
     {
         /* parse except block */
-        std::shared_ptr<AST::Except> except = parseExcept();
+        AST::Except *except = parseExcept();
 
         /* can only have at most 1 wildcard capture */
         if (result->haveWildcard)
@@ -229,7 +366,7 @@ std::shared_ptr<AST::Try> Parser::parseTry(void)
 
         /* add to except block list */
         result->haveWildcard = except->isWildcard;
-        result->excepts.push_back(std::move(except));
+        result->excepts.push_back(except);
     }
 
     /* finally section */
@@ -243,11 +380,11 @@ std::shared_ptr<AST::Try> Parser::parseTry(void)
     return result;
 }
 
-std::shared_ptr<AST::Except> Parser::parseExcept(void)
+AST::Except *Parser::parseExcept(void)
 {
     expect(Token::Keyword::Except);
-    std::shared_ptr<AST::Except> result = AST::Node::create<AST::Except>(_tk);
-    std::vector<std::shared_ptr<AST::Name>> names;
+    AST::Except *result = create<AST::Except>();
+    std::vector<AST::Name *> names;
 
     /* "except" descriptors are surrounded by "()"*/
     expect(Token::Operator::BracketLeft);
@@ -284,10 +421,10 @@ std::shared_ptr<AST::Except> Parser::parseExcept(void)
 
 /** Statements **/
 
-std::shared_ptr<AST::Tuple> Parser::parseTupleExpression(bool &isSeq)
+AST::Tuple *Parser::parseTupleExpression(bool &isSeq)
 {
     /* create tuple result */
-    std::shared_ptr<AST::Tuple> result = AST::Node::create<AST::Tuple>(_tk);
+    AST::Tuple *result = create<AST::Tuple>();
 
     /* we assume it's not sequence at start */
     for (isSeq = false;;)
@@ -297,11 +434,11 @@ std::shared_ptr<AST::Tuple> Parser::parseTupleExpression(bool &isSeq)
 
         /* read next token */
         bool isEnd = false;
-        std::shared_ptr<Token> token = _tk->peekOrLine();
+        Token token = _tk->peekOrLine();
 
         /* once it encountered a comma, it definately a sequence */
-        if (token->is<Token::Type::Operators>() &&
-            token->asOperator() == Token::Operator::Comma)
+        if (token.is<Token::Type::Operators>() &&
+            token.asOperator() == Token::Operator::Comma)
         {
             /* skip this comma */
             _tk->nextOrLine();
@@ -313,17 +450,17 @@ std::shared_ptr<AST::Tuple> Parser::parseTupleExpression(bool &isSeq)
         }
 
         /* stop sequencing when encounters "\n", ";" or `EOF` */
-        switch (token->type())
+        switch (token.type())
         {
             case Token::Type::Eof:
                 return result;
 
             case Token::Type::Keywords:
-                throw Exception::SyntaxError(_tk->row(), _tk->col(), "Unexpected token " + token->toString());
+                throw Exception::SyntaxError(_tk->row(), _tk->col(), "Unexpected token " + token.toString());
 
             case Token::Type::Operators:
             {
-                switch (token->asOperator())
+                switch (token.asOperator())
                 {
                     case Token::Operator::NewLine:
                     case Token::Operator::Semicolon:
@@ -341,16 +478,16 @@ std::shared_ptr<AST::Tuple> Parser::parseTupleExpression(bool &isSeq)
                 if (isEnd)
                     break;
                 else
-                    throw Exception::SyntaxError(_tk->row(), _tk->col(), "Unexpected token " + token->toString());
+                    throw Exception::SyntaxError(_tk->row(), _tk->col(), "Unexpected token " + token.toString());
             }
         }
     }
 }
 
-std::shared_ptr<AST::Component> Parser::parseMutableComponent(void)
+AST::Component *Parser::parseMutableComponent(void)
 {
     /* parse next component item */
-    std::shared_ptr<AST::Component> result = parseComponent();
+    AST::Component *result = parseComponent();
 
     /* component must be mutable */
     if (result->modifiers.empty())
@@ -369,12 +506,11 @@ std::shared_ptr<AST::Component> Parser::parseMutableComponent(void)
     return result;
 }
 
-std::shared_ptr<AST::Assign> Parser::parseAssign(bool &isRewindable)
+AST::Assign *Parser::parseAssign(void)
 {
-    std::shared_ptr<AST::Assign> result = AST::Node::create<AST::Assign>(_tk);
+    AST::Assign *result = create<AST::Assign>();
 
-    isRewindable = true;
-    result->target = AST::Node::create<AST::Sequence>(_tk);
+    result->target = create<AST::Sequence>();
     result->target->isSeq = false;
 
     do
@@ -399,56 +535,47 @@ std::shared_ptr<AST::Assign> Parser::parseAssign(bool &isRewindable)
 
     /* assign statement requires an assign operator */
     expect(Token::Operator::Assign);
-
-    /* once parsed across the assign operator, there is no way back */
-    isRewindable = false;
     result->tuple = parseTupleExpression(result->isSeq);
     return result;
 }
 
-std::shared_ptr<AST::Inplace> Parser::parseInplace(bool &isRewindable)
+AST::Inplace *Parser::parseInplace(void)
 {
     /* result `Inplace` node */
-    std::shared_ptr<AST::Inplace> result = AST::Node::create<AST::Inplace>(_tk);
+    AST::Inplace *result = create<AST::Inplace>();
 
-    /* inplace operations supports only one target, but still rewindable here */
-    isRewindable = true;
+    /* inplace operations supports only one target */
     result->target = parseMutableComponent();
 
     /* read inplace operator */
-    if (!readOperators(result->op, {
-        Token::Operator::InplaceAdd,
-        Token::Operator::InplaceSub,
-        Token::Operator::InplaceMul,
-        Token::Operator::InplaceDiv,
-        Token::Operator::InplaceMod,
-        Token::Operator::InplacePower,
-        Token::Operator::InplaceBitOr,
-        Token::Operator::InplaceBitXor,
-        Token::Operator::InplaceBitAnd,
-        Token::Operator::InplaceShiftLeft,
-        Token::Operator::InplaceShiftRight }))
+    Token token = _tk->peek();
+
+    if (!token.is<Token::Type::Operators>() || !isInplaceOperator(token.asOperator()))
         throw Exception::SyntaxError(_tk->row(), _tk->col(), "Inplace operators expected");
 
-    /* once parsed across the inplace operator, there no way back */
-    isRewindable = false;
+    result->op = _tk->next().asOperator();
+
+    /* the inplace operand */
     result->expression = parseExpression();
     return result;
 }
 
-std::shared_ptr<AST::Delete> Parser::parseDelete(void)
+AST::Delete *Parser::parseDelete(void)
 {
     expect(Token::Keyword::Delete);
-    std::shared_ptr<AST::Delete> result = AST::Node::create<AST::Delete>(_tk);
+    AST::Delete *result = create<AST::Delete>();
 
     result->target = parseMutableComponent();
     return result;
 }
 
-std::shared_ptr<AST::Sequence> Parser::parseSequence(void)
+AST::Sequence *Parser::parseSequence(void)
 {
+    /* nested targets recurse through here, without going through statements or expressions */
+    Nesting nesting(this);
+
     /* create new seqnece */
-    std::shared_ptr<AST::Sequence> result = AST::Node::create<AST::Sequence>(_tk);
+    AST::Sequence *result = create<AST::Sequence>();
 
     do
     {
@@ -479,10 +606,106 @@ std::shared_ptr<AST::Sequence> Parser::parseSequence(void)
     return result;
 }
 
-std::shared_ptr<AST::Compond> Parser::parseCompond(void)
+AST::Statement::Type Parser::classifyStatement(void)
+{
+    /* scan the top-level tokens of current statement, without moving the cursor */
+    size_t index = _tk->index();
+
+    /* skip leading new-lines, just like `peek()` does */
+    while (_tk->fetch(index).isOperator(Token::Operator::NewLine))
+        index++;
+
+    for (;; index++)
+    {
+        const Token &token = _tk->fetch(index);
+
+        switch (token.type())
+        {
+            /* statement ends before any assignment */
+            case Token::Type::Eof:
+            case Token::Type::Keywords:
+                return AST::Statement::Type::StatementComponent;
+
+            case Token::Type::Operators:
+            {
+                switch (token.asOperator())
+                {
+                    /* nested structures, only top-level operators count, jump over them with
+                     * the pre-computed bracket pairs, so that every token of a deeply nested
+                     * lambda body is not re-scanned once for each enclosing statement */
+                    case Token::Operator::BlockLeft:
+                    case Token::Operator::IndexLeft:
+                    case Token::Operator::BracketLeft:
+                    {
+                        index = _tk->match(index);
+                        break;
+                    }
+
+                    /* unbalanced closing brackets belongs to outer structures */
+                    case Token::Operator::BlockRight:
+                    case Token::Operator::IndexRight:
+                    case Token::Operator::BracketRight:
+                        return AST::Statement::Type::StatementComponent;
+
+                    /* assignment */
+                    case Token::Operator::Assign:
+                        return AST::Statement::Type::StatementAssign;
+
+                    /* pairs and lambdas are never mutable, and lambda bodies are statements on their own */
+                    case Token::Operator::Pointer:
+                    case Token::Operator::Semicolon:
+                        return AST::Statement::Type::StatementComponent;
+
+                    /* top-level new-lines */
+                    case Token::Operator::NewLine:
+                    {
+                        /* the target list may wrap after a comma */
+                        if (index && _tk->fetch(index - 1).isOperator(Token::Operator::Comma))
+                            break;
+
+                        /* skip all remaining new-lines */
+                        size_t next = index + 1;
+                        while (_tk->fetch(next).isOperator(Token::Operator::NewLine))
+                            next++;
+
+                        /* attribute access can wrap to the next line, so do the comma before the next
+                         * target and the operator which follows the targets */
+                        const Token &follow = _tk->fetch(next);
+
+                        if (!follow.is<Token::Type::Operators>() ||
+                            ((follow.asOperator() != Token::Operator::Point) &&
+                             (follow.asOperator() != Token::Operator::Comma) &&
+                             (follow.asOperator() != Token::Operator::Assign) &&
+                             !isInplaceOperator(follow.asOperator())))
+                            return AST::Statement::Type::StatementComponent;
+
+                        index = next - 1;
+                        break;
+                    }
+
+                    /* inplace operations */
+                    default:
+                    {
+                        if (isInplaceOperator(token.asOperator()))
+                            return AST::Statement::Type::StatementInplace;
+
+                        break;
+                    }
+                }
+
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+}
+
+AST::Compond *Parser::parseCompond(void)
 {
     expect(Token::Operator::BlockLeft);
-    std::shared_ptr<AST::Compond> result = AST::Node::create<AST::Compond>(_tk);
+    AST::Compond *result = create<AST::Compond>();
 
     while (!isOperator(Token::Operator::BlockRight))
         result->statements.push_back(parseStatement());
@@ -491,22 +714,24 @@ std::shared_ptr<AST::Compond> Parser::parseCompond(void)
     return result;
 }
 
-std::shared_ptr<AST::Statement> Parser::parseStatement(void)
+AST::Statement *Parser::parseStatement(void)
 {
+    /* blocks, function and lambda bodies recurse through here */
+    Nesting nesting(this);
+
     /* peek next token */
-    bool isRewindable = false;
-    std::shared_ptr<Token> token = _tk->peek();
-    std::shared_ptr<AST::Statement> result = AST::Node::create<AST::Statement>(_tk);
+    Token token = _tk->peek();
+    AST::Statement *result = create<AST::Statement>();
 
     /* dispatch due to token type */
-    switch (token->type())
+    switch (token.type())
     {
         case Token::Type::Eof:
             throw Exception::SyntaxError(_tk->row(), _tk->col(), "Unexpected \"EOF\"");
 
         case Token::Type::Operators:
         {
-            if (token->asOperator() == Token::Operator::BlockLeft)
+            if (token.asOperator() == Token::Operator::BlockLeft)
             {
                 result->type = AST::Statement::Type::StatementCompond;
                 result->compondStatement = parseCompond();
@@ -522,40 +747,26 @@ std::shared_ptr<AST::Statement> Parser::parseStatement(void)
         case Token::Type::Integer:
         case Token::Type::Identifiers:
         {
-            try
+            /* decide the statement type by looking ahead, instead of trying each of them */
+            switch ((result->type = classifyStatement()))
             {
-                /* try parsing as `Inplace` operations */
-                _tk->pushState();
-                result->type = AST::Statement::Type::StatementInplace;
-                result->inplaceStatement = parseInplace(isRewindable);
-                _tk->killState();
-
-            } catch (const Exception::SyntaxError &)
-            {
-                /* not rewindable here, re-throw the SyntaxError exception */
-                if (!isRewindable)
-                    throw;
-
-                try
+                case AST::Statement::Type::StatementAssign:
                 {
-                    /* restore tokenizer state, and try parsing as `Assign` operation */
-                    _tk->popState();
-                    _tk->pushState();
-                    result->type = AST::Statement::Type::StatementAssign;
-                    result->assignStatement = parseAssign(isRewindable);
-                    _tk->killState();
-
-                } catch (const Exception::SyntaxError &)
+                    result->assignStatement = parseAssign();
+                    break;
+                }
+
+                case AST::Statement::Type::StatementInplace:
                 {
-                    /* not rewindable here, re-throw the SyntaxError exception */
-                    if (!isRewindable)
-                        throw;
+                    result->inplaceStatement = parseInplace();
+                    break;
+                }
 
-                    /* restore tokenizer state, and try parsing as `Standalone Component` */
-                    _tk->popState();
-                    result->type = AST::Statement::Type::StatementComponent;
+                default:
+                {
                     result->componentStatement = parseComponent();
                     result->componentStatement->isStandalone = true;
+                    break;
                 }
             }
 
@@ -564,7 +775,7 @@ std::shared_ptr<AST::Statement> Parser::parseStatement(void)
 
         case Token::Type::Keywords:
         {
-            switch (token->asKeyword())
+            switch (token.asKeyword())
             {
                 case Token::Keyword::If       : result->setStatement(parseIf        ()); break;
                 case Token::Keyword::For      : result->setStatement(parseFor       ()); break;
@@ -581,7 +792,7 @@ std::shared_ptr<AST::Statement> Parser::parseStatement(void)
                 case Token::Keyword::Import   : result->setStatement(parseImport    ()); break;
 
                 default:
-                    throw Exception::SyntaxError(_tk->row(), _tk->col(), "Unexpected token " + token->toString());
+                    throw Exception::SyntaxError(_tk->row(), _tk->col(), "Unexpected token " + token.toString());
             }
 
             break;
@@ -589,14 +800,14 @@ std::shared_ptr<AST::Statement> Parser::parseStatement(void)
     }
 
     /* statement must ends with eof, new-line or ";" */
-    switch ((token = _tk->nextOrLine())->type())
+    switch ((token = _tk->nextOrLine()).type())
     {
         case Token::Type::Eof:
             return result;
 
         case Token::Type::Operators:
         {
-            switch (token->asOperator())
+            switch (token.asOperator())
             {
                 case Token::Operator::NewLine:
                 case Token::Operator::Semicolon:
@@ -614,58 +825,59 @@ std::shared_ptr<AST::Statement> Parser::parseStatement(void)
 
 /** Control Flows **/
 
-std::shared_ptr<AST::Break> Parser::parseBreak(void)
+AST::Break *Parser::parseBreak(void)
 {
     expect(Token::Keyword::Break);
-    return AST::Node::create<AST::Break>(_tk);
+    return create<AST::Break>();
 }
 
-std::shared_ptr<AST::Raise> Parser::parseRaise(void)
+AST::Raise *Parser::parseRaise(void)
 {
     expect(Token::Keyword::Raise);
-    std::shared_ptr<AST::Raise> result = AST::Node::create<AST::Raise>(_tk);
+    AST::Raise *result = create<AST::Raise>();
 
     result->expr = parseExpression();
     return result;
 }
 
-std::shared_ptr<AST::Return> Parser::parseReturn(void)
+AST::Return *Parser::parseReturn(void)
 {
     expect(Token::Keyword::Return);
-    std::shared_ptr<AST::Return> result = AST::Node::create<AST::Return>(_tk);
+    AST::Return *result = create<AST::Return>();
 
     result->tuple = parseTupleExpression(result->isSeq);
     return result;
 }
 
-std::shared_ptr<AST::Continue> Parser::parseContinue(void)
+AST::Continue *Parser::parseContinue(void)
 {
     expect(Token::Keyword::Continue);
-    return AST::Node::create<AST::Continue>(_tk);
+    return create<AST::Continue>();
 }
 
 /** Expression Components **/
 
-std::shared_ptr<AST::Name> Parser::parseName(void)
+AST::Name *Parser::parseName(void)
 {
-    std::shared_ptr<AST::Name> result = AST::Node::create<AST::Name>(_tk);
-    result->name = _tk->next()->asIdentifier();
+    AST::Name *result = create<AST::Name>();
+    result->symbol = _tk->next().asSymbol();
+    _names.push_back(result);
     return result;
 }
 
-std::shared_ptr<AST::Index> Parser::parseIndex(void)
+AST::Index *Parser::parseIndex(void)
 {
     expect(Token::Operator::IndexLeft);
-    std::shared_ptr<AST::Index> result = AST::Node::create<AST::Index>(_tk);
+    AST::Index *result = create<AST::Index>();
     result->index = parseExpression();
     expect(Token::Operator::IndexRight);
     return result;
 }
 
-std::shared_ptr<AST::Invoke> Parser::parseInvoke(void)
+AST::Invoke *Parser::parseInvoke(void)
 {
     expect(Token::Operator::BracketLeft);
-    std::shared_ptr<AST::Invoke> result = AST::Node::create<AST::Invoke>(_tk);
+    AST::Invoke *result = create<AST::Invoke>();
 
     if (!isOperator(Token::Operator::BracketRight))
     {
@@ -677,48 +889,48 @@ std::shared_ptr<AST::Invoke> Parser::parseInvoke(void)
     return result;
 }
 
-std::shared_ptr<AST::Attribute> Parser::parseAttribute(void)
+AST::Attribute *Parser::parseAttribute(void)
 {
     expect(Token::Operator::Point);
-    std::shared_ptr<AST::Attribute> result = AST::Node::create<AST::Attribute>(_tk);
+    AST::Attribute *result = create<AST::Attribute>();
     result->attribute = parseName();
     return result;
 }
 
 /** Expressions **/
 
-std::shared_ptr<AST::Map> Parser::parseMap(void)
+AST::Map *Parser::parseMap(void)
 {
     /* the "{" operator is already skipped */
-    std::shared_ptr<AST::Map> result = AST::Node::create<AST::Map>(_tk);
+    AST::Map *result = create<AST::Map>();
 
     while (!isOperator(Token::Operator::BlockRight))
     {
-        std::shared_ptr<AST::Name> name;
-        std::shared_ptr<AST::Expression> item = parseExpression();
+        AST::Name *name;
+        AST::Expression *item = parseExpression();
 
         if (!unpackPointerPair(item, name))
         {
             /* standard type item */
             expect(Token::Operator::Colon);
-            result->items.push_back(std::make_pair(std::move(item), parseExpression()));
+            result->items.push_back(std::make_pair(item, parseExpression()));
         }
         else
         {
             /* simple pointer-pair item */
-            std::shared_ptr<AST::Constant  > val  = AST::Node::create<AST::Constant  >(_tk);
-            std::shared_ptr<AST::Component > comp = AST::Node::create<AST::Component >(_tk);
+            AST::Constant   *val  = create<AST::Constant  >();
+            AST::Component  *comp = create<AST::Component >();
 
             /* build string constant */
             val->type = AST::Constant::Type::ConstantString;
-            val->stringValue = std::move(name->name);
+            val->stringValue = name->symbol->name;
 
             /* build component node out of constant */
             comp->type = AST::Component::Type::ComponentConstant;
-            comp->constant = std::move(val);
+            comp->constant = val;
 
             /* wrap component node with expression and add to map items list */
-            result->items.push_back(std::make_pair(AST::Node::create<AST::Expression>(_tk, std::move(comp)), std::move(item)));
+            result->items.push_back(std::make_pair(create<AST::Expression>(comp), item));
         }
 
         /* single comma at the end of map is supported */
@@ -731,10 +943,10 @@ std::shared_ptr<AST::Map> Parser::parseMap(void)
     return result;
 }
 
-std::shared_ptr<AST::List> Parser::parseList(void)
+AST::List *Parser::parseList(void)
 {
     /* the "[" operator is already skipped */
-    std::shared_ptr<AST::List> result = AST::Node::create<AST::List>(_tk);
+    AST::List *result = create<AST::List>();
 
     while (!isOperator(Token::Operator::IndexRight))
     {
@@ -751,12 +963,12 @@ std::shared_ptr<AST::List> Parser::parseList(void)
     return result;
 }
 
-std::shared_ptr<AST::Unit> Parser::parseUnit(void)
+AST::Unit *Parser::parseUnit(void)
 {
-    std::shared_ptr<Token> token = _tk->next();
-    std::shared_ptr<AST::Unit> result = AST::Node::create<AST::Unit>(_tk);
+    Token token = _tk->next();
+    AST::Unit *result = create<AST::Unit>();
 
-    switch (token->asOperator())
+    switch (token.asOperator())
     {
         case Token::Operator::BlockLeft:
         {
@@ -783,22 +995,22 @@ std::shared_ptr<AST::Unit> Parser::parseUnit(void)
                 {
                     /* empty tuple literal */
                     result->type = AST::Unit::Type::UnitTuple;
-                    result->tuple = AST::Node::create<AST::Tuple>(_tk);
+                    result->tuple = create<AST::Tuple>();
                 }
                 else
                 {
                     /* lambda expression with no arguments */
                     result->type = AST::Unit::Type::UnitLambda;
-                    result->lambda = AST::Node::create<AST::Define>(_tk);
+                    result->lambda = create<AST::Define>();
                     result->lambda->name = nullptr;
-                    result->lambda->body = parseStatement();
+                    parseBody(result->lambda);
                 }
             }
             else
             {
                 /* first argument, first element, or maybe nested expression, they looks like the same at this point */
-                std::shared_ptr<AST::Name> name;
-                std::shared_ptr<AST::Expression> item = parseExpression();
+                AST::Name *name;
+                AST::Expression *item = parseExpression();
 
                 if (skipOperator(Token::Operator::BracketRight))
                 {
@@ -811,9 +1023,9 @@ std::shared_ptr<AST::Unit> Parser::parseUnit(void)
                     else
                     {
                         result->type = AST::Unit::Type::UnitLambda;
-                        result->lambda = AST::Node::create<AST::Define>(_tk);
+                        result->lambda = create<AST::Define>();
                         result->lambda->name = nullptr;
-                        result->lambda->body = parseStatement();
+                        parseBody(result->lambda);
                         result->lambda->args.push_back(name);
                     }
                 }
@@ -821,7 +1033,7 @@ std::shared_ptr<AST::Unit> Parser::parseUnit(void)
                 {
                     /* tuple literals, or maybe lambda expression */
                     bool maybeLambda = true;
-                    std::vector<std::shared_ptr<AST::Expression>> items({ std::move(item) });
+                    std::vector<AST::Expression *> items({ item });
 
                     while (skipOperator(Token::Operator::Comma))
                     {
@@ -843,7 +1055,7 @@ std::shared_ptr<AST::Unit> Parser::parseUnit(void)
                     if (maybeLambda)
                     {
                         bool isLambda = true;
-                        std::shared_ptr<AST::Define> define = AST::Node::create<AST::Define>(_tk);
+                        AST::Define *define = create<AST::Define>();
 
                         for (const auto &arg : items)
                         {
@@ -865,16 +1077,16 @@ std::shared_ptr<AST::Unit> Parser::parseUnit(void)
 
                             /* parse lambda body */
                             define->name = nullptr;
-                            define->body = parseStatement();
+                            parseBody(define);
                             result->type = AST::Unit::Type::UnitLambda;
-                            result->lambda = std::move(define);
+                            result->lambda = define;
                             break;
                         }
                     }
 
                     /* it's definately a tuple literal */
                     result->type = AST::Unit::Type::UnitTuple;
-                    result->tuple = AST::Node::create<AST::Tuple>(_tk);
+                    result->tuple = create<AST::Tuple>();
                     result->tuple->items = std::move(items);
                 }
             }
@@ -883,57 +1095,59 @@ std::shared_ptr<AST::Unit> Parser::parseUnit(void)
         }
 
         default:
-            throw Exception::SyntaxError(_tk->row(), _tk->col(), "Unexpected token " + token->toString());
+            throw Exception::SyntaxError(_tk->row(), _tk->col(), "Unexpected token " + token.toString());
     }
 
     return result;
 }
 
-std::shared_ptr<AST::Constant> Parser::parseConstant(void)
+AST::Constant *Parser::parseConstant(void)
 {
-    std::shared_ptr<Token> token = _tk->next();
-    std::shared_ptr<AST::Constant> result = AST::Node::create<AST::Constant>(_tk);
+    Token token = _tk->next();
+    AST::Constant *result = create<AST::Constant>();
 
-    switch (token->type())
+    switch (token.type())
     {
         case Token::Type::Float:
         {
             result->type = AST::Constant::Type::ConstantFloat;
-            result->floatValue = token->asFloat();
+            result->floatValue = token.asFloat();
             break;
         }
 
         case Token::Type::String:
         {
+            /* tokens don't outlive the tokenizer, copy it into the arena */
+            StringView value = token.asString();
             result->type = AST::Constant::Type::ConstantString;
-            result->stringValue = token->asString();
+            result->stringValue = StringView(_arena->copy(value.data(), value.size()), value.size());
             break;
         }
 
         case Token::Type::Integer:
         {
             result->type = AST::Constant::Type::ConstantInteger;
-            result->integerValue = token->asInteger();
+            result->integerValue = token.asInteger();
             break;
         }
 
         default:
-            throw Exception::SyntaxError(_tk->row(), _tk->col(), Strings::format("Unexpected token \"%s\"", token->toString()));
+            throw Exception::SyntaxError(_tk->row(), _tk->col(), Strings::format("Unexpected token \"%s\"", token.toString()));
     }
 
     return result;
 }
 
-std::shared_ptr<AST::Component> Parser::parseComponent(void)
+AST::Component *Parser::parseComponent(void)
 {
-    std::shared_ptr<Token> token = _tk->peek();
-    std::shared_ptr<AST::Component> result = AST::Node::create<AST::Component>(_tk);
+    Token token = _tk->peek();
+    AST::Component *result = create<AST::Component>();
 
-    switch (token->type())
+    switch (token.type())
     {
         case Token::Type::Eof:
         case Token::Type::Keywords:
-            throw Exception::SyntaxError(_tk->row(), _tk->col(), "Unexpected token " + token->toString());
+            throw Exception::SyntaxError(_tk->row(), _tk->col(), "Unexpected token " + token.toString());
 
         case Token::Type::Float:
         case Token::Type::String:
@@ -953,14 +1167,19 @@ std::shared_ptr<AST::Component> Parser::parseComponent(void)
 
         case Token::Type::Identifiers:
         {
-            result->type = AST::Component::Type::ComponentName;
-            result->name = parseName();
+            /* names and pairs share the same slot, so don't store the name until it's known which */
+            AST::Name *name = parseName();
 
-            if (skipOperator(Token::Operator::Pointer))
+            if (!skipOperator(Token::Operator::Pointer))
+            {
+                result->type = AST::Component::Type::ComponentName;
+                result->name = name;
+            }
+            else
             {
                 result->type = AST::Component::Type::ComponentPair;
-                result->pair = AST::Node::create<AST::Pair>(_tk);
-                result->pair->name = std::move(result->name);
+                result->pair = create<AST::Pair>();
+                result->pair->name = name;
                 result->pair->value = parseExpression();
             }
 
@@ -968,15 +1187,15 @@ std::shared_ptr<AST::Component> Parser::parseComponent(void)
         }
     }
 
-    while ((token = _tk->peekOrLine())->is<Token::Type::Operators>())
+    while ((token = _tk->peekOrLine()).is<Token::Type::Operators>())
     {
-        switch (token->asOperator())
+        switch (token.asOperator())
         {
             /* attribute access */
             case Token::Operator::Point:
             {
                 /* add an attribute modifier */
-                result->modifiers.push_back(parseAttribute());
+                result->modifiers.push_back(*_arena, parseAttribute());
                 break;
             }
 
@@ -984,7 +1203,7 @@ std::shared_ptr<AST::Component> Parser::parseComponent(void)
             case Token::Operator::IndexLeft:
             {
                 /* add an index modifier */
-                result->modifiers.push_back(parseIndex());
+                result->modifiers.push_back(*_arena, parseIndex());
                 break;
             }
 
@@ -992,7 +1211,7 @@ std::shared_ptr<AST::Component> Parser::parseComponent(void)
             case Token::Operator::BracketLeft:
             {
                 /* add an invoke modifier */
-                result->modifiers.push_back(parseInvoke());
+                result->modifiers.push_back(*_arena, parseInvoke());
                 break;
             }
 
@@ -1000,34 +1219,33 @@ std::shared_ptr<AST::Component> Parser::parseComponent(void)
             case Token::Operator::NewLine:
             {
                 /* save tokenizer state */
-                _tk->pushState();
+                Tokenizer::State state = _tk->save();
 
                 /* skip all remaining new-lines */
-                while (token->is<Token::Type::Operators>() &&
-                      (token->asOperator() == Token::Operator::NewLine))
+                while (token.is<Token::Type::Operators>() &&
+                      (token.asOperator() == Token::Operator::NewLine))
                 {
                     _tk->nextOrLine();
                     token = _tk->peekOrLine();
                 }
 
                 /* check for eof */
-                if (token->is<Token::Type::Eof>())
+                if (token.is<Token::Type::Eof>())
                 {
-                    _tk->popState();
+                    _tk->restore(state);
                     return result;
                 }
 
                 /* only attribute access can wrap to next line */
-                if (!token->is<Token::Type::Operators>() ||
-                    (token->asOperator() != Token::Operator::Point))
+                if (!token.is<Token::Type::Operators>() ||
+                    (token.asOperator() != Token::Operator::Point))
                 {
-                    _tk->popState();
+                    _tk->restore(state);
                     return result;
                 }
 
                 /* add an attribute modifier */
-                _tk->killState();
-                result->modifiers.push_back(parseAttribute());
+                result->modifiers.push_back(*_arena, parseAttribute());
                 break;
             }
 
@@ -1040,190 +1258,429 @@ std::shared_ptr<AST::Component> Parser::parseComponent(void)
     return result;
 }
 
-std::shared_ptr<AST::Expression> Parser::parsePower(void)
+AST::Expression *Parser::parseExpression(Precedence level)
 {
-    /* build result expression */
-    Token::Operator op;
-    std::shared_ptr<AST::Expression> result = AST::Node::create<AST::Expression>(_tk, parseComponent());
-
-    /* operator chaining */
-    while (readOperators(op, { Token::Operator::Power }))
-        result->remains.push_back(std::make_pair(op, AST::Node::create<AST::Expression>(_tk, parseComponent())));
+    /* brackets, operands and prefix operators recurse through here */
+    Nesting nesting(this);
 
-    return result;
-}
-
-std::shared_ptr<AST::Expression> Parser::parseUnary(void)
-{
-    /* the unary operator */
     Token::Operator op;
+    Precedence current;
+    Token token = _tk->peek();
+    AST::Expression *result;
 
-    /* recursively parsing unary operators */
-    if (!readOperators(op, { Token::Operator::Plus, Token::Operator::Minus, Token::Operator::BitNot }))
-        return parsePower();
+    /* prefix operators, `not` binds looser than relations, `+`, `-` and `~` binds tighter than factors */
+    if ((level <= Precedence::BoolNot) && token.isOperator(Token::Operator::BoolNot))
+    {
+        _tk->next();
+        current = Precedence::BoolNot;
+        result = create<AST::Expression>(Token::Operator::BoolNot, flattenTerm(parseExpression(Precedence::BoolNot)));
+    }
+    else if ((level <= Precedence::Unary) && (token.isOperator(Token::Operator::Plus ) ||
+                                              token.isOperator(Token::Operator::Minus) ||
+                                              token.isOperator(Token::Operator::BitNot)))
+    {
+        op = _tk->next().asOperator();
+        current = Precedence::Unary;
+        result = create<AST::Expression>(op, flattenTerm(parseExpression(Precedence::Unary)));
+    }
     else
-        return AST::Node::create<AST::Expression>(_tk, op, parseUnary());
-}
+    {
+        /* `Power` chains are built out of components directly */
+        current = Precedence::Power;
+        result = create<AST::Expression>(parseComponent());
 
-std::shared_ptr<AST::Expression> Parser::parseFactor(void)
-{
-    /* build result expression */
-    Token::Operator op;
-    std::shared_ptr<AST::Expression> result = AST::Node::create<AST::Expression>(_tk, parseUnary());
+        /* operator chaining */
+        while (readOperator(op, Precedence::Power))
+            result->remains.push_back(*_arena, std::make_pair(op, AST::Expression::Term(parseComponent())));
+    }
+
+    /* climb up level by level, until reaching the requested level */
+    while (current > level)
+    {
+        /* move to next lower level */
+        current = static_cast<Precedence>(static_cast<int>(current) - 1);
+        token = _tk->peek();
+
+        /* unary levels, and binary levels without an operator simply pass through */
+        if (!token.is<Token::Type::Operators>() ||
+            ((Precedences[static_cast<size_t>(token.asOperator())] != current) &&
+             ((current != Precedence::Relations) || (token.asOperator() != Token::Operator::BoolNot))))
+            continue;
+
+        /* a bare component can be reused as the chain node, otherwise wrap the previous level */
+        Precedence next = static_cast<Precedence>(static_cast<int>(current) + 1);
+        if (!isPassThrough(result)) result = create<AST::Expression>(result);
+
+        /* relation operators need to be treated seperately, so mark here */
+        if (current != Precedence::Relations)
+        {
+            /* operator chaining, operands are expressions of the next higher level */
+            while (readOperator(op, current))
+                result->remains.push_back(*_arena, std::make_pair(op, flattenTerm(parseExpression(next))));
+        }
+        else
+        {
+            for (result->isRelations = true;;)
+            {
+                if (skipOperator(Token::Operator::BoolNot))
+                {
+                    expect(Token::Operator::In);
+                    result->remains.push_back(*_arena, std::make_pair(Token::Operator::NotIn, flattenTerm(parseExpression(next))));
+                }
+                else
+                {
+                    if (!readOperator(op, Precedence::Relations))
+                        break;
 
-    /* operator chaining */
-    while (readOperators(op, { Token::Operator::Multiply, Token::Operator::Divide, Token::Operator::Module }))
-        result->remains.push_back(std::make_pair(op, AST::Node::create<AST::Expression>(_tk, parseUnary())));
+                    if ((op != Token::Operator::Is) || !skipOperator(Token::Operator::BoolNot))
+                        result->remains.push_back(*_arena, std::make_pair(op, flattenTerm(parseExpression(next))));
+                    else
+                        result->remains.push_back(*_arena, std::make_pair(Token::Operator::IsNot, flattenTerm(parseExpression(next))));
+                }
+            }
+        }
+    }
 
     return result;
 }
 
-std::shared_ptr<AST::Expression> Parser::parseTerm(void)
-{
-    /* build result expression */
-    Token::Operator op;
-    std::shared_ptr<AST::Expression> result = AST::Node::create<AST::Expression>(_tk, parseFactor());
-
-    /* operator chaining */
-    while (readOperators(op, { Token::Operator::Plus, Token::Operator::Minus }))
-        result->remains.push_back(std::make_pair(op, AST::Node::create<AST::Expression>(_tk, parseFactor())));
+/** parser wrapper method **/
 
+AST::Statement *Parser::parseTopLevel(void)
+{
+    /* nodes are located relative to the top-level statement they belong to, which is located where it begins */
+    _tk->peek();
+    _base = _tk->offset();
+
+    /* so is the statement itself, relative to the source */
+    AST::Statement *result = parseStatement();
+    result->offset += static_cast<uint32_t>(_base);
+    _base = 0;
     return result;
 }
 
-std::shared_ptr<AST::Expression> Parser::parseBitShift(void)
+std::shared_ptr<AST::Node> Parser::parseUntil(size_t end, bool &stopped)
 {
-    /* build result expression */
-    Token::Operator op;
-    std::shared_ptr<AST::Expression> result = AST::Node::create<AST::Expression>(_tk, parseTerm());
+    _arena = std::make_shared<Arena>();
+    _arena->create<std::shared_ptr<SymbolTable>>(_tk->symbols());
 
-    /* operator chaining */
-    while (readOperators(op, { Token::Operator::ShiftLeft, Token::Operator::ShiftRight }))
-        result->remains.push_back(std::make_pair(op, AST::Node::create<AST::Expression>(_tk, parseTerm())));
+    /* located at the first token, just like `parse()` */
+    _tk->peekOrLine();
+    AST::Compond *result = create<AST::Compond>();
 
-    return result;
+    /* tokens are read on demand, nothing beyond the chunk is ever needed */
+    Token token = _tk->peek();
+
+    for (; !token.is<Token::Type::Eof>() && (token.offset() <= end); token = _tk->peek())
+        result->statements.push_back(parseTopLevel());
+
+    /* running out of tokens means the last statement went beyond `end` */
+    stopped = !token.is<Token::Type::Eof>();
+    return std::shared_ptr<AST::Node>(_arena, result);
 }
 
-std::shared_ptr<AST::Expression> Parser::parseBitAnd(void)
+size_t Parser::tokensUntil(size_t end, bool last)
 {
-    /* build result expression */
-    Token::Operator op;
-    std::shared_ptr<AST::Expression> result = AST::Node::create<AST::Expression>(_tk, parseBitShift());
+    /* the last chunk has every token, `EOF` included */
+    if (last)
+        return _tk->count();
 
-    /* operator chaining */
-    while (readOperators(op, { Token::Operator::BitAnd }))
-        result->remains.push_back(std::make_pair(op, AST::Node::create<AST::Expression>(_tk, parseBitShift())));
+    /* new-lines right before the cut were skipped when looking for the next statement, but they're still this chunk's */
+    size_t index = _tk->index();
+    while (!_tk->fetch(index).is<Token::Type::Eof>() && (_tk->fetch(index).offset() <= end))
+        index++;
 
-    return result;
+    return index;
 }
 
-std::shared_ptr<AST::Expression> Parser::parseBitXor(void)
+std::shared_ptr<AST::Node> Parser::parse(void)
 {
-    /* build result expression */
-    Token::Operator op;
-    std::shared_ptr<AST::Expression> result = AST::Node::create<AST::Expression>(_tk, parseBitAnd());
+    /* each parse result gets an arena of it's own, names in the tree point into the symbol table, so keep it alive as well */
+    _arena = std::make_shared<Arena>();
+    _arena->create<std::shared_ptr<SymbolTable>>(_tk->symbols());
+
+    /* nothing from previous parses can be reused */
+    _root = nullptr;
+    _spans.clear();
+    _names.clear();
+    _nodes = 0;
+    _base = 0;
+    _tokens = 0;
+    _generation = 0;
+
+    /* the whole source is resident anyway, tokenize it once up front, streams are only read as far as the parser looks,
+     * and tokens of a finished statement are released, unless deferred bodies may still need them */
+    bool release = _tk->streaming() && !_lazy;
+    AST::Compond *result = create<AST::Compond>();
+
+    if (!_tk->streaming())
+        _tk->tokenize();
+
+    try
+    {
+        while (!_tk->peek().is<Token::Type::Eof>())
+        {
+            size_t begin = _tk->index();
+            size_t first = _nodes;
 
-    /* operator chaining */
-    while (readOperators(op, { Token::Operator::BitXor }))
-        result->remains.push_back(std::make_pair(op, AST::Node::create<AST::Expression>(_tk, parseBitAnd())));
+            /* remember what each statement is made of, for `reparse()` */
+            result->statements.push_back(parseTopLevel());
+            _spans.push_back(Span { begin, _tk->index(), _tk->furthest(), result->statements.back()->offset, _nodes - first });
 
-    return result;
+            /* top-level statements are never backtracked into */
+            if (release)
+                _tk->release(_tk->index());
+        }
+    }
+    catch (Exception::SyntaxError &e)
+    {
+        /* errors raised by tokens only carry an offset, resolve it against the source */
+        if (!e.isResolved()) e.resolve(_tk->row(e.offset()), _tk->col(e.offset()));
+        throw;
+    }
+
+    /* the tree shares ownership of the arena, all nodes are released at once with the last reference,
+     * deferred bodies are located by token indexes, which are not carried over by `reparse()` */
+    _root = _lazy ? nullptr : result;
+    return std::shared_ptr<AST::Node>(_arena, result);
 }
 
-std::shared_ptr<AST::Expression> Parser::parseBitOr(void)
+std::shared_ptr<AST::Node> Parser::parse(ThreadPool &pool)
 {
-    /* build result expression */
-    Token::Operator op;
-    std::shared_ptr<AST::Expression> result = AST::Node::create<AST::Expression>(_tk, parseBitXor());
+    std::vector<std::future<void>> tasks;
+    std::vector<std::pair<size_t, size_t>> ranges = _tk->split(pool.size() * ChunksPerWorker, MinChunkSize);
+
+    /* not worth it, or deferred bodies need the tokens of the whole source to stay here */
+    if (_lazy || (ranges.size() < 2))
+        return parse();
+
+    /* each chunk stops right before the next one, unless it's last statement runs into it */
+    std::unique_ptr<bool[]> stopped(new bool[ranges.size()]);
+    std::vector<std::shared_ptr<AST::Node>> chunks(ranges.size());
+    std::vector<std::shared_ptr<SymbolTable>> tables(ranges.size());
+    std::vector<std::vector<AST::Name *>> names(ranges.size());
+    std::vector<size_t> nodes(ranges.size());
+    std::vector<size_t> tokens(ranges.size());
+
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        tasks.push_back(pool.submit([&, i]
+        {
+            /* every chunk gets a tokenizer, an arena and a symbol table of it's own, so chunks never contend */
+            size_t end = (i + 1 < ranges.size()) ? ranges[i + 1].first : ranges[i].second;
+            tables[i] = std::make_shared<SymbolTable>();
+            Parser parser(std::make_shared<Tokenizer>(*_tk, ranges[i].first, ranges[i].second, tables[i]));
+            parser.setMaxDepth(_maxDepth);
+            chunks[i] = parser.parseUntil(end, stopped[i]);
+            names[i] = std::move(parser._names);
+            nodes[i] = parser._nodes;
+            tokens[i] = parser.tokensUntil(end, i + 1 == ranges.size());
+        }));
+    }
 
-    /* operator chaining */
-    while (readOperators(op, { Token::Operator::BitOr }))
-        result->remains.push_back(std::make_pair(op, AST::Node::create<AST::Expression>(_tk, parseBitXor())));
+    /* every task refers to locals, wait for all of them before anything is thrown */
+    for (std::future<void> &task : tasks)
+        task.wait();
 
-    return result;
-}
+    try
+    {
+        for (std::future<void> &task : tasks)
+            task.get();
+    }
+    catch (Exception::SyntaxError &)
+    {
+        /* rows and columns are not tracked in chunks, parse again to report the error properly */
+        return parse();
+    }
 
-std::shared_ptr<AST::Expression> Parser::parseRelations(void)
-{
-    /* build result expression */
-    Token::Operator op;
-    std::shared_ptr<AST::Expression> result = AST::Node::create<AST::Expression>(_tk, parseBitXor());
+    /* a statement which runs across a cut is parsed differently in chunks, parse again as a whole */
+    for (size_t i = 0; i + 1 < ranges.size(); i++)
+        if (!stopped[i])
+            return parse();
 
-    /* operator chaining */
-    for (;;)
+    /* merged in order, names are registered exactly when a parse of the whole source would have registered them,
+     * only distinct names of each chunk are looked up, then it's names are pointed to the merged symbols */
+    for (size_t i = 0; i < ranges.size(); i++)
     {
-        if (skipOperator(Token::Operator::BoolNot))
-        {
-            expect(Token::Operator::In);
-            result->remains.push_back(std::make_pair(Token::Operator::NotIn, AST::Node::create<AST::Expression>(_tk, parseBitXor())));
-        }
-        else
-        {
-            if (!readOperators(op, {
-                Token::Operator::Is,
-                Token::Operator::In,
-                Token::Operator::Leq,
-                Token::Operator::Geq,
-                Token::Operator::Neq,
-                Token::Operator::Equ,
-                Token::Operator::Less,
-                Token::Operator::Greater }))
-                break;
+        std::vector<const Symbol *> symbols = _tk->symbols()->merge(*tables[i]);
 
-            if ((op != Token::Operator::Is) || !skipOperator(Token::Operator::BoolNot))
-                result->remains.push_back(std::make_pair(op, AST::Node::create<AST::Expression>(_tk, parseBitXor())));
-            else
-                result->remains.push_back(std::make_pair(Token::Operator::IsNot, AST::Node::create<AST::Expression>(_tk, parseBitXor())));
-        }
+        for (AST::Name *name : names[i])
+            name->symbol = symbols[name->symbol->id];
     }
 
-    /* relation operators need to be treated seperately, so mark here */
-    result->isRelations = true;
-    return result;
-}
+    /* the stitched tree owns all the chunks, which in turn own their arenas, and the symbol table, just like `parse()` */
+    _arena = std::make_shared<Arena>();
+    _arena->create<std::shared_ptr<SymbolTable>>(_tk->symbols());
+    _root = nullptr;
+    _spans.clear();
+    _names.clear();
+    _nodes = 1;
+    _base = 0;
+    _tokens = 0;
+    _generation = 0;
+
+    /* the first chunk always has the first token, which locates the root */
+    AST::Compond *result = _arena->create<AST::Compond>();
+    result->offset = chunks.front()->offset;
+
+    /* roots of chunks are the first node of each of them, they're replaced by this one, tokens of each chunk are the
+     * ones it's statements consumed, the last one has `EOF` as well */
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        _tokens += tokens[i];
+        const std::vector<AST::Statement *> &statements = static_cast<AST::Compond *>(chunks[i].get())->statements;
+        _arena->create<std::shared_ptr<AST::Node>>(chunks[i]);
+        _nodes += nodes[i] - 1;
+        result->statements.insert(result->statements.end(), statements.begin(), statements.end());
+    }
 
-std::shared_ptr<AST::Expression> Parser::parseBoolNot(void)
-{
-    /* recursively parsing `BoolNot` operator */
-    if (!skipOperator(Token::Operator::BoolNot))
-        return parseRelations();
-    else
-        return AST::Node::create<AST::Expression>(_tk, Token::Operator::BoolNot, parseBoolNot());
+    return std::shared_ptr<AST::Node>(_arena, result);
 }
 
-std::shared_ptr<AST::Expression> Parser::parseBoolAnd(void)
+AST::Statement *Parser::parseDeferred(AST::Define *define)
 {
-    /* build result expression */
-    Token::Operator op;
-    std::shared_ptr<AST::Expression> result = AST::Node::create<AST::Expression>(_tk, parseBoolNot());
+    /* parsed already, or never deferred */
+    if (define->body != nullptr)
+        return define->body;
 
-    /* operator chaining */
-    while (readOperators(op, { Token::Operator::BoolAnd }))
-        result->remains.push_back(std::make_pair(op, AST::Node::create<AST::Expression>(_tk, parseBoolNot())));
+    /* go back to where the body was, and come back afterwards */
+    Tokenizer::State state = _tk->save();
+    _tk->seek(define->bodyBegin);
 
-    return result;
+    /* nodes of the body are located relative to the top-level statement it belongs to, the last one beginning before it */
+    auto span = std::upper_bound(_spans.begin(), _spans.end(), define->bodyBegin, [](size_t x, const Span &y){ return x < y.begin; });
+    _base = (span == _spans.begin()) ? 0 : span[-1].base;
+
+    try
+    {
+        define->body = parseStatement();
+    }
+    catch (Exception::SyntaxError &e)
+    {
+        /* errors raised by tokens only carry an offset, resolve it against the source */
+        if (!e.isResolved()) e.resolve(_tk->row(e.offset()), _tk->col(e.offset()));
+        _tk->restore(state);
+        _base = 0;
+        throw;
+    }
+
+    _tk->restore(state);
+    _base = 0;
+    return define->body;
 }
 
-std::shared_ptr<AST::Expression> Parser::parseBoolOr(void)
+std::shared_ptr<AST::Node> Parser::reparse(const std::string &source, size_t offset, size_t removed)
 {
-    /* build result expression */
-    Token::Operator op;
-    std::shared_ptr<AST::Expression> result = AST::Node::create<AST::Expression>(_tk, parseBoolAnd());
+    /* nothing to reuse, too many arenas retained already, or the previous source was never resident */
+    if ((_root == nullptr) || (_generation >= MaxGenerations) || _tk->streaming())
+    {
+        _tk = std::make_shared<Tokenizer>(source, _tk->symbols());
+        return parse();
+    }
 
-    /* operator chaining */
-    while (readOperators(op, { Token::Operator::BoolOr }))
-        result->remains.push_back(std::make_pair(op, AST::Node::create<AST::Expression>(_tk, parseBoolAnd())));
+    /* everything of the previous parse, a failed reparse leaves nothing to reuse */
+    size_t nodes = _nodes;
+    AST::Compond *root = _root;
+    std::shared_ptr<Arena> arena = std::move(_arena);
 
-    return result;
-}
+    _root = nullptr;
+    _names.clear();
+    _nodes = 0;
+    _base = 0;
+    _tokens = 0;
 
-/** parser wrapper method **/
+    /* statements before the edit are reused as-is, as long as everything they looked at is unchanged */
+    size_t kept = _tk->unchanged(offset);
+    size_t i = std::lower_bound(_spans.begin(), _spans.end(), kept, [](const Span &x, size_t y){ return x.furthest < y; }) - _spans.begin();
 
-std::shared_ptr<AST::Node> Parser::parse(void)
-{
-    std::shared_ptr<AST::Compond> result = AST::Node::create<AST::Compond>(_tk);
-    while (!_tk->peek()->is<Token::Type::Eof>()) result->statements.push_back(parseStatement());
-    return result;
+    /* parsing continues right after them */
+    size_t begin = i ? _spans[i - 1].end : 0;
+
+    try
+    {
+        /* tokens around the edit are read again, the rest are left where they are */
+        _tk = std::make_shared<Tokenizer>(_tk, source, offset, removed, begin);
+    }
+    catch (Exception::SyntaxError &)
+    {
+        /* invalid tokens are reported exactly like a full parse does */
+        _tk = std::make_shared<Tokenizer>(source, _tk->symbols());
+        return parse();
+    }
+
+    /* reused nodes still live in the previous arena, keep it alive as long as the new one */
+    _arena = std::make_shared<Arena>();
+    _arena->create<std::shared_ptr<SymbolTable>>(_tk->symbols());
+    _arena->create<std::shared_ptr<Arena>>(arena);
+    _generation++;
+
+    size_t j = i;
+    bool reused = false;
+    const Tokenizer::Reuse &reuse = _tk->reuse();
+
+    /* statements around the edit are parsed aside, the previous tree is only changed once they all succeeded */
+    std::vector<Span> spans;
+    std::vector<AST::Statement *> statements;
+
+    try
+    {
+        for (_tk->seek(begin); !_tk->peek().is<Token::Type::Eof>();)
+        {
+            /* statements after the edit (and the token before them) are moved, skip the ones already passed */
+            while ((j < _spans.size()) && ((_spans[j].begin <= reuse.moved) || (_spans[j].begin + reuse.shift < _tk->index())))
+                j++;
+
+            /* reached the beginning of one of them, it and all the following statements are reused as well */
+            if ((j < _spans.size()) && (_spans[j].begin + reuse.shift == _tk->index()))
+            {
+                reused = true;
+                break;
+            }
+
+            size_t from = _tk->index();
+            size_t first = _nodes;
+
+            statements.push_back(parseTopLevel());
+            spans.push_back(Span { from, _tk->index(), _tk->furthest(), statements.back()->offset, _nodes - first });
+        }
+    }
+    catch (Exception::SyntaxError &e)
+    {
+        /* errors raised by tokens only carry an offset, resolve it against the source */
+        if (!e.isResolved()) e.resolve(_tk->row(e.offset()), _tk->col(e.offset()));
+        _spans.clear();
+        throw;
+    }
+
+    /* the source ran out before any statement could be reused, none of the remaining ones are left */
+    if (!reused)
+        j = _spans.size();
+
+    /* nodes of the statements parsed again are replaced by the new ones */
+    for (size_t k = i; k < j; k++)
+        nodes -= _spans[k].nodes;
+
+    /* statements after the edit are moved along with the source, nodes in them are relative to the statement */
+    for (size_t k = j; k < _spans.size(); k++)
+    {
+        _spans[k].begin += reuse.shift;
+        _spans[k].end += reuse.shift;
+        _spans[k].furthest += reuse.shift;
+        _spans[k].base += reuse.delta;
+        root->statements[k]->offset += static_cast<uint32_t>(reuse.delta);
+    }
+
+    /* the previous root is the new one, with the statements around the edit replaced in place */
+    _spans.erase(_spans.begin() + i, _spans.begin() + j);
+    _spans.insert(_spans.begin() + i, spans.begin(), spans.end());
+    root->statements.erase(root->statements.begin() + i, root->statements.begin() + j);
+    root->statements.insert(root->statements.begin() + i, statements.begin(), statements.end());
+
+    _root = root;
+    _nodes += nodes;
+
+    /* the tree shares ownership of the arena, all nodes are released at once with the last reference */
+    return std::shared_ptr<AST::Node>(_arena, root);
 }
 }
 }
@@ -0,0 +1,1609 @@
+#include <vector>
+#include <utility>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+#include <initializer_list>
+
+#include "Serializer.h"
+
+namespace CommandScript
+{
+namespace Compiler
+{
+namespace
+{
+/* bump it whenever the layout, or the meaning of any field changes */
+static constexpr uint32_t Version = 5;
+static constexpr uint32_t ByteOrder = 0x01020304;
+static constexpr char Magic[8] = { 'C', 'S', 'A', 'S', 'T', '\r', '\n', '\0' };
+
+using Kind = Snapshot::Kind;
+using Record = Snapshot::Record;
+using String = Snapshot::String;
+
+template <typename NodeType> struct KindOf;
+template <> struct KindOf<AST::If        > { static constexpr Kind value = Kind::If        ; };
+template <> struct KindOf<AST::For       > { static constexpr Kind value = Kind::For       ; };
+template <> struct KindOf<AST::While     > { static constexpr Kind value = Kind::While     ; };
+template <> struct KindOf<AST::Define    > { static constexpr Kind value = Kind::Define    ; };
+template <> struct KindOf<AST::Import    > { static constexpr Kind value = Kind::Import    ; };
+template <> struct KindOf<AST::Try       > { static constexpr Kind value = Kind::Try       ; };
+template <> struct KindOf<AST::Except    > { static constexpr Kind value = Kind::Except    ; };
+template <> struct KindOf<AST::Assign    > { static constexpr Kind value = Kind::Assign    ; };
+template <> struct KindOf<AST::Delete    > { static constexpr Kind value = Kind::Delete    ; };
+template <> struct KindOf<AST::Inplace   > { static constexpr Kind value = Kind::Inplace   ; };
+template <> struct KindOf<AST::Sequence  > { static constexpr Kind value = Kind::Sequence  ; };
+template <> struct KindOf<AST::Compond   > { static constexpr Kind value = Kind::Compond   ; };
+template <> struct KindOf<AST::Statement > { static constexpr Kind value = Kind::Statement ; };
+template <> struct KindOf<AST::Break     > { static constexpr Kind value = Kind::Break     ; };
+template <> struct KindOf<AST::Raise     > { static constexpr Kind value = Kind::Raise     ; };
+template <> struct KindOf<AST::Return    > { static constexpr Kind value = Kind::Return    ; };
+template <> struct KindOf<AST::Continue  > { static constexpr Kind value = Kind::Continue  ; };
+template <> struct KindOf<AST::Name      > { static constexpr Kind value = Kind::Name      ; };
+template <> struct KindOf<AST::Index     > { static constexpr Kind value = Kind::Index     ; };
+template <> struct KindOf<AST::Invoke    > { static constexpr Kind value = Kind::Invoke    ; };
+template <> struct KindOf<AST::Attribute > { static constexpr Kind value = Kind::Attribute ; };
+template <> struct KindOf<AST::Map       > { static constexpr Kind value = Kind::Map       ; };
+template <> struct KindOf<AST::List      > { static constexpr Kind value = Kind::List      ; };
+template <> struct KindOf<AST::Tuple     > { static constexpr Kind value = Kind::Tuple     ; };
+template <> struct KindOf<AST::Unit      > { static constexpr Kind value = Kind::Unit      ; };
+template <> struct KindOf<AST::Pair      > { static constexpr Kind value = Kind::Pair      ; };
+template <> struct KindOf<AST::Constant  > { static constexpr Kind value = Kind::Constant  ; };
+template <> struct KindOf<AST::Component > { static constexpr Kind value = Kind::Component ; };
+template <> struct KindOf<AST::Expression> { static constexpr Kind value = Kind::Expression; };
+
+/* kinds of the child of statements, units and components, by their type */
+static constexpr Kind StatementKinds[] = {
+    Kind::If,
+    Kind::For,
+    Kind::Try,
+    Kind::While,
+    Kind::Compond,
+    Kind::Define,
+    Kind::Delete,
+    Kind::Import,
+    Kind::Break,
+    Kind::Raise,
+    Kind::Return,
+    Kind::Continue,
+    Kind::Assign,
+    Kind::Inplace,
+    Kind::Component,
+};
+
+static constexpr Kind UnitKinds[] = {
+    Kind::Map,
+    Kind::List,
+    Kind::Tuple,
+    Kind::Define,
+    Kind::Expression,
+};
+
+static constexpr Kind ComponentKinds[] = {
+    Kind::Name,
+    Kind::Pair,
+    Kind::Unit,
+    Kind::Constant,
+};
+
+/* layout of a snapshot, in this order, every section is a plain array, and stays aligned for it's items :
+ *
+ *   Header
+ *   Record   records[header.records]       in post-order, so the root is the last one
+ *   String   strings[header.strings]       ranges of the blob
+ *   uint32_t links  [header.links]         children of the records, see `Snapshot::Record`
+ *   char     blob   [header.blob]
+ *
+ * both names and string constants are stored only once */
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t order;
+    uint64_t hash;
+
+public:
+    /* what parsing the source counted, so loading the snapshot reports the same */
+    uint64_t tokens;
+    uint64_t nodes;
+
+public:
+    uint64_t records;
+    uint64_t strings;
+    uint64_t links;
+    uint64_t blob;
+};
+
+static_assert(sizeof(Header) == 72, "unexpected padding in `Header`");
+static_assert(sizeof(Record) == 16, "unexpected padding in `Record`");
+static_assert(sizeof(String) == 8, "unexpected padding in `String`");
+
+/* flag bits, meaning depends on the kind of record */
+static constexpr uint8_t FlagFirst  = 0x01;
+static constexpr uint8_t FlagSecond = 0x02;
+
+/* corrupted snapshots are simply rejected, never reported */
+struct Corrupted {};
+
+class Writer
+{
+    std::vector<Record> _records;
+    std::vector<String> _strings;
+    std::vector<uint32_t> _links;
+    std::string _blob;
+
+private:
+    /* both names and string constants are stored only once */
+    std::unordered_map<StringView, uint32_t> _index;
+
+public:
+    void write(FILE *fp, uint64_t hash, size_t tokens, size_t nodes) const;
+
+private:
+    uint32_t string(StringView value);
+
+private:
+    /* records are written after all their children, references to the children are collected before, since
+     * children may have children on their own, and links of a record must not interleave with the other's */
+    uint32_t end(Kind kind, uint32_t offset, const uint32_t *links, size_t size, uint16_t type, uint8_t flags);
+
+private:
+    template <typename NodeType>
+    uint32_t end(const NodeType *node, std::initializer_list<uint32_t> links, uint16_t type = 0, uint8_t flags = 0)
+    {
+        return end(KindOf<NodeType>::value, node->offset, links.begin(), links.size(), type, flags);
+    }
+
+    template <typename NodeType>
+    uint32_t end(const NodeType *node, const std::vector<uint32_t> &links, uint16_t type = 0, uint8_t flags = 0)
+    {
+        return end(KindOf<NodeType>::value, node->offset, links.data(), links.size(), type, flags);
+    }
+
+private:
+    /* names and constants have a value instead of links */
+    template <typename NodeType>
+    uint32_t value(const NodeType *node, uint16_t type, uint64_t value)
+    {
+        Record record = { KindOf<NodeType>::value, 0, type, node->offset, 0, 0 };
+        memcpy(&record.link, &value, sizeof(uint64_t));
+        _records.push_back(record);
+        return static_cast<uint32_t>(_records.size());
+    }
+
+public:
+    uint32_t add(const AST::If         *node);
+    uint32_t add(const AST::For        *node);
+    uint32_t add(const AST::While      *node);
+    uint32_t add(const AST::Define     *node);
+    uint32_t add(const AST::Import     *node);
+    uint32_t add(const AST::Try        *node);
+    uint32_t add(const AST::Except     *node);
+    uint32_t add(const AST::Assign     *node);
+    uint32_t add(const AST::Delete     *node);
+    uint32_t add(const AST::Inplace    *node);
+    uint32_t add(const AST::Sequence   *node);
+    uint32_t add(const AST::Compond    *node);
+    uint32_t add(const AST::Statement  *node);
+    uint32_t add(const AST::Break      *node);
+    uint32_t add(const AST::Raise      *node);
+    uint32_t add(const AST::Return     *node);
+    uint32_t add(const AST::Continue   *node);
+    uint32_t add(const AST::Name       *node);
+    uint32_t add(const AST::Index      *node);
+    uint32_t add(const AST::Invoke     *node);
+    uint32_t add(const AST::Attribute  *node);
+    uint32_t add(const AST::Map        *node);
+    uint32_t add(const AST::List       *node);
+    uint32_t add(const AST::Tuple      *node);
+    uint32_t add(const AST::Unit       *node);
+    uint32_t add(const AST::Pair       *node);
+    uint32_t add(const AST::Constant   *node);
+    uint32_t add(const AST::Component  *node);
+    uint32_t add(const AST::Expression *node);
+
+public:
+    uint32_t add(const AST::Node *node);
+    uint32_t add(const AST::Expression::Term &term);
+
+};
+
+/* sets of kinds, as bits */
+static constexpr uint32_t mask(Kind kind) { return (static_cast<uint8_t>(kind) < 32) ? uint32_t(1) << static_cast<uint8_t>(kind) : 0; }
+
+template <typename ... Kinds>
+static constexpr uint32_t mask(Kind kind, Kinds ... kinds) { return mask(kind) | mask(kinds ...); }
+
+/* sections of a mapped snapshot, with their sizes in items */
+struct Sections
+{
+    const Record *records;
+    size_t size;
+
+public:
+    const uint32_t *link;
+    size_t links;
+
+public:
+    const String *string;
+    size_t strings;
+
+public:
+    const char *blob;
+    uint64_t bytes;
+};
+
+/* checks a record right before it's decoded, every reference must refer to an earlier record of the expected kind */
+class Checker
+{
+    size_t _index = 0;
+    const Record *_records;
+
+private:
+    size_t _links;
+    const uint32_t *_link;
+
+private:
+    size_t _strings;
+    const String *_string;
+    uint64_t _blob;
+
+public:
+    explicit Checker(const Sections &sections) :
+        _records(sections.records),
+        _links(sections.links),
+        _link(sections.link),
+        _strings(sections.strings),
+        _string(sections.string),
+        _blob(sections.bytes) {}
+
+private:
+    /* `ref` must refer to an earlier record of one of `kinds`, so there can never be a cycle */
+    void ref(uint32_t ref, uint32_t kinds, bool nullable = false) const
+    {
+        if (ref == 0)
+        {
+            if (nullable)
+                return;
+            else
+                throw Corrupted();
+        }
+
+        if ((ref > _index) || !(kinds & mask(_records[ref - 1].kind)))
+            throw Corrupted();
+    }
+
+private:
+    void op(uint32_t value) const;
+    void string(uint32_t index) const;
+    void type(uint16_t type, size_t count) const { if (type >= count) throw Corrupted(); }
+    void size(const Record &record, size_t least, bool exact = true) const;
+
+private:
+    void check(const Record &record);
+
+public:
+    void check(size_t index) { _index = index; check(_records[index]); }
+
+};
+
+/* decodes records into nodes, in a single forward pass */
+class Decoder
+{
+    Arena &_arena;
+    SymbolTable &_symbols;
+
+private:
+    Checker _checker;
+    const Sections &_sections;
+
+private:
+    std::vector<AST::Node *> _nodes;
+    std::vector<const Symbol *> _names;
+
+public:
+    explicit Decoder(const Sections &sections, Arena &arena, SymbolTable &symbols) :
+        _arena(arena),
+        _symbols(symbols),
+        _checker(sections),
+        _sections(sections),
+        _nodes(sections.size),
+        _names(sections.strings) {}
+
+private:
+    template <typename NodeType>
+    NodeType *node(uint32_t ref) const { return ref ? static_cast<NodeType *>(_nodes[ref - 1]) : nullptr; }
+
+private:
+    Kind kind(uint32_t ref) const { return _sections.records[ref - 1].kind; }
+    StringView string(const Record &record) const;
+
+private:
+    template <typename T>
+    T value(const Record &record) const
+    {
+        T result;
+        memcpy(&result, &record.link, sizeof(T));
+        return result;
+    }
+
+private:
+    const Symbol *symbol(const Record &record);
+    AST::Expression::Term term(uint32_t ref) const;
+
+private:
+    AST::Node *build(const Record &record);
+
+public:
+    AST::Node *decode(void);
+
+};
+
+/** Writer **/
+
+uint32_t Writer::string(StringView value)
+{
+    auto iter = _index.find(value);
+    if (iter != _index.end()) return iter->second;
+
+    /* new string, appended to the blob */
+    _strings.push_back(String { static_cast<uint32_t>(_blob.size()), static_cast<uint32_t>(value.size()) });
+    _blob.append(value.data(), value.size());
+    _index.emplace(value, static_cast<uint32_t>(_strings.size() - 1));
+    return static_cast<uint32_t>(_strings.size() - 1);
+}
+
+uint32_t Writer::end(Kind kind, uint32_t offset, const uint32_t *links, size_t size, uint16_t type, uint8_t flags)
+{
+    _records.push_back(Record { kind, flags, type, offset, static_cast<uint32_t>(_links.size()), static_cast<uint32_t>(size) });
+    _links.insert(_links.end(), links, links + size);
+    return static_cast<uint32_t>(_records.size());
+}
+
+void Writer::write(FILE *fp, uint64_t hash, size_t tokens, size_t nodes) const
+{
+    Header header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+
+    header.version = Version;
+    header.order = ByteOrder;
+    header.hash = hash;
+    header.tokens = tokens;
+    header.nodes = nodes;
+    header.records = _records.size();
+    header.strings = _strings.size();
+    header.links = _links.size();
+    header.blob = _blob.size();
+
+    /* every section is a plain array, written as-is */
+    if ((fwrite(&header, sizeof(Header), 1, fp) != 1) ||
+        (fwrite(_records.data(), sizeof(Record), _records.size(), fp) != _records.size()) ||
+        (fwrite(_strings.data(), sizeof(String), _strings.size(), fp) != _strings.size()) ||
+        (fwrite(_links.data(), sizeof(uint32_t), _links.size(), fp) != _links.size()) ||
+        (fwrite(_blob.data(), 1, _blob.size(), fp) != _blob.size()))
+        throw std::system_error(errno, std::generic_category());
+}
+
+uint32_t Writer::add(const AST::If *node)
+{
+    uint32_t expr = add(node->expr);
+    uint32_t positive = add(node->positive);
+    uint32_t negative = node->negative ? add(node->negative) : 0;
+    return end(node, { expr, positive, negative });
+}
+
+uint32_t Writer::add(const AST::For *node)
+{
+    uint32_t seq = add(node->seq);
+    uint32_t body = add(node->body);
+    uint32_t expr = add(node->expr);
+    return end(node, { seq, body, expr });
+}
+
+uint32_t Writer::add(const AST::While *node)
+{
+    uint32_t body = add(node->body);
+    uint32_t expr = add(node->expr);
+    return end(node, { body, expr });
+}
+
+uint32_t Writer::add(const AST::Define *node)
+{
+    std::vector<uint32_t> links(2);
+
+    /* there are no tokens to parse it from once saved */
+    if (node->body == nullptr)
+        throw std::invalid_argument("Deferred bodies can't be serialized");
+
+    for (const AST::Name *arg : node->args)
+        links.push_back(add(arg));
+
+    links[0] = node->name ? add(node->name) : 0;
+    links[1] = add(node->body);
+    return end(node, links);
+}
+
+uint32_t Writer::add(const AST::Import *node)
+{
+    std::vector<uint32_t> names;
+
+    for (const AST::Name *name : node->names)
+        names.push_back(add(name));
+
+    return end(node, names);
+}
+
+uint32_t Writer::add(const AST::Try *node)
+{
+    std::vector<uint32_t> links(2);
+
+    for (const AST::Except *except : node->excepts)
+        links.push_back(add(except));
+
+    links[0] = add(node->body);
+    links[1] = node->finally ? add(node->finally) : 0;
+    return end(node, links, 0, node->haveWildcard ? FlagFirst : 0);
+}
+
+uint32_t Writer::add(const AST::Except *node)
+{
+    std::vector<uint32_t> links(2);
+
+    /* groups of dotted names, each preceded by it's size */
+    for (const std::vector<AST::Name *> &names : node->exceptions)
+    {
+        links.push_back(static_cast<uint32_t>(names.size()));
+
+        for (const AST::Name *name : names)
+            links.push_back(add(name));
+    }
+
+    links[0] = add(node->body);
+    links[1] = node->target ? add(node->target) : 0;
+    return end(node, links, 0, node->isWildcard ? FlagFirst : 0);
+}
+
+uint32_t Writer::add(const AST::Assign *node)
+{
+    uint32_t tuple = add(node->tuple);
+    uint32_t target = add(node->target);
+    return end(node, { tuple, target }, 0, node->isSeq ? FlagFirst : 0);
+}
+
+uint32_t Writer::add(const AST::Delete *node)
+{
+    return end(node, { add(node->target) });
+}
+
+uint32_t Writer::add(const AST::Inplace *node)
+{
+    uint32_t target = add(node->target);
+    uint32_t expression = add(node->expression);
+    return end(node, { target, expression }, static_cast<uint16_t>(node->op));
+}
+
+uint32_t Writer::add(const AST::Sequence *node)
+{
+    std::vector<uint32_t> items;
+
+    /* items are told apart by the kind of records they refer to */
+    for (const AST::Sequence::Item &item : node->items)
+    {
+        switch (item.type)
+        {
+            case AST::Sequence::Type::SequenceSequence  : items.push_back(add(item.sequence )); break;
+            case AST::Sequence::Type::SequenceComponent : items.push_back(add(item.component)); break;
+        }
+    }
+
+    return end(node, items, 0, node->isSeq ? FlagFirst : 0);
+}
+
+uint32_t Writer::add(const AST::Compond *node)
+{
+    std::vector<uint32_t> statements;
+
+    for (const AST::Statement *statement : node->statements)
+        statements.push_back(add(statement));
+
+    return end(node, statements);
+}
+
+uint32_t Writer::add(const AST::Statement *node)
+{
+    uint32_t child = 0;
+
+    switch (node->type)
+    {
+        case AST::Statement::Type::StatementIf        : child = add(node->ifStatement       ); break;
+        case AST::Statement::Type::StatementFor       : child = add(node->forStatement      ); break;
+        case AST::Statement::Type::StatementTry       : child = add(node->tryStatement      ); break;
+        case AST::Statement::Type::StatementWhile     : child = add(node->whileStatement    ); break;
+        case AST::Statement::Type::StatementCompond   : child = add(node->compondStatement  ); break;
+
+        case AST::Statement::Type::StatementDefine    : child = add(node->defineStatement   ); break;
+        case AST::Statement::Type::StatementDelete    : child = add(node->deleteStatement   ); break;
+        case AST::Statement::Type::StatementImport    : child = add(node->importStatement   ); break;
+
+        case AST::Statement::Type::StatementBreak     : child = add(node->breakStatement    ); break;
+        case AST::Statement::Type::StatementRaise     : child = add(node->raiseStatement    ); break;
+        case AST::Statement::Type::StatementReturn    : child = add(node->returnStatement   ); break;
+        case AST::Statement::Type::StatementContinue  : child = add(node->continueStatement ); break;
+
+        case AST::Statement::Type::StatementAssign    : child = add(node->assignStatement   ); break;
+        case AST::Statement::Type::StatementInplace   : child = add(node->inplaceStatement  ); break;
+        case AST::Statement::Type::StatementComponent : child = add(node->componentStatement); break;
+    }
+
+    return end(node, { child }, static_cast<uint16_t>(node->type));
+}
+
+uint32_t Writer::add(const AST::Break *node)
+{
+    return end(node, {});
+}
+
+uint32_t Writer::add(const AST::Raise *node)
+{
+    return end(node, { add(node->expr) });
+}
+
+uint32_t Writer::add(const AST::Return *node)
+{
+    return end(node, { add(node->tuple) }, 0, node->isSeq ? FlagFirst : 0);
+}
+
+uint32_t Writer::add(const AST::Continue *node)
+{
+    return end(node, {});
+}
+
+uint32_t Writer::add(const AST::Name *node)
+{
+    return value(node, 0, string(node->symbol->name));
+}
+
+uint32_t Writer::add(const AST::Index *node)
+{
+    return end(node, { add(node->index) });
+}
+
+uint32_t Writer::add(const AST::Invoke *node)
+{
+    std::vector<uint32_t> args;
+
+    for (const AST::Expression *arg : node->args)
+        args.push_back(add(arg));
+
+    return end(node, args);
+}
+
+uint32_t Writer::add(const AST::Attribute *node)
+{
+    return end(node, { add(node->attribute) });
+}
+
+uint32_t Writer::add(const AST::Map *node)
+{
+    std::vector<uint32_t> items;
+
+    /* keys and values, interleaved */
+    for (const auto &item : node->items)
+    {
+        items.push_back(add(item.first));
+        items.push_back(add(item.second));
+    }
+
+    return end(node, items);
+}
+
+uint32_t Writer::add(const AST::List *node)
+{
+    std::vector<uint32_t> items;
+
+    for (const AST::Expression *item : node->items)
+        items.push_back(add(item));
+
+    return end(node, items);
+}
+
+uint32_t Writer::add(const AST::Tuple *node)
+{
+    std::vector<uint32_t> items;
+
+    for (const AST::Expression *item : node->items)
+        items.push_back(add(item));
+
+    return end(node, items);
+}
+
+uint32_t Writer::add(const AST::Unit *node)
+{
+    uint32_t child = 0;
+
+    switch (node->type)
+    {
+        case AST::Unit::Type::UnitMap        : child = add(node->map       ); break;
+        case AST::Unit::Type::UnitList       : child = add(node->list      ); break;
+        case AST::Unit::Type::UnitTuple      : child = add(node->tuple     ); break;
+        case AST::Unit::Type::UnitLambda     : child = add(node->lambda    ); break;
+        case AST::Unit::Type::UnitExpression : child = add(node->expression); break;
+    }
+
+    return end(node, { child }, static_cast<uint16_t>(node->type));
+}
+
+uint32_t Writer::add(const AST::Pair *node)
+{
+    uint32_t name = add(node->name);
+    uint32_t value = add(node->value);
+    return end(node, { name, value });
+}
+
+uint32_t Writer::add(const AST::Constant *node)
+{
+    uint64_t bits = 0;
+
+    switch (node->type)
+    {
+        case AST::Constant::Type::ConstantFloat   : memcpy(&bits, &node->floatValue, sizeof(uint64_t)); break;
+        case AST::Constant::Type::ConstantString  : bits = string(node->stringValue); break;
+        case AST::Constant::Type::ConstantInteger : memcpy(&bits, &node->integerValue, sizeof(uint64_t)); break;
+    }
+
+    return value(node, static_cast<uint16_t>(node->type), bits);
+}
+
+uint32_t Writer::add(const AST::Component *node)
+{
+    std::vector<uint32_t> links(1);
+
+    switch (node->type)
+    {
+        case AST::Component::Type::ComponentName     : links[0] = add(node->name    ); break;
+        case AST::Component::Type::ComponentPair     : links[0] = add(node->pair    ); break;
+        case AST::Component::Type::ComponentUnit     : links[0] = add(node->unit    ); break;
+        case AST::Component::Type::ComponentConstant : links[0] = add(node->constant); break;
+    }
+
+    /* modifiers are told apart by the kind of records they refer to */
+    for (const AST::Component::Modifier &modifier : node->modifiers)
+    {
+        switch (modifier.type)
+        {
+            case AST::Component::ModType::ModifierIndex     : links.push_back(add(modifier.index    )); break;
+            case AST::Component::ModType::ModifierInvoke    : links.push_back(add(modifier.invoke   )); break;
+            case AST::Component::ModType::ModifierAttribute : links.push_back(add(modifier.attribute)); break;
+        }
+    }
+
+    return end(node, links, static_cast<uint16_t>(node->type), node->isStandalone ? FlagFirst : 0);
+}
+
+uint32_t Writer::add(const AST::Expression *node)
+{
+    std::vector<uint32_t> links { add(node->first) };
+
+    /* operands, each preceded by their operator */
+    for (const auto &remain : node->remains)
+    {
+        uint32_t term = add(remain.second);
+        links.push_back(static_cast<uint32_t>(remain.first));
+        links.push_back(term);
+    }
+
+    return end(node, links,
+               node->isUnary ? static_cast<uint16_t>(node->op) : 0,
+               (node->isUnary ? FlagFirst : 0) | (node->isRelations ? FlagSecond : 0));
+}
+
+uint32_t Writer::add(const AST::Expression::Term &term)
+{
+    switch (term.type)
+    {
+        case AST::Expression::Type::TermComponent  : return add(term.component);
+        case AST::Expression::Type::TermExpression : return add(term.expression);
+    }
+
+    /* never happens */
+    throw std::invalid_argument("Invalid expression term");
+}
+
+uint32_t Writer::add(const AST::Node *node)
+{
+    /* roots are usually compond statements, the others are rare enough to be simply probed */
+    if (auto value = dynamic_cast<const AST::Compond    *>(node)) return add(value);
+    if (auto value = dynamic_cast<const AST::Statement  *>(node)) return add(value);
+    if (auto value = dynamic_cast<const AST::Expression *>(node)) return add(value);
+    if (auto value = dynamic_cast<const AST::Component  *>(node)) return add(value);
+
+    throw std::invalid_argument("Only statements, expressions and components can be serialized as a root");
+}
+
+/** Checker **/
+
+void Checker::op(uint32_t value) const
+{
+    if (value > static_cast<uint32_t>(Token::Operator::Decorator))
+        throw Corrupted();
+}
+
+void Checker::string(uint32_t index) const
+{
+    if (index >= _strings)
+        throw Corrupted();
+
+    if (uint64_t(_string[index].offset) + _string[index].size > _blob)
+        throw Corrupted();
+}
+
+void Checker::size(const Record &record, size_t least, bool exact) const
+{
+    if (exact ? (record.size != least) : (record.size < least))
+        throw Corrupted();
+}
+
+void Checker::check(const Record &record)
+{
+    /* names and constants have no links */
+    if (record.kind == Kind::Name)
+    {
+        string(record.link);
+        return;
+    }
+
+    if (record.kind == Kind::Constant)
+    {
+        type(record.type, 3);
+
+        if (static_cast<AST::Constant::Type>(record.type) == AST::Constant::Type::ConstantString)
+            string(record.link);
+
+        return;
+    }
+
+    /* links of every other kind must be in the table */
+    if (uint64_t(record.link) + record.size > _links)
+        throw Corrupted();
+
+    const uint32_t *links = _link + record.link;
+
+    switch (record.kind)
+    {
+        case Kind::If:
+        {
+            size(record, 3);
+            ref(links[0], mask(Kind::Expression));
+            ref(links[1], mask(Kind::Statement));
+            ref(links[2], mask(Kind::Statement), true);
+            break;
+        }
+
+        case Kind::For:
+        {
+            size(record, 3);
+            ref(links[0], mask(Kind::Sequence));
+            ref(links[1], mask(Kind::Statement));
+            ref(links[2], mask(Kind::Expression));
+            break;
+        }
+
+        case Kind::While:
+        {
+            size(record, 2);
+            ref(links[0], mask(Kind::Statement));
+            ref(links[1], mask(Kind::Expression));
+            break;
+        }
+
+        case Kind::Define:
+        {
+            size(record, 2, false);
+            ref(links[0], mask(Kind::Name), true);
+            ref(links[1], mask(Kind::Statement));
+
+            for (uint32_t i = 2; i < record.size; i++)
+                ref(links[i], mask(Kind::Name));
+
+            break;
+        }
+
+        case Kind::Import:
+        {
+            for (uint32_t i = 0; i < record.size; i++)
+                ref(links[i], mask(Kind::Name));
+
+            break;
+        }
+
+        case Kind::Try:
+        {
+            size(record, 2, false);
+            ref(links[0], mask(Kind::Statement));
+            ref(links[1], mask(Kind::Statement), true);
+
+            for (uint32_t i = 2; i < record.size; i++)
+                ref(links[i], mask(Kind::Except));
+
+            break;
+        }
+
+        case Kind::Except:
+        {
+            size(record, 2, false);
+            ref(links[0], mask(Kind::Statement));
+            ref(links[1], mask(Kind::Component), true);
+
+            /* groups of dotted names, each preceded by it's size */
+            for (uint32_t i = 2; i < record.size;)
+            {
+                uint32_t count = links[i++];
+
+                if (count > record.size - i)
+                    throw Corrupted();
+
+                for (; count; count--)
+                    ref(links[i++], mask(Kind::Name));
+            }
+
+            break;
+        }
+
+        case Kind::Assign:
+        {
+            size(record, 2);
+            ref(links[0], mask(Kind::Tuple));
+            ref(links[1], mask(Kind::Sequence));
+            break;
+        }
+
+        case Kind::Delete:
+        {
+            size(record, 1);
+            ref(links[0], mask(Kind::Component));
+            break;
+        }
+
+        case Kind::Inplace:
+        {
+            op(record.type);
+            size(record, 2);
+            ref(links[0], mask(Kind::Component));
+            ref(links[1], mask(Kind::Expression));
+            break;
+        }
+
+        case Kind::Sequence:
+        {
+            for (uint32_t i = 0; i < record.size; i++)
+                ref(links[i], mask(Kind::Sequence, Kind::Component));
+
+            break;
+        }
+
+        case Kind::Compond:
+        {
+            for (uint32_t i = 0; i < record.size; i++)
+                ref(links[i], mask(Kind::Statement));
+
+            break;
+        }
+
+        case Kind::Statement:
+        {
+            type(record.type, sizeof(StatementKinds) / sizeof(StatementKinds[0]));
+            size(record, 1);
+            ref(links[0], mask(StatementKinds[record.type]));
+            break;
+        }
+
+        case Kind::Break:
+        case Kind::Continue:
+        {
+            size(record, 0);
+            break;
+        }
+
+        case Kind::Raise:
+        {
+            size(record, 1);
+            ref(links[0], mask(Kind::Expression));
+            break;
+        }
+
+        case Kind::Return:
+        {
+            size(record, 1);
+            ref(links[0], mask(Kind::Tuple));
+            break;
+        }
+
+        case Kind::Index:
+        {
+            size(record, 1);
+            ref(links[0], mask(Kind::Expression));
+            break;
+        }
+
+        case Kind::Attribute:
+        {
+            size(record, 1);
+            ref(links[0], mask(Kind::Name));
+            break;
+        }
+
+        /* keys and values of maps are interleaved */
+        case Kind::Map:
+        case Kind::List:
+        case Kind::Tuple:
+        case Kind::Invoke:
+        {
+            if ((record.kind == Kind::Map) && (record.size % 2))
+                throw Corrupted();
+
+            for (uint32_t i = 0; i < record.size; i++)
+                ref(links[i], mask(Kind::Expression));
+
+            break;
+        }
+
+        case Kind::Unit:
+        {
+            type(record.type, sizeof(UnitKinds) / sizeof(UnitKinds[0]));
+            size(record, 1);
+            ref(links[0], mask(UnitKinds[record.type]));
+            break;
+        }
+
+        case Kind::Pair:
+        {
+            size(record, 2);
+            ref(links[0], mask(Kind::Name));
+            ref(links[1], mask(Kind::Expression));
+            break;
+        }
+
+        case Kind::Component:
+        {
+            type(record.type, sizeof(ComponentKinds) / sizeof(ComponentKinds[0]));
+            size(record, 1, false);
+            ref(links[0], mask(ComponentKinds[record.type]));
+
+            for (uint32_t i = 1; i < record.size; i++)
+                ref(links[i], mask(Kind::Index, Kind::Invoke, Kind::Attribute));
+
+            break;
+        }
+
+        case Kind::Expression:
+        {
+            if (record.flags & FlagFirst)
+                op(record.type);
+
+            /* the first term, then operands, each preceded by their operator */
+            if ((record.size % 2) == 0)
+                throw Corrupted();
+
+            ref(links[0], mask(Kind::Component, Kind::Expression));
+
+            for (uint32_t i = 1; i < record.size; i += 2)
+            {
+                op(links[i]);
+                ref(links[i + 1], mask(Kind::Component, Kind::Expression));
+            }
+
+            break;
+        }
+
+        /* unknown kind */
+        default:
+            throw Corrupted();
+    }
+}
+
+/** Decoder **/
+
+StringView Decoder::string(const Record &record) const
+{
+    const String &string = _sections.string[record.link];
+    return StringView(_sections.blob + string.offset, string.size);
+}
+
+const Symbol *Decoder::symbol(const Record &record)
+{
+    /* each distinct name is interned only once */
+    if (_names[record.link] == nullptr)
+        _names[record.link] = _symbols.intern(string(record));
+
+    return _names[record.link];
+}
+
+AST::Expression::Term Decoder::term(uint32_t ref) const
+{
+    if (kind(ref) == Kind::Component)
+        return AST::Expression::Term(node<AST::Component>(ref));
+    else
+        return AST::Expression::Term(node<AST::Expression>(ref));
+}
+
+AST::Node *Decoder::build(const Record &record)
+{
+    const uint32_t *links = _sections.link + record.link;
+
+    switch (record.kind)
+    {
+        case Kind::If:
+        {
+            AST::If *result = _arena.create<AST::If>();
+            result->expr = node<AST::Expression>(links[0]);
+            result->positive = node<AST::Statement>(links[1]);
+            result->negative = node<AST::Statement>(links[2]);
+            return result;
+        }
+
+        case Kind::For:
+        {
+            AST::For *result = _arena.create<AST::For>();
+            result->seq = node<AST::Sequence>(links[0]);
+            result->body = node<AST::Statement>(links[1]);
+            result->expr = node<AST::Expression>(links[2]);
+            return result;
+        }
+
+        case Kind::While:
+        {
+            AST::While *result = _arena.create<AST::While>();
+            result->body = node<AST::Statement>(links[0]);
+            result->expr = node<AST::Expression>(links[1]);
+            return result;
+        }
+
+        case Kind::Define:
+        {
+            AST::Define *result = _arena.create<AST::Define>();
+            result->name = node<AST::Name>(links[0]);
+            result->body = node<AST::Statement>(links[1]);
+            result->args.reserve(record.size - 2);
+
+            for (uint32_t i = 2; i < record.size; i++)
+                result->args.push_back(node<AST::Name>(links[i]));
+
+            return result;
+        }
+
+        case Kind::Import:
+        {
+            AST::Import *result = _arena.create<AST::Import>();
+            result->names.reserve(record.size);
+
+            for (uint32_t i = 0; i < record.size; i++)
+                result->names.push_back(node<AST::Name>(links[i]));
+
+            return result;
+        }
+
+        case Kind::Try:
+        {
+            AST::Try *result = _arena.create<AST::Try>();
+            result->haveWildcard = (record.flags & FlagFirst) != 0;
+            result->body = node<AST::Statement>(links[0]);
+            result->finally = node<AST::Statement>(links[1]);
+            result->excepts.reserve(record.size - 2);
+
+            for (uint32_t i = 2; i < record.size; i++)
+                result->excepts.push_back(node<AST::Except>(links[i]));
+
+            return result;
+        }
+
+        case Kind::Except:
+        {
+            AST::Except *result = _arena.create<AST::Except>();
+            result->isWildcard = (record.flags & FlagFirst) != 0;
+            result->body = node<AST::Statement>(links[0]);
+            result->target = node<AST::Component>(links[1]);
+
+            /* groups of dotted names, each preceded by it's size */
+            for (uint32_t i = 2; i < record.size;)
+            {
+                uint32_t count = links[i++];
+                result->exceptions.emplace_back();
+
+                for (; count; count--)
+                    result->exceptions.back().push_back(node<AST::Name>(links[i++]));
+            }
+
+            return result;
+        }
+
+        case Kind::Assign:
+        {
+            AST::Assign *result = _arena.create<AST::Assign>();
+            result->isSeq = (record.flags & FlagFirst) != 0;
+            result->tuple = node<AST::Tuple>(links[0]);
+            result->target = node<AST::Sequence>(links[1]);
+            return result;
+        }
+
+        case Kind::Delete:
+        {
+            AST::Delete *result = _arena.create<AST::Delete>();
+            result->target = node<AST::Component>(links[0]);
+            return result;
+        }
+
+        case Kind::Inplace:
+        {
+            AST::Inplace *result = _arena.create<AST::Inplace>();
+            result->op = static_cast<Token::Operator>(record.type);
+            result->target = node<AST::Component>(links[0]);
+            result->expression = node<AST::Expression>(links[1]);
+            return result;
+        }
+
+        case Kind::Sequence:
+        {
+            AST::Sequence *result = _arena.create<AST::Sequence>();
+            result->isSeq = (record.flags & FlagFirst) != 0;
+            result->items.reserve(record.size);
+
+            /* items are told apart by the kind of records they refer to */
+            for (uint32_t i = 0; i < record.size; i++)
+            {
+                if (kind(links[i]) == Kind::Sequence)
+                    result->items.emplace_back(node<AST::Sequence>(links[i]));
+                else
+                    result->items.emplace_back(node<AST::Component>(links[i]));
+            }
+
+            return result;
+        }
+
+        case Kind::Compond:
+        {
+            AST::Compond *result = _arena.create<AST::Compond>();
+            result->statements.reserve(record.size);
+
+            for (uint32_t i = 0; i < record.size; i++)
+                result->statements.push_back(node<AST::Statement>(links[i]));
+
+            return result;
+        }
+
+        case Kind::Statement:
+        {
+            AST::Statement *result = _arena.create<AST::Statement>();
+            result->type = static_cast<AST::Statement::Type>(record.type);
+
+            switch (result->type)
+            {
+                case AST::Statement::Type::StatementIf        : result->ifStatement        = node<AST::If       >(links[0]); break;
+                case AST::Statement::Type::StatementFor       : result->forStatement       = node<AST::For      >(links[0]); break;
+                case AST::Statement::Type::StatementTry       : result->tryStatement       = node<AST::Try      >(links[0]); break;
+                case AST::Statement::Type::StatementWhile     : result->whileStatement     = node<AST::While    >(links[0]); break;
+                case AST::Statement::Type::StatementCompond   : result->compondStatement   = node<AST::Compond  >(links[0]); break;
+
+                case AST::Statement::Type::StatementDefine    : result->defineStatement    = node<AST::Define   >(links[0]); break;
+                case AST::Statement::Type::StatementDelete    : result->deleteStatement    = node<AST::Delete   >(links[0]); break;
+                case AST::Statement::Type::StatementImport    : result->importStatement    = node<AST::Import   >(links[0]); break;
+
+                case AST::Statement::Type::StatementBreak     : result->breakStatement     = node<AST::Break    >(links[0]); break;
+                case AST::Statement::Type::StatementRaise     : result->raiseStatement     = node<AST::Raise    >(links[0]); break;
+                case AST::Statement::Type::StatementReturn    : result->returnStatement    = node<AST::Return   >(links[0]); break;
+                case AST::Statement::Type::StatementContinue  : result->continueStatement  = node<AST::Continue >(links[0]); break;
+
+                case AST::Statement::Type::StatementAssign    : result->assignStatement    = node<AST::Assign   >(links[0]); break;
+                case AST::Statement::Type::StatementInplace   : result->inplaceStatement   = node<AST::Inplace  >(links[0]); break;
+                case AST::Statement::Type::StatementComponent : result->componentStatement = node<AST::Component>(links[0]); break;
+            }
+
+            return result;
+        }
+
+        case Kind::Break:
+            return _arena.create<AST::Break>();
+
+        case Kind::Raise:
+        {
+            AST::Raise *result = _arena.create<AST::Raise>();
+            result->expr = node<AST::Expression>(links[0]);
+            return result;
+        }
+
+        case Kind::Return:
+        {
+            AST::Return *result = _arena.create<AST::Return>();
+            result->isSeq = (record.flags & FlagFirst) != 0;
+            result->tuple = node<AST::Tuple>(links[0]);
+            return result;
+        }
+
+        case Kind::Continue:
+            return _arena.create<AST::Continue>();
+
+        case Kind::Name:
+        {
+            AST::Name *result = _arena.create<AST::Name>();
+            result->symbol = symbol(record);
+            return result;
+        }
+
+        case Kind::Index:
+        {
+            AST::Index *result = _arena.create<AST::Index>();
+            result->index = node<AST::Expression>(links[0]);
+            return result;
+        }
+
+        case Kind::Invoke:
+        {
+            AST::Invoke *result = _arena.create<AST::Invoke>();
+            result->args.reserve(record.size);
+
+            for (uint32_t i = 0; i < record.size; i++)
+                result->args.push_back(node<AST::Expression>(links[i]));
+
+            return result;
+        }
+
+        case Kind::Attribute:
+        {
+            AST::Attribute *result = _arena.create<AST::Attribute>();
+            result->attribute = node<AST::Name>(links[0]);
+            return result;
+        }
+
+        case Kind::Map:
+        {
+            AST::Map *result = _arena.create<AST::Map>();
+            result->items.reserve(record.size / 2);
+
+            /* keys and values, interleaved */
+            for (uint32_t i = 0; i < record.size; i += 2)
+                result->items.emplace_back(node<AST::Expression>(links[i]), node<AST::Expression>(links[i + 1]));
+
+            return result;
+        }
+
+        case Kind::List:
+        {
+            AST::List *result = _arena.create<AST::List>();
+            result->items.reserve(record.size);
+
+            for (uint32_t i = 0; i < record.size; i++)
+                result->items.push_back(node<AST::Expression>(links[i]));
+
+            return result;
+        }
+
+        case Kind::Tuple:
+        {
+            AST::Tuple *result = _arena.create<AST::Tuple>();
+            result->items.reserve(record.size);
+
+            for (uint32_t i = 0; i < record.size; i++)
+                result->items.push_back(node<AST::Expression>(links[i]));
+
+            return result;
+        }
+
+        case Kind::Unit:
+        {
+            AST::Unit *result = _arena.create<AST::Unit>();
+            result->type = static_cast<AST::Unit::Type>(record.type);
+
+            switch (result->type)
+            {
+                case AST::Unit::Type::UnitMap        : result->map        = node<AST::Map       >(links[0]); break;
+                case AST::Unit::Type::UnitList       : result->list       = node<AST::List      >(links[0]); break;
+                case AST::Unit::Type::UnitTuple      : result->tuple      = node<AST::Tuple     >(links[0]); break;
+                case AST::Unit::Type::UnitLambda     : result->lambda     = node<AST::Define    >(links[0]); break;
+                case AST::Unit::Type::UnitExpression : result->expression = node<AST::Expression>(links[0]); break;
+            }
+
+            return result;
+        }
+
+        case Kind::Pair:
+        {
+            AST::Pair *result = _arena.create<AST::Pair>();
+            result->name = node<AST::Name>(links[0]);
+            result->value = node<AST::Expression>(links[1]);
+            return result;
+        }
+
+        case Kind::Constant:
+        {
+            AST::Constant *result = _arena.create<AST::Constant>();
+            result->type = static_cast<AST::Constant::Type>(record.type);
+
+            /* strings are left in the mapping, which the arena keeps alive */
+            switch (result->type)
+            {
+                case AST::Constant::Type::ConstantFloat   : result->floatValue = value<double>(record); break;
+                case AST::Constant::Type::ConstantString  : result->stringValue = string(record); break;
+                case AST::Constant::Type::ConstantInteger : result->integerValue = value<int64_t>(record); break;
+            }
+
+            return result;
+        }
+
+        case Kind::Component:
+        {
+            AST::Component *result = _arena.create<AST::Component>();
+            result->type = static_cast<AST::Component::Type>(record.type);
+            result->isStandalone = (record.flags & FlagFirst) != 0;
+
+            switch (result->type)
+            {
+                case AST::Component::Type::ComponentName     : result->name     = node<AST::Name    >(links[0]); break;
+                case AST::Component::Type::ComponentPair     : result->pair     = node<AST::Pair    >(links[0]); break;
+                case AST::Component::Type::ComponentUnit     : result->unit     = node<AST::Unit    >(links[0]); break;
+                case AST::Component::Type::ComponentConstant : result->constant = node<AST::Constant>(links[0]); break;
+            }
+
+            /* modifiers are told apart by the kind of records they refer to */
+            result->modifiers.reserve(_arena, record.size - 1);
+
+            for (uint32_t i = 1; i < record.size; i++)
+            {
+                switch (kind(links[i]))
+                {
+                    case Kind::Index     : result->modifiers.emplace_back(_arena, node<AST::Index    >(links[i])); break;
+                    case Kind::Invoke    : result->modifiers.emplace_back(_arena, node<AST::Invoke   >(links[i])); break;
+                    default              : result->modifiers.emplace_back(_arena, node<AST::Attribute>(links[i])); break;
+                }
+            }
+
+            return result;
+        }
+
+        case Kind::Expression:
+        {
+            AST::Expression *result;
+            AST::Expression::Term first = term(links[0]);
+
+            if (record.flags & FlagFirst)
+                result = _arena.create<AST::Expression>(static_cast<Token::Operator>(record.type), first);
+            else
+                result = _arena.create<AST::Expression>(first);
+
+            /* operands, each preceded by their operator */
+            result->isRelations = (record.flags & FlagSecond) != 0;
+            result->remains.reserve(_arena, record.size / 2);
+
+            for (uint32_t i = 1; i < record.size; i += 2)
+                result->remains.push_back(_arena, std::make_pair(static_cast<Token::Operator>(links[i]), term(links[i + 1])));
+
+            return result;
+        }
+    }
+
+    /* never happens, kinds are checked right before */
+    throw Corrupted();
+}
+
+AST::Node *Decoder::decode(void)
+{
+    /* children always come before their parents, so a single forward pass resolves everything */
+    for (size_t i = 0; i < _sections.size; i++)
+    {
+        const Record &record = _sections.records[i];
+
+        _checker.check(i);
+        _nodes[i] = build(record);
+        _nodes[i]->offset = record.offset;
+    }
+
+    /* the root is the last record */
+    return _nodes.back();
+}
+}
+
+/** Snapshot **/
+
+Snapshot::Snapshot(const std::shared_ptr<MappedFile> &file) : _file(file)
+{
+    const char *data = file->data();
+    uint64_t size = file->size();
+
+    /* too short to even have a header */
+    if (size < sizeof(Header))
+        throw Corrupted();
+
+    /* written by another version, or on a machine of another byte order */
+    const Header *header = reinterpret_cast<const Header *>(data);
+    if (memcmp(header->magic, Magic, sizeof(Magic)) || (header->version != Version) || (header->order != ByteOrder))
+        throw Corrupted();
+
+    /* no section can be larger than the file, so none of the sums below can overflow */
+    if ((header->records > size) || (header->strings > size) || (header->links > size) || (header->blob > size))
+        throw Corrupted();
+
+    /* sections must fit exactly */
+    uint64_t records = sizeof(Header);
+    uint64_t strings = records + header->records * sizeof(Record);
+    uint64_t links   = strings + header->strings * sizeof(String);
+    uint64_t blob    = links   + header->links * sizeof(uint32_t);
+
+    if ((blob + header->blob != size) || (header->records == 0) || (header->records > UINT32_MAX))
+        throw Corrupted();
+
+    /* records are checked as they're used, not here, so opening takes the same time no matter the size */
+    _hash    = header->hash;
+    _tokens  = header->tokens;
+    _nodes   = header->nodes;
+    _size    = header->records;
+    _links   = header->links;
+    _strings = header->strings;
+    _bytes   = header->blob;
+    _records = reinterpret_cast<const Record *>(data + records);
+    _string  = reinterpret_cast<const String *>(data + strings);
+    _link    = reinterpret_cast<const uint32_t *>(data + links);
+    _blob    = data + blob;
+}
+
+uint32_t Snapshot::link(const Record &record, uint32_t index) const
+{
+    if ((index >= record.size) || (uint64_t(record.link) + record.size > _links))
+        throw std::out_of_range("Link out of range");
+
+    return _link[record.link + index];
+}
+
+const Snapshot::Record *Snapshot::child(const Record &record, uint32_t index) const
+{
+    uint32_t ref = link(record, index);
+
+    /* only backward references, so there can never be a cycle */
+    if (ref > static_cast<size_t>(&record - _records))
+        throw std::out_of_range("Reference out of range");
+
+    return ref ? &_records[ref - 1] : nullptr;
+}
+
+StringView Snapshot::string(const Record &record) const
+{
+    if ((record.link >= _strings) || (uint64_t(_string[record.link].offset) + _string[record.link].size > _bytes))
+        throw std::out_of_range("String out of range");
+
+    return StringView(_blob + _string[record.link].offset, _string[record.link].size);
+}
+
+std::shared_ptr<AST::Node> Snapshot::tree(const std::shared_ptr<SymbolTable> &symbols) const
+{
+    /* names in the tree point into the symbol table, and strings into the mapping, keep both alive along with the nodes */
+    std::shared_ptr<Arena> arena = std::make_shared<Arena>();
+    arena->create<std::shared_ptr<SymbolTable>>(symbols);
+    arena->create<std::shared_ptr<MappedFile>>(_file);
+
+    try
+    {
+        Sections sections = { _records, _size, _link, _links, _string, _strings, _blob, _bytes };
+        return std::shared_ptr<AST::Node>(arena, Decoder(sections, *arena, *symbols).decode());
+    }
+    catch (const Corrupted &)
+    {
+        return nullptr;
+    }
+}
+
+/** Serializer **/
+
+uint64_t Serializer::hash(const char *data, size_t size)
+{
+    /* FNV-1a over 64-bit words, seeded with the size, then mixed with the finalizer of MurmurHash3 */
+    uint64_t result = 0xcbf29ce484222325ull ^ size;
+
+    for (; size >= sizeof(uint64_t); data += sizeof(uint64_t), size -= sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, data, sizeof(uint64_t));
+        result = (result ^ word) * 0x100000001b3ull;
+        result ^= result >> 29;
+    }
+
+    /* remaining bytes, one at a time */
+    for (; size; data++, size--)
+        result = (result ^ static_cast<uint8_t>(*data)) * 0x100000001b3ull;
+
+    result ^= result >> 33;
+    result *= 0xff51afd7ed558ccdull;
+    result ^= result >> 33;
+    result *= 0xc4ceb9fe1a85ec53ull;
+    result ^= result >> 33;
+    return result;
+}
+
+void Serializer::save(const std::string &path, const AST::Node *tree, uint64_t hash, size_t tokens, size_t nodes)
+{
+    Writer writer;
+    writer.add(tree);
+
+    /* written aside, then renamed over the target, which is atomic, sources with the same content are saved into the
+     * same snapshot, possibly by several threads at once, so every save needs a temporary file of it's own */
+    std::string temp = path + ".XXXXXX";
+    int fd = mkstemp(&temp[0]);
+
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), temp);
+
+    /* `mkstemp()` makes it private to the owner, snapshots are as readable as any other build output */
+    FILE *fp = (fchmod(fd, 0644) == 0) ? fdopen(fd, "wb") : nullptr;
+
+    if (fp == nullptr)
+    {
+        int error = errno;
+        close(fd);
+        unlink(temp.c_str());
+        throw std::system_error(error, std::generic_category(), temp);
+    }
+
+    try
+    {
+        writer.write(fp, hash, tokens, nodes);
+    }
+    catch (const std::system_error &e)
+    {
+        fclose(fp);
+        unlink(temp.c_str());
+        throw std::system_error(e.code(), temp);
+    }
+
+    if (fclose(fp) != 0)
+    {
+        int error = errno;
+        unlink(temp.c_str());
+        throw std::system_error(error, std::generic_category(), temp);
+    }
+
+    if (rename(temp.c_str(), path.c_str()) != 0)
+    {
+        int error = errno;
+        unlink(temp.c_str());
+        throw std::system_error(error, std::generic_category(), path);
+    }
+}
+
+std::shared_ptr<Snapshot> Serializer::open(const std::string &path, uint64_t hash)
+{
+    std::shared_ptr<MappedFile> file;
+
+    /* missing snapshots are simply not there yet */
+    try
+    {
+        file = std::make_shared<MappedFile>(path);
+    }
+    catch (const std::system_error &)
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        std::shared_ptr<Snapshot> snapshot(new Snapshot(file));
+
+        /* a snapshot of another source */
+        if (snapshot->hash() != hash)
+            return nullptr;
+
+        return snapshot;
+    }
+    catch (const Corrupted &)
+    {
+        return nullptr;
+    }
+}
+
+std::shared_ptr<AST::Node> Serializer::load(const std::string &path, uint64_t hash, const std::shared_ptr<SymbolTable> &symbols)
+{
+    std::shared_ptr<Snapshot> snapshot = open(path, hash);
+    return snapshot ? snapshot->tree(symbols) : nullptr;
+}
+}
+}
@@ -0,0 +1,33 @@
+#include "SymbolTable.h"
+
+namespace CommandScript
+{
+namespace Compiler
+{
+const Symbol *SymbolTable::intern(StringView name)
+{
+    /* fast path, seen before */
+    auto iter = _index.find(name);
+    if (iter != _index.end()) return iter->second;
+
+    /* keep an owned copy, the source buffer may go away before the table does */
+    _names.emplace_back(name.data(), name.size());
+    _symbols.push_back(Symbol { static_cast<uint32_t>(_symbols.size()), StringView(_names.back()) });
+
+    /* index by the owned copy */
+    _index.emplace(_symbols.back().name, &_symbols.back());
+    return &_symbols.back();
+}
+
+std::vector<const Symbol *> SymbolTable::merge(const SymbolTable &other)
+{
+    std::vector<const Symbol *> result;
+    result.reserve(other._symbols.size());
+
+    for (const Symbol &symbol : other._symbols)
+        result.push_back(intern(symbol.name));
+
+    return result;
+}
+}
+}
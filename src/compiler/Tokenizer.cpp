@@ -1,133 +1,718 @@
-#include <unordered_map>
+#include <cmath>
+#include <algorithm>
+#include <system_error>
+
+#include <errno.h>
+#include <limits.h>
+#include <locale.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "Chars.h"
 #include "Tokenizer.h"
 
 namespace CommandScript
 {
 namespace Compiler
 {
-static const std::unordered_map<std::string, Token::Keyword> Keywords = {
-    { "if"      , Token::Keyword::If        },
-    { "else"    , Token::Keyword::Else      },
-    { "for"     , Token::Keyword::For       },
-    { "while"   , Token::Keyword::While     },
-
-    { "break"   , Token::Keyword::Break     },
-    { "continue", Token::Keyword::Continue  },
-    { "return"  , Token::Keyword::Return    },
-
-    { "try"     , Token::Keyword::Try       },
-    { "except"  , Token::Keyword::Except    },
-    { "finally" , Token::Keyword::Finally   },
-    { "raise"   , Token::Keyword::Raise     },
-
-    { "as"      , Token::Keyword::As        },
-    { "def"     , Token::Keyword::Def       },
-    { "delete"  , Token::Keyword::Delete    },
-    { "import"  , Token::Keyword::Import    },
+/* keywords and word operators, classified with a perfect hash over the first and the last character,
+ * so recognizing a word costs at most one comparison, the table is verified collision-free at compile time */
+struct WordTable
+{
+    struct Word
+    {
+        const char *name = "";
+        size_t size = 0;
+        Token::Type type = Token::Type::Identifiers;
+        Token::Keyword keyword = Token::Keyword::If;
+        Token::Operator operator_ = Token::Operator::BracketLeft;
+    };
+
+public:
+    static constexpr size_t Size = 64;
+    static constexpr size_t MinSize = 2;
+    static constexpr size_t MaxSize = 8;
+
+public:
+    Word words[Size];
+    bool collided;
+
+public:
+    constexpr WordTable() : words(), collided(false)
+    {
+        /* keywords */
+        set("if"        , Token::Keyword::If        );
+        set("else"      , Token::Keyword::Else      );
+        set("for"       , Token::Keyword::For       );
+        set("while"     , Token::Keyword::While     );
+
+        set("break"     , Token::Keyword::Break     );
+        set("continue"  , Token::Keyword::Continue  );
+        set("return"    , Token::Keyword::Return    );
+
+        set("try"       , Token::Keyword::Try       );
+        set("except"    , Token::Keyword::Except    );
+        set("finally"   , Token::Keyword::Finally   );
+        set("raise"     , Token::Keyword::Raise     );
+
+        set("as"        , Token::Keyword::As        );
+        set("def"       , Token::Keyword::Def       );
+        set("delete"    , Token::Keyword::Delete    );
+        set("import"    , Token::Keyword::Import    );
+
+        /* word operators */
+        set("and"       , Token::Operator::BoolAnd  );
+        set("or"        , Token::Operator::BoolOr   );
+        set("not"       , Token::Operator::BoolNot  );
+        set("is"        , Token::Operator::Is       );
+        set("in"        , Token::Operator::In       );
+    }
+
+public:
+    static constexpr size_t hash(const char *name, size_t size)
+    {
+        return (static_cast<uint8_t>(name[0]) + 2 * static_cast<uint8_t>(name[size - 1])) % Size;
+    }
+
+private:
+    static constexpr size_t length(const char *name)
+    {
+        size_t size = 0;
+        while (name[size]) size++;
+        return size;
+    }
+
+private:
+    constexpr Word &add(const char *name, Token::Type type)
+    {
+        size_t size = length(name);
+        Word &word = words[hash(name, size)];
+
+        /* slot already taken, the hash function needs to be revised */
+        if (word.size || (size < MinSize) || (size > MaxSize))
+            collided = true;
+
+        word.name = name;
+        word.size = size;
+        word.type = type;
+        return word;
+    }
+
+private:
+    constexpr void set(const char *name, Token::Keyword keyword)   { add(name, Token::Type::Keywords).keyword = keyword; }
+    constexpr void set(const char *name, Token::Operator operator_) { add(name, Token::Type::Operators).operator_ = operator_; }
+
+public:
+    const Word *find(StringView name) const
+    {
+        /* out of range words never match */
+        if ((name.size() < MinSize) || (name.size() > MaxSize))
+            return nullptr;
+
+        /* a single probe, empty slots never match because of their zero size */
+        const Word &word = words[hash(name.data(), name.size())];
+        return ((word.size == name.size()) && !memcmp(word.name, name.data(), name.size())) ? &word : nullptr;
+    }
 };
 
-static const std::unordered_map<std::string, Token::Operator> Operators = {
-    { "("   , Token::Operator::BracketLeft          },
-    { ")"   , Token::Operator::BracketRight         },
-    { "["   , Token::Operator::IndexLeft            },
-    { "]"   , Token::Operator::IndexRight           },
-    { "{"   , Token::Operator::BlockLeft            },
-    { "}"   , Token::Operator::BlockRight           },
-
-    { ","   , Token::Operator::Comma                },
-    { "."   , Token::Operator::Point                },
-    { ":"   , Token::Operator::Colon                },
-    { ";"   , Token::Operator::Semicolon            },
-    { "\n"  , Token::Operator::NewLine              },
-
-    { "<"   , Token::Operator::Less                 },
-    { ">"   , Token::Operator::Greater              },
-    { "<="  , Token::Operator::Leq                  },
-    { ">="  , Token::Operator::Geq                  },
-    { "=="  , Token::Operator::Equ                  },
-    { "!="  , Token::Operator::Neq                  },
-
-    { "and" , Token::Operator::BoolAnd              },
-    { "or"  , Token::Operator::BoolOr               },
-    { "not" , Token::Operator::BoolNot              },
-
-    { "+"   , Token::Operator::Plus                 },
-    { "-"   , Token::Operator::Minus                },
-    { "/"   , Token::Operator::Divide               },
-    { "*"   , Token::Operator::Multiply             },
-    { "%"   , Token::Operator::Module               },
-    { "**"  , Token::Operator::Power                },
-
-    { "&"   , Token::Operator::BitAnd               },
-    { "|"   , Token::Operator::BitOr                },
-    { "~"   , Token::Operator::BitNot               },
-    { "^"   , Token::Operator::BitXor               },
-    { "<<"  , Token::Operator::ShiftLeft            },
-    { ">>"  , Token::Operator::ShiftRight           },
-
-    { "+="  , Token::Operator::InplaceAdd           },
-    { "-="  , Token::Operator::InplaceSub           },
-    { "*="  , Token::Operator::InplaceMul           },
-    { "/="  , Token::Operator::InplaceDiv           },
-    { "%="  , Token::Operator::InplaceMod           },
-    { "**=" , Token::Operator::InplacePower         },
-
-    { "&="  , Token::Operator::InplaceBitAnd        },
-    { "|="  , Token::Operator::InplaceBitOr         },
-    { "^="  , Token::Operator::InplaceBitXor        },
-    { "<<=" , Token::Operator::InplaceShiftLeft     },
-    { ">>=" , Token::Operator::InplaceShiftRight    },
-
-    { "is"  , Token::Operator::Is                   },
-    { "in"  , Token::Operator::In                   },
-/*  {  ??   , Token::Operator::IsNot                },  "is-not" operator is a semantic operator, it is emitted by `Parser` */
-/*  {  ??   , Token::Operator::NotIn                },  "not-in" operator is a semantic operator, it is emitted by `Parser` */
-    { ".."  , Token::Operator::Range                },
-    { "="   , Token::Operator::Assign               },
-    { "->"  , Token::Operator::Pointer              },
-    { "@"   , Token::Operator::Decorator            },
+static constexpr WordTable Words;
+static_assert(!Words.collided, "Keyword hash collision");
+
+/* the lexer, a class for every byte which selects the scanner a token starts with, and a DFA over those classes
+ * which recognizes operators by longest match, both generated at compile time from the operator spellings below */
+struct LexerTable
+{
+    enum Class : uint8_t
+    {
+        Invalid,
+        End,
+        Quote,
+        Digit,
+        Letter,
+        Symbol,     /* every operator character has a class of it's own, starting from here */
+    };
+
+public:
+    static constexpr size_t MaxStates = 64;
+    static constexpr size_t MaxClasses = 32;
+
+public:
+    /* zero-initialized transitions all lead to the dead state */
+    static constexpr uint8_t Dead = 0;
+    static constexpr uint8_t Start = 1;
+
+public:
+    uint8_t classes[256];
+    uint8_t next[MaxStates][MaxClasses];
+
+public:
+    bool accepts[MaxStates];
+    Token::Operator operators[MaxStates];
+
+public:
+    size_t states;
+    size_t symbols;
+    bool overflowed;
+
+public:
+    constexpr LexerTable() : classes(), next(), accepts(), operators(), states(Start + 1), symbols(Symbol), overflowed(false)
+    {
+        /* characters which start other tokens */
+        classes['\0'] = End;
+        classes['\''] = Quote;
+        classes['\"'] = Quote;
+        classes['_' ] = Letter;
+
+        for (char c = '0'; c <= '9'; c++) classes[static_cast<uint8_t>(c)] = Digit;
+        for (char c = 'a'; c <= 'z'; c++) classes[static_cast<uint8_t>(c)] = Letter;
+        for (char c = 'A'; c <= 'Z'; c++) classes[static_cast<uint8_t>(c)] = Letter;
+
+        /* operators */
+        set("("     , Token::Operator::BracketLeft          );
+        set(")"     , Token::Operator::BracketRight         );
+        set("["     , Token::Operator::IndexLeft            );
+        set("]"     , Token::Operator::IndexRight           );
+        set("{"     , Token::Operator::BlockLeft            );
+        set("}"     , Token::Operator::BlockRight           );
+
+        set(","     , Token::Operator::Comma                );
+        set("."     , Token::Operator::Point                );
+        set(":"     , Token::Operator::Colon                );
+        set(";"     , Token::Operator::Semicolon            );
+        set("\n"    , Token::Operator::NewLine              );
+
+        set("<"     , Token::Operator::Less                 );
+        set(">"     , Token::Operator::Greater              );
+        set("<="    , Token::Operator::Leq                  );
+        set(">="    , Token::Operator::Geq                  );
+        set("=="    , Token::Operator::Equ                  );
+        set("!="    , Token::Operator::Neq                  );
+
+    /*  set("and"   , Token::Operator::BoolAnd              );  word operators are classified along with keywords, see `WordTable` */
+    /*  set("or"    , Token::Operator::BoolOr               );  word operators are classified along with keywords, see `WordTable` */
+    /*  set("not"   , Token::Operator::BoolNot              );  word operators are classified along with keywords, see `WordTable` */
+
+        set("+"     , Token::Operator::Plus                 );
+        set("-"     , Token::Operator::Minus                );
+        set("/"     , Token::Operator::Divide               );
+        set("*"     , Token::Operator::Multiply             );
+        set("%"     , Token::Operator::Module               );
+        set("**"    , Token::Operator::Power                );
+
+        set("&"     , Token::Operator::BitAnd               );
+        set("|"     , Token::Operator::BitOr                );
+        set("~"     , Token::Operator::BitNot               );
+        set("^"     , Token::Operator::BitXor               );
+        set("<<"    , Token::Operator::ShiftLeft            );
+        set(">>"    , Token::Operator::ShiftRight           );
+
+        set("+="    , Token::Operator::InplaceAdd           );
+        set("-="    , Token::Operator::InplaceSub           );
+        set("*="    , Token::Operator::InplaceMul           );
+        set("/="    , Token::Operator::InplaceDiv           );
+        set("%="    , Token::Operator::InplaceMod           );
+        set("**="   , Token::Operator::InplacePower         );
+
+        set("&="    , Token::Operator::InplaceBitAnd        );
+        set("|="    , Token::Operator::InplaceBitOr         );
+        set("^="    , Token::Operator::InplaceBitXor        );
+        set("<<="   , Token::Operator::InplaceShiftLeft     );
+        set(">>="   , Token::Operator::InplaceShiftRight    );
+
+    /*  set("is"    , Token::Operator::Is                   );  word operators are classified along with keywords, see `WordTable` */
+    /*  set("in"    , Token::Operator::In                   );  word operators are classified along with keywords, see `WordTable` */
+    /*  set( ??     , Token::Operator::IsNot                );  "is-not" operator is a semantic operator, it is emitted by `Parser` */
+    /*  set( ??     , Token::Operator::NotIn                );  "not-in" operator is a semantic operator, it is emitted by `Parser` */
+        set(".."    , Token::Operator::Range                );
+        set("="     , Token::Operator::Assign               );
+        set("->"    , Token::Operator::Pointer              );
+        set("@"     , Token::Operator::Decorator            );
+    }
+
+private:
+    constexpr void set(const char *name, Token::Operator operator_)
+    {
+        size_t state = Start;
+
+        /* walk down the trie of spellings, adding classes and states as needed */
+        for (const char *p = name; *p; p++)
+        {
+            uint8_t &cls = classes[static_cast<uint8_t>(*p)];
+
+            /* a character which is part of some other token can't be part of an operator */
+            if ((cls == Invalid) && (symbols < MaxClasses))
+                cls = static_cast<uint8_t>(symbols++);
+            else if (cls < Symbol)
+                overflowed = true;
+
+            /* states are simply the prefixes of operators */
+            if ((next[state][cls] == Dead) && (states < MaxStates))
+                next[state][cls] = static_cast<uint8_t>(states++);
+            else if (next[state][cls] == Dead)
+                overflowed = true;
+
+            state = next[state][cls];
+        }
+
+        accepts[state] = true;
+        operators[state] = operator_;
+    }
+
+public:
+    Class classify(char c) const { return static_cast<Class>(classes[static_cast<uint8_t>(c)]); }
+    uint8_t move(uint8_t state, char c) const { return next[state][classes[static_cast<uint8_t>(c)]]; }
+    bool isIdent(char c) const { return (classify(c) == Letter) || (classify(c) == Digit); }
 };
 
+static constexpr LexerTable Lexer;
+static_assert(!Lexer.overflowed, "Lexer table overflowed");
+
 template <typename T> static inline bool in(T c, T a, T b)  { return c >= a && c <= b; }
 template <typename T> static inline bool isHex(T c)         { return in(c, '0', '9') || in(c, 'a', 'f') || in(c, 'A', 'F'); }
 template <typename T> static inline long toInt(T c)         { return in(c, '0', '9') ? (c - '0') : in(c, 'a', 'f') ? (c - 'a' + 10) : (c - 'A' + 10); }
 
+/* value of a digit in any base up to 36, anything else maps to a value larger than every base */
+static inline unsigned int toDigit(char c)
+{
+    unsigned int digit = static_cast<unsigned int>(c - '0');
+    unsigned int letter = static_cast<unsigned int>((c | 0x20) - 'a');
+    return (digit < 10) ? digit : (letter < 26) ? (letter + 10) : UINT_MAX;
+}
+
+/* once the value no longer fits, every following digit is only counted */
+static inline void accumulate(uint64_t &value, size_t &dropped, unsigned int base, unsigned int digit)
+{
+    uint64_t next;
+
+    if (dropped || __builtin_mul_overflow(value, base, &next) || __builtin_add_overflow(next, digit, &next))
+        dropped++;
+    else
+        value = next;
+}
+
+/* every power of ten which is exactly representable as a double */
+static const double Powers[] = {
+    1e0 , 1e1 , 1e2 , 1e3 , 1e4 , 1e5 , 1e6 , 1e7 , 1e8 , 1e9 , 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/* how far reading a token may look beyond its end, 3 chars for "1e+5", each one may be behind a line continuation */
+static const size_t MaxLookahead = 16;
+
+/* exponents are saturated to this, far beyond where doubles become infinity or zero */
+static const uint64_t MaxExponent = 100000;
+
+/* `strtod()` follows `LC_NUMERIC` of the host, which may not use '.' as the decimal point, so literals are read in a
+ * "C" locale of their own, created once and never freed */
+static locale_t numeric(void)
+{
+    static const locale_t locale = newlocale(LC_NUMERIC_MASK, "C", static_cast<locale_t>(0));
+    return locale;
+}
+
+/* offsets are 32-bit, in tokens, nodes, rows and snapshots alike, so larger sources are rejected rather than wrapped */
+static size_t limit(size_t size)
+{
+    if (size <= UINT32_MAX)
+        return size;
+    else
+        throw std::system_error(EFBIG, std::generic_category(), "sources are limited to 4 GiB");
+}
+
 /****** Tokenizer ******/
 
-Tokenizer::Tokenizer(const std::string &source) : _source(source)
+Tokenizer::Tokenizer(const std::string &source, const std::shared_ptr<SymbolTable> &symbols) :
+    _pos(0),
+    _buffer(source.data(), limit(source.size())),
+    _eof(true),
+    _base(0),
+    _chunk(0),
+    _size(source.size()),
+    _source(_buffer),
+    _lines(_source.data(), _source.size()),
+    _last(0),
+    _first(0),
+    _index(0),
+    _furthest(0),
+    _reuse(),
+    _paired(0),
+    _symbols(symbols) {}
+
+Tokenizer::Tokenizer(const std::shared_ptr<MappedFile> &file, const std::shared_ptr<SymbolTable> &symbols) :
+    _pos(0),
+    _file(file),
+    _eof(true),
+    _base(0),
+    _chunk(0),
+    _size(limit(file->size())),
+    _source(file->data(), file->size()),
+    _lines(_source.data(), _source.size()),
+    _last(0),
+    _first(0),
+    _index(0),
+    _furthest(0),
+    _reuse(),
+    _paired(0),
+    _symbols(symbols) {}
+
+Tokenizer::Tokenizer(const Reader &reader, size_t chunk, const std::shared_ptr<SymbolTable> &symbols) :
+    _pos(0),
+    _eof(false),
+    _base(0),
+    _chunk(std::max(chunk, static_cast<size_t>(1))),
+    _reader(reader),
+    _size(0),
+    _last(0),
+    _first(0),
+    _index(0),
+    _furthest(0),
+    _reuse(),
+    _paired(0),
+    _symbols(symbols) {}
+
+Tokenizer::Tokenizer(const std::shared_ptr<const Tokenizer> &previous, const std::string &source, size_t offset, size_t removed, size_t from) :
+    _pos(0),
+    _eof(true),
+    _base(0),
+    _chunk(0),
+    _size(limit(source.size())),
+    _source(source),
+    _lines(previous->_lines, source.data(), source.size(), offset, removed),
+    _last(from),
+    _first(from),
+    _index(from),
+    _furthest(from),
+    _reuse(),
+    _previous(previous),
+    _paired(from),
+    _symbols(previous->_symbols)
+{
+    size_t count = previous->count();
+    std::vector<Piece> pieces = previous->pieces();
+
+    /* tokens which are not affected by the edit at all */
+    _reuse.kept = previous->unchanged(offset);
+    _reuse.moved = count;
+    _reuse.limit = offset + removed;
+    _reuse.delta = static_cast<ptrdiff_t>(source.size()) - static_cast<ptrdiff_t>(previous->_size);
+
+    /* tokens before `from` are left where they are */
+    for (const Piece &piece : pieces)
+        if (piece.first < from)
+            _pieces.push_back(Piece { piece.tokens, piece.first, std::min(piece.count, from - piece.first), piece.delta });
+
+    /* the ones after it are copied, they belong to statements which are parsed again */
+    for (size_t i = from; i < _reuse.kept; i++)
+        _tokens.push_back(previous->stored(i));
+
+    /* then read again, until a token ends right where one of the previous tokens ended, past the edit,
+     * reading a token depends on nothing but where it starts, so all the following tokens would be the same */
+    _pos = _reuse.kept ? previous->stored(_reuse.kept - 1).offset() : 0;
+
+    for (size_t i = _reuse.kept;;)
+    {
+        Token token = read();
+
+        /* the source is not kept, literals referencing it are copied */
+        if (token.is<Token::Type::String>() && (token.asString().data() >= source.data()) && (token.asString().data() < source.data() + source.size()))
+        {
+            _strings.emplace_back(token.asString().data(), token.asString().size());
+            token = Token::createString(token.offset(), _strings.back());
+        }
+
+        /* never resynchronized, everything after the edit is read again */
+        _tokens.push_back(token);
+        if (token.is<Token::Type::Eof>())
+            break;
+
+        /* still inside the edit */
+        if (static_cast<ptrdiff_t>(token.offset()) - _reuse.delta < static_cast<ptrdiff_t>(_reuse.limit))
+            continue;
+
+        /* find the previous token which ends at the same place */
+        size_t end = token.offset() - _reuse.delta;
+        while ((i < count) && (previous->stored(i).offset() < end)) i++;
+
+        if ((i < count) && (previous->stored(i).offset() == end))
+        {
+            _reuse.moved = i + 1;
+            break;
+        }
+    }
+
+    /* tokens after the edit are left where they are as well, only moved, they're copied into `_tokens` on demand */
+    _reuse.shift = static_cast<ptrdiff_t>(_first + _tokens.size()) - static_cast<ptrdiff_t>(_reuse.moved);
+
+    for (const Piece &piece : pieces)
+    {
+        if (piece.first + piece.count <= _reuse.moved)
+            continue;
+
+        size_t skip = (piece.first < _reuse.moved) ? (_reuse.moved - piece.first) : 0;
+        _pieces.push_back(Piece { piece.tokens + skip, piece.first + skip + _reuse.shift, piece.count - skip, piece.delta + _reuse.delta });
+    }
+
+    /* the source belongs to the caller, nothing is ever read from it again */
+    _pos = _tokens.back().offset();
+    _source = StringView();
+}
+
+Tokenizer::Tokenizer(const Tokenizer &whole, size_t begin, size_t end, const std::shared_ptr<SymbolTable> &symbols) :
+    _pos(begin),
+    _eof(true),
+    _base(0),
+    _chunk(0),
+    _size(end),
+    _source(whole._source.data(), end),
+    _last(0),
+    _first(0),
+    _index(0),
+    _furthest(0),
+    _reuse(),
+    _paired(0),
+    _symbols(symbols) {}
+
+std::vector<std::pair<size_t, size_t>> Tokenizer::split(size_t count, size_t least) const
+{
+    int depth = 0;
+    size_t pos = 0;
+    size_t size = _source.size();
+    const char *data = _source.data();
+    std::vector<std::pair<size_t, size_t>> result(1, std::make_pair(0, size));
+
+    /* fewer chunks if there are not enough bytes for all of them, streams are never resident as a whole */
+    count = std::min(count, size / std::max(least, static_cast<size_t>(1)));
+
+    if (_reader || (count < 2))
+        return result;
+
+    /* chars as `nextChar()` returns them, line continuations are dropped and new-lines are folded into '\n' */
+    auto next = [&](void) -> char
+    {
+        if (pos >= size)
+            return 0;
+
+        char ch = data[pos++];
+
+        if ((ch == '\r') || (ch == '\n'))
+        {
+            if ((pos < size) && (data[pos] == ((ch == '\n') ? '\r' : '\n')))
+                pos++;
+
+            return '\n';
+        }
+
+        if ((ch != '\\') || (pos >= size) || ((data[pos] != '\r') && (data[pos] != '\n')))
+            return ch;
+
+        /* the char after a line continuation is taken as-is */
+        if ((++pos < size) && (data[pos] == '\n')) pos++;
+        return (pos < size) ? data[pos++] : 0;
+    };
+
+    /* strings, comments and brackets are tracked, so only new-lines at top-level are considered */
+    for (size_t step = size / count; char ch = next();)
+    {
+        switch (ch)
+        {
+            case '(':
+            case '[':
+            case '{':
+                depth++;
+                break;
+
+            case ')':
+            case ']':
+            case '}':
+                depth--;
+                break;
+
+            /* escaped chars never close the string, invalid ones are reported when tokenizing */
+            case '\'':
+            case '\"':
+            {
+                for (char quote = ch; (ch = next()) && (ch != quote);)
+                    if ((ch == '\\') && !next())
+                        break;
+
+                break;
+            }
+
+            /* comments run until the end of line, the new-line is still a candidate */
+            case '#':
+            {
+                while ((ch = next()) && (ch != '\n'));
+                if (!ch) break;
+            }
+
+            /* fall through */
+            case '\n':
+            {
+                /* not far enough, or inside brackets */
+                if ((depth != 0) || (pos < result.back().first + step) || (size - pos < least))
+                    break;
+
+                /* only cut right before a word, without line continuations in it */
+                size_t end = pos;
+                while ((end < size) && Lexer.isIdent(data[end])) end++;
+
+                if ((end == pos) || (Lexer.classify(data[pos]) != LexerTable::Letter) || ((end < size) && (data[end] == '\\')))
+                    break;
+
+                /* a cut before a word which continues the statement is bound to fail, operators like `and` or `not` do,
+                 * and so do `else`, `except` and `finally`, the others always begin a new statement if the cut is right */
+                const WordTable::Word *word = Words.find(StringView(data + pos, end - pos));
+
+                if ((word == nullptr) || ((word->type == Token::Type::Keywords) &&
+                                          (word->keyword != Token::Keyword::Else) &&
+                                          (word->keyword != Token::Keyword::Except) &&
+                                          (word->keyword != Token::Keyword::Finally)))
+                {
+                    result.back().second = end;
+                    result.push_back(std::make_pair(pos, size));
+                }
+
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    return result;
+}
+
+size_t Tokenizer::unchanged(size_t offset) const
+{
+    size_t lower = 0;
+    size_t upper = count();
+
+    /* reading a token may look a few chars beyond its end, so tokens ending too close to the edit are affected as well,
+     * so is `EOF`, offsets never decrease, so the first affected token is found by bisecting */
+    while (lower < upper)
+    {
+        size_t mid = lower + (upper - lower) / 2;
+        Token token = stored(mid);
+
+        if (!token.is<Token::Type::Eof>() && (token.offset() + MaxLookahead <= offset))
+            lower = mid + 1;
+        else
+            upper = mid;
+    }
+
+    return lower;
+}
+
+const Tokenizer::Piece *Tokenizer::locate(size_t index) const
+{
+    /* the last piece which begins at or before `index`, if it reaches that far */
+    auto piece = std::upper_bound(_pieces.begin(), _pieces.end(), index, [](size_t x, const Piece &y){ return x < y.first; });
+    return ((piece != _pieces.begin()) && (index - piece[-1].first < piece[-1].count)) ? &piece[-1] : nullptr;
+}
+
+Token Tokenizer::stored(size_t index) const
+{
+    /* most likely already in buffer, otherwise in one of the pieces */
+    if (index - _first < _tokens.size())
+        return _tokens[index - _first];
+
+    const Piece *piece = locate(index);
+    return piece->tokens[index - piece->first].relocate(piece->delta);
+}
+
+std::vector<Tokenizer::Piece> Tokenizer::pieces(void) const
+{
+    std::vector<Piece> result;
+    size_t end = _first + _tokens.size();
+
+    /* pieces before `_tokens`, `_tokens` itself, and then what's left of the pieces after it */
+    for (const Piece &piece : _pieces)
+        if (piece.first < _first)
+            result.push_back(piece);
+
+    if (!_tokens.empty())
+        result.push_back(Piece { _tokens.data(), _first, _tokens.size(), 0 });
+
+    for (const Piece &piece : _pieces)
+    {
+        if (piece.first + piece.count <= end)
+            continue;
+
+        size_t skip = (piece.first < end) ? (end - piece.first) : 0;
+        result.push_back(Piece { piece.tokens + skip, piece.first + skip, piece.count - skip, piece.delta });
+    }
+
+    return result;
+}
+
+bool Tokenizer::fill(size_t pos)
 {
-    /* initial state */
-    _stack.push(State {
-        .col = 0,
-        .row = 1,
-        .pos = 0,
-    });
+    /* a token may span several chunks, keep pulling until `pos` is covered */
+    while (pos >= _base + _buffer.size())
+    {
+        size_t size = _buffer.size();
+        _buffer.resize(size + _chunk);
+
+        /* the reader may fill less than asked, but never zero until the end of input */
+        size_t count = _reader(&_buffer[size], _chunk);
+        _buffer.resize(size + count);
+
+        if (count == 0)
+        {
+            _eof = true;
+            _lines.finish();
+            break;
+        }
 
-    /* fast reference */
-    _state = &(_stack.top());
+        /* streams have no size up front, they're cut off as soon as they grow past it */
+        limit(_base + _buffer.size());
+
+        /* rows and columns are indexed as the source arrives */
+        _lines.append(_buffer.data() + size, count);
+    }
+
+    /* the buffer may have been relocated */
+    _source = StringView(_buffer);
+    return pos < _base + _buffer.size();
+}
+
+void Tokenizer::compact(void)
+{
+    /* only worth it when at least a whole chunk was consumed */
+    if (!_reader || (_pos - _base < _chunk))
+        return;
+
+    /* tokens never point into the window in streaming mode, so everything before `_pos` can be dropped */
+    _buffer.erase(0, _pos - _base);
+    _source = StringView(_buffer);
+    _base = _pos;
 }
 
 char Tokenizer::peekChar(void)
 {
-    int row = _state->row;
-    int col = _state->col;
-    int pos = _state->pos;
+    /* fast path, only carriage returns and line continuations need translating */
+    if ((_pos < _base + _source.size()) &&
+        (at(_pos) != '\r') &&
+        (at(_pos) != '\\'))
+        return at(_pos);
+
+    /* slow path, read and rewind */
+    size_t pos = _pos;
     char result = nextChar();
 
-    _state->row = row;
-    _state->col = col;
-    _state->pos = pos;
+    _pos = pos;
     return result;
 }
 
 char Tokenizer::nextChar(void)
 {
     /* check for overflow */
-    if (_state->pos >= _source.size())
+    if (!within(_pos))
         return 0;
 
     /* peek next char */
-    char result = _source[_state->pos++];
+    char result = at(_pos++);
 
     switch (result)
     {
@@ -137,13 +722,10 @@ char Tokenizer::nextChar(void)
         case '\r':
         case '\n':
         {
-            _state->row++;
-            _state->col = 0;
-
             /* '\r\n' or '\n\r' */
-            if ((_state->pos < _source.size()) &&
-                (_source[_state->pos] == (result == '\n' ? '\r' : '\n')))
-                _state->pos++;
+            if (within(_pos) &&
+                (at(_pos) == (result == '\n' ? '\r' : '\n')))
+                _pos++;
 
             result = '\n';
             break;
@@ -152,24 +734,22 @@ char Tokenizer::nextChar(void)
         /* line continuation */
         case '\\':
         {
-            if ((_state->pos >= _source.size()) ||
-                (_source[_state->pos] != '\r' && _source[_state->pos] != '\n'))
+            if (!within(_pos) ||
+                (at(_pos) != '\r' && at(_pos) != '\n'))
                 break;
 
-            _state->row++;
-            _state->pos++;
-            _state->col = 0;
+            _pos++;
 
             /* '\r\n' or '\n\r' */
-            if (_state->pos < _source.size() &&
-                _source[_state->pos] == (result == '\n' ? '\r' : '\n'))
-                _state->pos++;
+            if (within(_pos) &&
+                at(_pos) == (result == '\n' ? '\r' : '\n'))
+                _pos++;
 
             /* check for overflow */
-            if (_state->pos >= _source.size())
+            if (!within(_pos))
                 return 0;
 
-            result = _source[_state->pos++];
+            result = at(_pos++);
             break;
         }
 
@@ -177,17 +757,23 @@ char Tokenizer::nextChar(void)
             break;
     }
 
-    _state->col++;
     return result;
 }
 
 void Tokenizer::skipSpaces(void)
 {
-    char ch = peekChar();
-    while (isspace(ch) && ch != '\n')
+    for (;;)
     {
+        /* skip runs of blanks in strides */
+        _pos = Chars::skipBlanks(_source.data() + (_pos - _base), _source.data() + _source.size()) - _source.data() + _base;
+
+        /* long runs may span several chunks */
+        compact();
+
+        /* a line continuation may keep the run going, let `nextChar()` handle it */
+        char ch = peekChar();
+        if (!isspace(ch) || (ch == '\n')) break;
         nextChar();
-        ch = peekChar();
     }
 }
 
@@ -198,39 +784,49 @@ void Tokenizer::skipComments(void)
         char ch;
         nextChar();
 
-        while ((ch = peekChar()) && (ch != '\n')) nextChar();
-        while ((ch = peekChar()) && (ch == '\n')) nextChar();
+        /* skip comment bodies in strides, and stop at back-slashes since the comment may be continued to next line */
+        for (;;)
+        {
+            _pos = Chars::findAny(_source.data() + (_pos - _base), _source.data() + _source.size(), '\n', '\r', '\\', '\0', '\0') - _source.data() + _base;
+
+            /* long comments may span several chunks */
+            compact();
+
+            if (!(ch = peekChar()) || (ch == '\n')) break;
+            nextChar();
+        }
 
+        while ((ch = peekChar()) && (ch == '\n')) nextChar();
         skipSpaces();
     }
 }
 
-std::shared_ptr<Token> Tokenizer::read(void)
+Token Tokenizer::read(void)
 {
+    /* streaming mode, drop consumed chunks between tokens, so the window never grows beyond the longest token */
+    compact();
+
     /* skip spaces and comments */
     skipSpaces();
     skipComments();
 
-    /* read first char */
-    switch (peekChar())
+    /* the class of first char selects the scanner */
+    switch (Lexer.classify(peekChar()))
     {
         /* '\0' means EOF */
-        case 0:
-            return Token::createEof(_state->row, _state->col);
+        case LexerTable::End:
+            return Token::createEof(_pos);
 
         /* strings can either be single or double quoted */
-        case '\'':
-        case '\"':
+        case LexerTable::Quote:
             return readString();
 
         /* number constants */
-        case '0' ... '9':
+        case LexerTable::Digit:
             return readNumber();
 
         /* identifier or keywords */
-        case '_':
-        case 'a' ... 'z':
-        case 'A' ... 'Z':
+        case LexerTable::Letter:
             return readIdentifier();
 
         /* operators */
@@ -239,23 +835,45 @@ std::shared_ptr<Token> Tokenizer::read(void)
     }
 }
 
-std::shared_ptr<Token> Tokenizer::readString(void)
+Token Tokenizer::readString(void)
 {
     char start = nextChar();
+    const char *end = _source.data() + _source.size();
+    const char *begin = _source.data() + (_pos - _base);
+
+    /* fast path, literals without escapes or carriage returns can reference the source directly,
+     * skip in strides to the next character which needs attention, escape sequences, carriage
+     * returns and NULs are left to the slow path */
+    const char *quote = Chars::findAny(begin, end, start, '\\', '\r', '\0', '\0');
+
+    /* closing quote, commit the scanned characters */
+    if ((quote < end) && (*quote == start))
+    {
+        _pos += quote - begin + 1;
+
+        /* the window moves in streaming mode, literals must be copied out */
+        if (!_reader)
+            return Token::createString(_pos, StringView(begin, quote - begin));
+
+        _strings.emplace_back(begin, quote - begin);
+        return Token::createString(_pos, _strings.back());
+    }
+
+    /* slow path, decode escape sequences char-by-char */
     char remains = nextChar();
     std::string result;
 
     while (start != remains)
     {
         if (!remains)
-            throw Exception::SyntaxError(_state->row, _state->col, "Unexpected EOF when scanning strings");
+            throw Exception::SyntaxError(_lines.row(_pos), _lines.col(_pos), "Unexpected EOF when scanning strings");
 
         if (remains == '\\')
         {
             switch ((remains = nextChar()))
             {
                 case 0:
-                    throw Exception::SyntaxError(_state->row, _state->col, "Unexpected EOF when parsing escape sequence in strings");
+                    throw Exception::SyntaxError(_lines.row(_pos), _lines.col(_pos), "Unexpected EOF when parsing escape sequence in strings");
 
                 case '\'':
                 case '\"':
@@ -277,7 +895,7 @@ std::shared_ptr<Token> Tokenizer::readString(void)
                     char lsb = nextChar();
 
                     if (!isHex(msb) || !isHex(lsb))
-                        throw Exception::SyntaxError(_state->row, _state->col, "Invalid '\\x' escape sequence");
+                        throw Exception::SyntaxError(_lines.row(_pos), _lines.col(_pos), "Invalid '\\x' escape sequence");
 
                     remains = (char)((toInt(msb) << 4) | toInt(lsb));
                     break;
@@ -301,9 +919,9 @@ std::shared_ptr<Token> Tokenizer::readString(void)
                 default:
                 {
                     if (isprint(remains))
-                        throw Exception::SyntaxError(_state->row, _state->col, Strings::format("Invalid escape character '%c'", remains));
+                        throw Exception::SyntaxError(_lines.row(_pos), _lines.col(_pos), Strings::format("Invalid escape character '%c'", remains));
                     else
-                        throw Exception::SyntaxError(_state->row, _state->col, Strings::format("Invalid escape character '\\x%.2x'", remains));
+                        throw Exception::SyntaxError(_lines.row(_pos), _lines.col(_pos), Strings::format("Invalid escape character '\\x%.2x'", remains));
                 }
             }
         }
@@ -312,21 +930,51 @@ std::shared_ptr<Token> Tokenizer::readString(void)
         remains = nextChar();
     }
 
-    return Token::createString(_state->row, _state->col, result);
+    _strings.push_back(std::move(result));
+    return Token::createString(_pos, _strings.back());
+}
+
+size_t Tokenizer::readDigits(unsigned int base, uint64_t &value, size_t &dropped)
+{
+    size_t count = 0;
+
+    for (;;)
+    {
+        unsigned int digit;
+        const char *p = _source.data() + (_pos - _base);
+        const char *end = _source.data() + _source.size();
+
+        /* digits never need translating, so scan the source directly */
+        for (; (p < end) && ((digit = toDigit(*p)) < base); p++, count++)
+            accumulate(value, dropped, base, digit);
+
+        /* line continuations and chunk boundaries may keep the run going, let `nextChar()` handle them */
+        _pos = p - _source.data() + _base;
+        if ((digit = toDigit(peekChar())) >= base) break;
+
+        nextChar();
+        count++;
+        accumulate(value, dropped, base, digit);
+    }
+
+    return count;
 }
 
-std::shared_ptr<Token> Tokenizer::readNumber(void)
+Token Tokenizer::readNumber(void)
 {
-    int base = 10;
-    char number = nextChar();
-    int64_t integer = toInt(number);
+    size_t start = _pos;
+    unsigned int base = 10;
 
-    if (number == '0')
+    if (peekChar() == '0')
     {
+        nextChar();
+
         switch (peekChar())
         {
             /* decimal number */
             case '.':
+            case 'e':
+            case 'E':
                 break;
 
             /* binary number */
@@ -356,189 +1004,142 @@ std::shared_ptr<Token> Tokenizer::readNumber(void)
 
             /* simply integer zero */
             default:
-                return Token::createValue(_state->row, _state->col, static_cast<int64_t>(0));
+                return Token::createValue(_pos, static_cast<int64_t>(0));
         }
     }
 
-    /* make charset */
-    char charset[17] = "0123456789abcdef";
-    charset[base] = 0;
+    /* integer part, digits which don't fit are dropped and scale the value instead */
+    bool isFloat = false;
+    size_t dropped = 0;
+    uint64_t mantissa = 0;
 
-    /* integer part */
-    char follow = peekChar();
-    while (follow && strchr(charset, tolower(follow)))
-    {
-        integer *= base;
-        integer += toInt(follow);
+    readDigits(base, mantissa, dropped);
+    int64_t exponent = dropped;
 
+    /* fraction part only makes sense when it's base 10, but it may also be a "." or ".." opeartor */
+    if ((base == 10) && (peekChar() == '.'))
+    {
+        size_t dot = _pos;
         nextChar();
-        follow = peekChar();
-    }
-
-    /* fraction part only makes sense when it's base 10 */
-    if (base != 10 || follow != '.')
-        return Token::createValue(_state->row, _state->col, integer);
 
-    /* skip the decimal point */
-    nextChar();
+        if (!in(peekChar(), '0', '9'))
+            _pos = dot;
+        else
+        {
+            /* digits that fit scale the value down */
+            size_t drops = dropped;
+            size_t count = readDigits(10, mantissa, dropped);
 
-    /* the fraction part, but it may also be a "." or ".." opeartor */
-    if (!in(peekChar(), '0', '9'))
-    {
-        _state->col--;
-        _state->pos--;
-        return Token::createValue(_state->row, _state->col, integer);
+            isFloat = true;
+            exponent -= count - (dropped - drops);
+        }
     }
 
-    double factor = 1.0;
-    double decimal = integer;
-
-    /* merge to final result */
-    do
+    /* exponent part, without any digits it's not an exponent at all, but an identifier */
+    if ((base == 10) && ((peekChar() == 'e') || (peekChar() == 'E')))
     {
-        factor *= 0.1;
-        decimal += toInt(nextChar()) * factor;
-    } while (in(peekChar(), '0', '9'));
-
-    /* represent as "Float" token */
-    return Token::createValue(_state->row, _state->col, decimal);
-}
+        size_t mark = _pos;
+        nextChar();
 
-std::shared_ptr<Token> Tokenizer::readOperator(void)
-{
-    switch (char op = nextChar())
-    {
-        /* single character operators */
-        case '(' : return Token::createOperator(_state->row, _state->col, Token::Operator::BracketLeft  );
-        case ')' : return Token::createOperator(_state->row, _state->col, Token::Operator::BracketRight );
-        case '[' : return Token::createOperator(_state->row, _state->col, Token::Operator::IndexLeft    );
-        case ']' : return Token::createOperator(_state->row, _state->col, Token::Operator::IndexRight   );
-        case '{' : return Token::createOperator(_state->row, _state->col, Token::Operator::BlockLeft    );
-        case '}' : return Token::createOperator(_state->row, _state->col, Token::Operator::BlockRight   );
-        case '~' : return Token::createOperator(_state->row, _state->col, Token::Operator::BitNot       );
-        case ',' : return Token::createOperator(_state->row, _state->col, Token::Operator::Comma        );
-        case ':' : return Token::createOperator(_state->row, _state->col, Token::Operator::Colon        );
-        case ';' : return Token::createOperator(_state->row, _state->col, Token::Operator::Semicolon    );
-        case '\n': return Token::createOperator(_state->row, _state->col, Token::Operator::NewLine      );
-        case '@' : return Token::createOperator(_state->row, _state->col, Token::Operator::Decorator    );
+        char sign = peekChar();
+        if ((sign == '+') || (sign == '-')) nextChar();
 
-        /* != */
-        case '!':
+        if (!in(peekChar(), '0', '9'))
+            _pos = mark;
+        else
         {
-            if (nextChar() == '=')
-                return Token::createOperator(_state->row, _state->col, Token::Operator::Neq);
-            else
-                throw Exception::SyntaxError(_state->row, _state->col, "Invalid operator '!'");
-        }
+            size_t overflow = 0;
+            uint64_t power = 0;
 
-        /* . .. */
-        case '.':
-        {
-            /* . */
-            if (peekChar() != '.')
-                return Token::createOperator(_state->row, _state->col, Token::Operator::Point);
+            /* anything this large is either infinity or zero anyway */
+            if (readDigits(10, power, overflow) && (overflow || (power > MaxExponent)))
+                power = MaxExponent;
 
-            /* .. */
-            nextChar();
-            return Token::createOperator(_state->row, _state->col, Token::Operator::Range);
+            isFloat = true;
+            exponent += (sign == '-') ? -static_cast<int64_t>(power) : static_cast<int64_t>(power);
         }
+    }
 
-        /* = == */
-        case '=':
-        {
-            /* = */
-            if (peekChar() != '=')
-                return Token::createOperator(_state->row, _state->col, Token::Operator::Assign);
+    /* integers must fit in `int64_t`, instead of silently wrapping around */
+    if (!isFloat)
+    {
+        if (dropped || (mantissa > static_cast<uint64_t>(INT64_MAX)))
+            throw Exception::SyntaxError(_lines.row(_pos), _lines.col(_pos), "Integer literal out of range");
+        else
+            return Token::createValue(_pos, static_cast<int64_t>(mantissa));
+    }
 
-            /* == */
-            nextChar();
-            return Token::createOperator(_state->row, _state->col, Token::Operator::Equ);
-        }
+    /* fast path, both the mantissa and the power of ten are exact doubles, so a single
+     * multiplication or division is correctly rounded (Clinger), which covers most literals */
+    if (!dropped && (mantissa <= (1ull << 53)) && (exponent >= -22) && (exponent <= 22))
+        return Token::createValue(_pos, exponent < 0 ? mantissa / Powers[-exponent] : mantissa * Powers[exponent]);
 
-        case '+': /* + += */
-        case '/': /* / /= */
-        case '%': /* % %= */
-        case '&': /* & &= */
-        case '|': /* | |= */
-        case '^': /* ^ ^= */
-        {
-            /* + - / % & | ^ */
-            if (peekChar() != '=')
-                return Token::createOperator(_state->row, _state->col, Operators.at(std::string(1, op)));
+    /* slow path, too many digits or a large exponent, read the literal again and let `strtod_l()` round it */
+    size_t end = _pos;
+    std::string literal;
 
-            /* += -= /= %= &= |= ^= */
-            nextChar();
-            return Token::createOperator(_state->row, _state->col, Operators.at(op + std::string("=")));
-        }
+    for (_pos = start; _pos < end;)
+        literal += nextChar();
 
-        /* - -= -> */
-        case '-':
-        {
-            switch (peekChar())
-            {
-                /* -= */
-                case '=':
-                {
-                    nextChar();
-                    return Token::createOperator(_state->row, _state->col, Token::Operator::InplaceSub);
-                }
+    /* literals are plain ASCII, with '.' as the decimal point no matter what locale the host is in */
+    double value = strtod_l(literal.c_str(), nullptr, numeric());
 
-                /* -> */
-                case '>':
-                {
-                    nextChar();
-                    return Token::createOperator(_state->row, _state->col, Token::Operator::Pointer);
-                }
+    if (std::isinf(value))
+        throw Exception::SyntaxError(_lines.row(_pos), _lines.col(_pos), "Float literal out of range");
+    else
+        return Token::createValue(_pos, value);
+}
 
-                /* - */
-                default:
-                    return Token::createOperator(_state->row, _state->col, Token::Operator::Minus);
-            }
-        }
+Token Tokenizer::readOperator(void)
+{
+    char first = peekChar();
+    uint8_t state = LexerTable::Start;
 
-        case '*': /* * ** *= **= */
-        case '>': /* > >> >= >>= */
-        case '<': /* < << <= <<= */
-        {
-            char follow = peekChar();
+    /* longest match, stop right before the first char which can't extend the operator any further */
+    for (uint8_t follow; (follow = Lexer.move(state, peekChar())) != LexerTable::Dead; state = follow)
+        nextChar();
 
-            /* *= >= <= */
-            if (follow == '=')
-            {
-                nextChar();
-                return Token::createOperator(_state->row, _state->col, Operators.at(op + std::string("=")));
-            }
-            else if (follow == op)
-            {
-                nextChar();
+    /* reached an operator */
+    if (Lexer.accepts[state])
+        return Token::createOperator(_pos, Lexer.operators[state]);
 
-                /* ** << >> */
-                if (peekChar() != '=')
-                    return Token::createOperator(_state->row, _state->col, Operators.at(std::string(2, op)));
+    /* not even an operator prefix, take the char so the error points after it */
+    if (state == LexerTable::Start)
+        nextChar();
 
-                /* **= <<= >>= */
-                nextChar();
-                return Token::createOperator(_state->row, _state->col, Operators.at(std::string(2, op) + "="));
-            }
-            else
-            {
-                /* * < > */
-                return Token::createOperator(_state->row, _state->col, Operators.at(std::string(1, op)));
-            }
-        }
+    /* other invalid operators */
+    if (isprint(first))
+        throw Exception::SyntaxError(_lines.row(_pos), _lines.col(_pos), Strings::format("Invalid operator '%c'", first));
+    else
+        throw Exception::SyntaxError(_lines.row(_pos), _lines.col(_pos), Strings::format("Invalid character '\\x%.2x'", (uint8_t)first));
+}
 
-        /* other invalid operators */
-        default:
-        {
-            if (isprint(op))
-                throw Exception::SyntaxError(_state->row, _state->col, Strings::format("Invalid operator '%c'", op));
-            else
-                throw Exception::SyntaxError(_state->row, _state->col, Strings::format("Invalid character '\\x%.2x'", (uint8_t)op));
-        }
-    }
+Token Tokenizer::readIdentifier(void)
+{
+    size_t pos = _pos - _base;
+    size_t size = _source.size();
+    const char *begin = _source.data() + pos;
+
+    /* identifier characters never need translating, so scan the source directly */
+    while (pos < size && Lexer.isIdent(_source[pos]))
+        pos++;
+
+    /* line continuation right after an identifier may glue it with the next line,
+     * let the char-by-char scanner handle it and glue the pieces together */
+    if (pos < size && _source[pos] == '\\' && pos + 1 < size && (_source[pos + 1] == '\r' || _source[pos + 1] == '\n'))
+        return readIdentifierSlow();
+
+    /* identifier may also continue in the next chunk, which is not pulled in yet */
+    if (!_eof && (pos + 1 >= size))
+        return readIdentifierSlow();
+
+    /* commit the scanned identifier */
+    StringView token(begin, pos + _base - _pos);
+    _pos = pos + _base;
+    return createIdentifier(token);
 }
 
-std::shared_ptr<Token> Tokenizer::readIdentifier(void)
+Token Tokenizer::readIdentifierSlow(void)
 {
     char first = nextChar();
     char follow = peekChar();
@@ -566,89 +1167,200 @@ std::shared_ptr<Token> Tokenizer::readIdentifier(void)
         }
     }
 
-    if (Keywords.find(token) != Keywords.end())
-        return Token::createKeyword(_state->row, _state->col, Keywords.at(token));
-    else if (Operators.find(token) != Operators.end())
-        return Token::createOperator(_state->row, _state->col, Operators.at(token));
-    else
-        return Token::createIdentifier(_state->row, _state->col, token);
+    /* the symbol table keeps it's own copy */
+    return createIdentifier(token);
 }
 
-std::shared_ptr<Token> Tokenizer::next(void)
+Token Tokenizer::createIdentifier(StringView token)
 {
-    /* read next token */
-    std::shared_ptr<Token> token = nextOrLine();
+    const WordTable::Word *word = Words.find(token);
 
-    /* skip "\n" operator */
-    while (token->is<Token::Type::Operators>() &&
-          (token->asOperator() == Token::Operator::NewLine))
-        token = nextOrLine();
+    if (word == nullptr)
+        return Token::createIdentifier(_pos, _symbols->intern(token));
+    else if (word->type == Token::Type::Keywords)
+        return Token::createKeyword(_pos, word->keyword);
+    else
+        return Token::createOperator(_pos, word->operator_);
+}
 
-    return std::move(token);
+Token Tokenizer::advance(void)
+{
+    size_t index = _first + _tokens.size();
+    const Piece *piece = locate(index);
+
+    /* carried over from a previous tokenizer, tokens after the edit are always in one of the pieces */
+    if (piece == nullptr)
+        return read();
+    else
+        return piece->tokens[index - piece->first].relocate(piece->delta);
 }
 
-std::shared_ptr<Token> Tokenizer::peek(void)
+Token Tokenizer::readUntil(size_t index)
 {
-    std::shared_ptr<Token> token;
-    std::deque<std::shared_ptr<Token>>::const_iterator it;
+    /* tokens of an edited source before `_tokens` are left where they are */
+    if (index < _first)
+        return stored(index);
 
-    /* if no tokens in cache, read directly, otherwise read from cache */
-    if (_state->cache.empty())
+    /* read on demand, tokens are only ever appended */
+    while (index >= _first + _tokens.size())
     {
-        token = read();
-        _state->cache.push_back(token);
+        /* an invalid token fails every time it's asked for */
+        if (_error)
+            throw *_error;
+
+        /* nothing can follow `EOF` */
+        if (!_tokens.empty() && _tokens.back().is<Token::Type::Eof>())
+            return _tokens.back();
+
+        _tokens.push_back(advance());
     }
+
+    return _tokens[index - _first];
+}
+
+void Tokenizer::tokenize(void)
+{
+    /* nothing can be read beyond an invalid token */
+    if (_error)
+        return;
+
+    /* roughly one token every 3 bytes, avoid repeatedly growing the buffer, tokens carried over are counted exactly */
+    if (_pieces.empty())
+        _tokens.reserve(_tokens.size() + (_base + _source.size() - _pos) / 3 + 1);
     else
+        _tokens.reserve(count() - _first);
+
+    try
+    {
+        /* read until `EOF` */
+        while (_tokens.empty() || !_tokens.back().is<Token::Type::Eof>())
+            _tokens.push_back(advance());
+    }
+    catch (const Exception::SyntaxError &e)
     {
-        /* skip first iterator */
-        it = _state->cache.cbegin() + 1;
-        token = _state->cache.front();
+        /* the parser may still find an error before it */
+        _error.reset(new Exception::SyntaxError(e));
+    }
+}
 
-        /* skip "\n" operator, in cache */
-        while (it != _state->cache.cend() &&
-               token->is<Token::Type::Operators>() &&
-              (token->asOperator() == Token::Operator::NewLine))
-            token = *it++;
+void Tokenizer::pair(void)
+{
+    Token token = readUntil(_paired);
+    _pairs.push_back(static_cast<uint32_t>(_paired));
+
+    /* bracket kinds are not checked here, the parser reports mismatches */
+    if (token.isOperator(Token::Operator::BlockLeft) ||
+        token.isOperator(Token::Operator::IndexLeft) ||
+        token.isOperator(Token::Operator::BracketLeft))
+        _opened.push_back(_paired);
+    else if (!_opened.empty() && (token.isOperator(Token::Operator::BlockRight) ||
+                                  token.isOperator(Token::Operator::IndexRight) ||
+                                  token.isOperator(Token::Operator::BracketRight)))
+    {
+        _pairs[_opened.back() - _first] = static_cast<uint32_t>(_paired);
+        _opened.pop_back();
     }
 
-    /* skip "\n" operator */
-    while (token->is<Token::Type::Operators>() &&
-          (token->asOperator() == Token::Operator::NewLine))
+    /* unclosed brackets runs until `EOF` */
+    else if (token.is<Token::Type::Eof>())
     {
-        token = read();
-        _state->cache.push_back(token);
+        for (size_t i : _opened)
+            _pairs[i - _first] = static_cast<uint32_t>(_paired);
+
+        _opened.clear();
     }
 
-    /* preserve cache */
-    return std::move(token);
+    _paired++;
 }
 
-std::shared_ptr<Token> Tokenizer::nextOrLine(void)
+size_t Tokenizer::match(size_t index)
 {
-    /* no tokens in cache, read directly */
-    if (_state->cache.empty())
-        return read();
+    /* pair tokens up to `index`, and then, if it's still open, until it's closed, or `EOF` closes it,
+     * `_opened` is sorted, since brackets are pushed in the order they appear */
+    while ((_paired <= index) || std::binary_search(_opened.begin(), _opened.end(), index))
+        pair();
+
+    /* the matching bracket is looked at as well */
+    _furthest = std::max<size_t>(_furthest, _pairs[index - _first]);
+    return _pairs[index - _first];
+}
+
+void Tokenizer::release(size_t index)
+{
+    /* the last token read is still needed to report errors */
+    index = std::min(index, _last);
+
+    /* only worth it when at least half of the buffer can go, so every token is moved at most once on average */
+    if ((index <= _first) || (2 * (index - _first) < _tokens.size()))
+        return;
+
+    /* decoded literals were appended in the same order as their tokens */
+    for (size_t i = 0; i < index - _first; i++)
+        if (_tokens[i].is<Token::Type::String>() && !_strings.empty() && (_tokens[i].asString().data() == _strings.front().data()))
+            _strings.pop_front();
+
+    /* brackets of released tokens can never be matched again, and pairing resumes from what's kept */
+    if (_paired > index)
+        _pairs.erase(_pairs.begin(), _pairs.begin() + (index - _first));
+    else
+        _pairs.clear();
 
-    /* otherwise read from cache queue */
-    std::shared_ptr<Token> token = std::move(_state->cache.front());
+    _paired = std::max(_paired, index);
+    _opened.erase(_opened.begin(), std::lower_bound(_opened.begin(), _opened.end(), index));
 
-    /* pop from cache queue */
-    _state->cache.pop_front();
-    return std::move(token);
+    /* drop the tokens, and rows before the first kept one */
+    _tokens.erase(_tokens.begin(), _tokens.begin() + (index - _first));
+    _first = index;
+    _lines.discard(_tokens.front().offset());
 }
 
-std::shared_ptr<Token> Tokenizer::peekOrLine(void)
+Token Tokenizer::next(void)
 {
-    /* tokens cached, read from cache */
-    if (!_state->cache.empty())
-        return _state->cache.front();
+    /* read next token */
+    Token token = nextOrLine();
+
+    /* skip "\n" operator */
+    while (token.is<Token::Type::Operators>() &&
+          (token.asOperator() == Token::Operator::NewLine))
+        token = nextOrLine();
+
+    return token;
+}
 
-    /* otherwise read direcly */
-    std::shared_ptr<Token> token = read();
+Token Tokenizer::peek(void)
+{
+    /* skip "\n" operator, without moving the cursor */
+    for (size_t index = _index;; index++)
+    {
+        const Token &token = fetch(index);
+
+        if (!token.is<Token::Type::Operators>() ||
+            (token.asOperator() != Token::Operator::NewLine))
+        {
+            _last = std::min(index, _first + _tokens.size() - 1);
+            return token;
+        }
+    }
+}
+
+Token Tokenizer::nextOrLine(void)
+{
+    /* read the token under cursor, and move forward */
+    Token token = fetch(_index);
+
+    /* update position, the cursor may run past `EOF`, which always reads as the `EOF` itself */
+    _last = std::min(_index++, _first + _tokens.size() - 1);
+    return token;
+}
+
+Token Tokenizer::peekOrLine(void)
+{
+    /* simply read the token under cursor */
+    Token token = fetch(_index);
 
-    /* cache the token */
-    _state->cache.push_back(token);
-    return std::move(token);
+    /* update position */
+    _last = std::min(_index, _first + _tokens.size() - 1);
+    return token;
 }
 }
 }
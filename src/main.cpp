@@ -1,57 +1,448 @@
-#include <iostream>
+#include <chrono>
+#include <set>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <system_error>
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include "Dumper.h"
 #include "Parser.h"
+#include "Serializer.h"
+#include "Strings.h"
 #include "Tokenizer.h"
+#include "Visitor.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "NonCopyable.h"
 #include "SyntaxError.h"
 
-int main()
-{
-    CommandScript::Compiler::Parser ps(std::make_shared<CommandScript::Compiler::Tokenizer>(R"source(
-
-#import file
-#import logging
-#
-#Command.setHandler((name, argv, message, request) ->
-#{
-#    req = {
-#        stRequest       -> (0, request),
-#        sUserQuestion   -> (1, message.split('#')[0]),
-#        sProposedAnswer -> (2, message.split('#')[1]),
-#    };
-#
-#    resp = {
-#        eCode    -> (0, 0),
-#        sMessage -> (1, ''),
-#    }
-#
-#    result = Command.RPC('SmartAssistant.DobbyChatServer.DobbyChatServantObj').submitChatTraining(req, resp)
-#
-#    if (result == 0)
-#        logging.debug('result is %d, %s' % (result, repr(resp)))
-#    else
-#        logging.error('result is %d, %s' % (result, repr(resp)))
-#
-#    return {
-#        code -> result,
-#        message -> resp.sMessage,
-#    }
-#})
-try
-    a = 1
-except (X.Y.Z | A.B.C -> e)
-    print(e)
-except (* -> e)
-    print('fuck', e)
-finally
-    shit()
-    )source"));
-
-//    try
-//    {
-        std::cout << ps.parse()->toString() << std::endl;
-//    } catch (const CommandScript::Exception::SyntaxError &e)
-//    {
-//        std::cerr << "row(" << e.row() << "), col(" << e.col() << "): " << e.message() << std::endl;
-//    }
-
-    return 0;
+namespace
+{
+struct Options
+{
+    bool dump = false;
+    bool lazy = false;
+    bool quiet = false;
+    bool chunked = false;
+    size_t jobs = 0;
+    size_t chunk = 0;
+    size_t depth = CommandScript::Compiler::Parser::DefaultMaxDepth;
+    std::string cache;
+    std::string format;
+    std::string suffix;
+    std::vector<std::string> paths;
+};
+
+struct Result
+{
+    std::string path;
+    std::string dump;
+    std::string error;
+    std::string warning;
+
+public:
+    bool cached = false;
+    size_t bytes = 0;
+    size_t nodes = 0;
+    size_t tokens = 0;
+    double seconds = 0.0;
+};
+
+void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-j jobs] [-s suffix] [-c cache] [-r chunk] [-f format] [-m depth] [-d] [-l] [-p] [-q] <file or directory> ...\n", name);
+    fprintf(stderr, "    -j jobs      number of worker threads, defaults to the number of cores\n");
+    fprintf(stderr, "    -s suffix    only take files ending with `suffix` when walking directories\n");
+    fprintf(stderr, "    -c cache     load trees from snapshots in `cache` if the source and -m are unchanged, save them otherwise\n");
+    fprintf(stderr, "    -r chunk     read sources with `read()`, `chunk` bytes at a time, instead of mapping them, not with -c\n");
+    fprintf(stderr, "    -f format    dump format, one of \"tree\" (the default), \"json\" or \"sexpr\", implies -d\n");
+    fprintf(stderr, "    -m depth     maximum nesting depth of statements and expressions, defaults to %zu\n", CommandScript::Compiler::Parser::DefaultMaxDepth);
+    fprintf(stderr, "    -d           dump the tree of each file\n");
+    fprintf(stderr, "    -l           defer parsing function and lambda bodies, dumps parse them on demand\n");
+    fprintf(stderr, "    -p           parse files one at a time, each of them split into chunks parsed by all workers, not with -r\n");
+    fprintf(stderr, "    -q           only report failures and totals\n");
+}
+
+/* a source pulled with plain `read()` calls, the way pipes and sockets are read, it counts the bytes as they come */
+class Stream : public NonCopyable
+{
+    int _fd;
+    size_t &_bytes;
+
+public:
+    ~Stream() { close(_fd); }
+    explicit Stream(const std::string &path, size_t &bytes) : _fd(open(path.c_str(), O_RDONLY)), _bytes(bytes)
+    {
+        if (_fd < 0)
+            throw std::system_error(errno, std::generic_category(), path);
+    }
+
+public:
+    size_t read(char *buffer, size_t size)
+    {
+        ssize_t count;
+
+        /* interrupted reads are simply retried */
+        while ((count = ::read(_fd, buffer, size)) < 0)
+            if (errno != EINTR)
+                throw std::system_error(errno, std::generic_category());
+
+        _bytes += count;
+        return static_cast<size_t>(count);
+    }
+};
+
+/* parses every deferred body of a tree on demand, bodies are visited right after they're parsed, so the ones they
+ * defer in turn are parsed as well */
+class Expand : public CommandScript::Compiler::Visitor<Expand>
+{
+    CommandScript::Compiler::Parser &_parser;
+
+public:
+    explicit Expand(CommandScript::Compiler::Parser &parser) : _parser(parser) {}
+
+public:
+    bool visitDefine(CommandScript::Compiler::AST::Define *node)
+    {
+        _parser.parseDeferred(node);
+        return true;
+    }
+};
+
+/* a numeric option into `value`, nothing but decimal digits are taken, so a typo is reported rather than taken as 0 */
+bool number(const char *text, size_t &value)
+{
+    char *end;
+    errno = 0;
+    unsigned long long result = strtoull(text, &end, 10);
+
+    if (!isdigit(static_cast<unsigned char>(*text)) || (*end != '\0') || (errno == ERANGE) || (result > SIZE_MAX))
+        return false;
+
+    value = static_cast<size_t>(result);
+    return true;
+}
+
+bool isDirectory(const std::string &path)
+{
+    struct stat st;
+    return (stat(path.c_str(), &st) == 0) && S_ISDIR(st.st_mode);
+}
+
+/* symlinks are followed, but every directory is walked only once, by it's device and inode, so links back to one of
+ * it's parents can't loop forever, and directories reachable through several paths are not taken twice */
+void collect(const std::string &path, const std::string &suffix, std::vector<std::string> &files, std::set<std::pair<dev_t, ino_t>> &visited)
+{
+    struct stat st;
+    std::vector<std::string> names;
+
+    if ((stat(path.c_str(), &st) == 0) && !visited.insert(std::make_pair(st.st_dev, st.st_ino)).second)
+        return;
+
+    /* unreadable directories are reported like unreadable files */
+    DIR *dir = opendir(path.c_str());
+
+    if (dir == nullptr)
+    {
+        files.push_back(path);
+        return;
+    }
+
+    /* hidden entries, including "." and "..", are skipped */
+    for (struct dirent *entry; (entry = readdir(dir)) != nullptr;)
+        if (entry->d_name[0] != '.')
+            names.push_back(entry->d_name);
+
+    /* keep the order stable across runs */
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    for (const std::string &name : names)
+    {
+        std::string child = path + "/" + name;
+
+        if (isDirectory(child))
+            collect(child, suffix, files, visited);
+        else if ((name.size() >= suffix.size()) && !name.compare(name.size() - suffix.size(), suffix.size(), suffix))
+            files.push_back(child);
+    }
+}
+
+void dump(std::string &buffer, const CommandScript::Compiler::AST::Node *tree, const std::string &format)
+{
+    using CommandScript::Compiler::Dumper;
+
+    if (format == "json")
+        Dumper(buffer, Dumper::Format::Json).dump(tree);
+    else if (format == "sexpr")
+        Dumper(buffer, Dumper::Format::SExpr).dump(tree);
+    else
+        Dumper(buffer, Dumper::Format::Tree).dump(tree);
+}
+
+/* `pool` is only given to parse files in chunks, in which case files are compiled one at a time */
+void compile(Result &result, const Options &options, ThreadPool *pool)
+{
+    using namespace CommandScript;
+    auto begin = std::chrono::steady_clock::now();
+
+    try
+    {
+        /* every file is a compilation of it's own, parsed straight from a file mapping, unless it's streamed */
+        uint64_t hash = 0;
+        std::string snapshot;
+        std::shared_ptr<MappedFile> file;
+        std::shared_ptr<Compiler::Snapshot> cached;
+        std::shared_ptr<Compiler::AST::Node> tree;
+        std::shared_ptr<Compiler::SymbolTable> symbols = std::make_shared<Compiler::SymbolTable>();
+
+        if (options.chunk == 0)
+        {
+            file = std::make_shared<MappedFile>(result.path);
+            result.bytes = file->size();
+        }
+
+        /* snapshots are named after the hash of the source, so renamed or copied files still hit, and after the depth
+         * budget, since a source parsed under one budget may be too deep for another */
+        if (!options.cache.empty())
+        {
+            hash = Compiler::Serializer::hash(file->data(), file->size());
+            snapshot = options.cache + Strings::format("/%016llx-%zu.ast", static_cast<unsigned long long>(hash), options.depth);
+            cached = Compiler::Serializer::open(snapshot, hash);
+
+            /* snapshots are used in place, only dumps need trees, a snapshot which doesn't decode is parsed over */
+            if ((cached != nullptr) && options.dump && ((tree = cached->tree(symbols)) == nullptr))
+                cached = nullptr;
+        }
+
+        result.cached = (cached != nullptr);
+
+        /* counted when the snapshot was saved, so cached files add up to the same totals as parsed ones */
+        if (result.cached)
+        {
+            result.nodes = cached->nodes();
+            result.tokens = cached->tokens();
+        }
+
+        if (!result.cached)
+        {
+            std::unique_ptr<Stream> stream;
+            std::shared_ptr<Compiler::Tokenizer> tk;
+
+            /* streams are pulled a chunk at a time, only the statement being parsed is kept in memory */
+            if (file != nullptr)
+                tk = std::make_shared<Compiler::Tokenizer>(file, symbols);
+            else
+            {
+                stream.reset(new Stream(result.path, result.bytes));
+                tk = std::make_shared<Compiler::Tokenizer>([&](char *buffer, size_t size){ return stream->read(buffer, size); }, options.chunk, symbols);
+            }
+
+            Compiler::Parser parser(tk, options.lazy);
+            parser.setMaxDepth(options.depth);
+
+            tree = (pool == nullptr) ? parser.parse() : parser.parse(*pool);
+
+            /* dumps show whole trees, which is what parsing deferred bodies on first use ends up with */
+            if (options.lazy && options.dump)
+                Expand(parser).walk(static_cast<Compiler::AST::Compond *>(tree.get()));
+
+            result.nodes = parser.nodes();
+            result.tokens = parser.tokens();
+
+            /* the tree is fine without a snapshot, it'll simply be parsed again next time */
+            if (!options.cache.empty())
+            {
+                try
+                {
+                    Compiler::Serializer::save(snapshot, tree.get(), hash, result.tokens, result.nodes);
+                }
+                catch (const std::system_error &e)
+                {
+                    result.warning = ": warning: snapshot not saved: " + std::string(e.what());
+                }
+            }
+        }
+
+        /* dumped into a buffer, so that reports are not interleaved */
+        if (options.dump)
+            dump(result.dump, tree.get(), options.format);
+    }
+    catch (const Exception::SyntaxError &e)
+    {
+        result.error = Strings::format(":%d:%d: %s", e.row(), e.col(), e.message());
+    }
+    catch (const std::system_error &e)
+    {
+        /* `what()` would repeat the path */
+        result.error = ": " + e.code().message();
+    }
+    catch (const std::exception &e)
+    {
+        /* such as running out of memory, which only fails this file, not the others */
+        result.error = ": " + std::string(e.what());
+    }
+
+    /* read from disk as well, which is part of the cost */
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+std::string rate(double count, double seconds, const char *unit)
+{
+    /* too fast to be measured */
+    if (seconds <= 0.0)
+        return Strings::format("- %s/s", unit);
+
+    if (count / seconds >= 1e6)
+        return Strings::format("%.2f M%s/s", count / seconds / 1e6, unit);
+    else
+        return Strings::format("%.2f K%s/s", count / seconds / 1e3, unit);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+    bool invalid = false;
+    Options options;
+
+    while ((opt = getopt(argc, argv, "j:s:c:r:f:m:dlpqh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd': options.dump = true; break;
+            case 'l': options.lazy = true; break;
+            case 'p': options.chunked = true; break;
+            case 'q': options.quiet = true; break;
+            case 'c': options.cache = optarg; break;
+            case 'r': invalid |= !number(optarg, options.chunk); break;
+            case 'f': options.format = optarg; options.dump = true; break;
+            case 's': options.suffix = optarg; break;
+            case 'j': invalid |= !number(optarg, options.jobs); break;
+            case 'm': invalid |= !number(optarg, options.depth); break;
+
+            default:
+            {
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 2;
+            }
+        }
+    }
+
+    /* bad numbers, nothing to compile, deferred bodies, which can't be saved, streams, which can't be hashed or split up
+     * front, or unknown formats */
+    if (invalid ||
+        (optind >= argc) ||
+        (options.lazy && !options.cache.empty()) ||
+        (options.chunk && !options.cache.empty()) ||
+        (options.chunk && options.chunked) ||
+        (!options.format.empty() && (options.format != "tree") && (options.format != "json") && (options.format != "sexpr")))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    /* directories are walked recursively, files given explicitly are always taken */
+    std::set<std::pair<dev_t, ino_t>> visited;
+
+    for (int i = optind; i < argc; i++)
+    {
+        if (isDirectory(argv[i]))
+            collect(argv[i], options.suffix, options.paths, visited);
+        else
+            options.paths.push_back(argv[i]);
+    }
+
+    std::vector<Result> results(options.paths.size());
+    std::vector<std::future<void>> tasks;
+    auto begin = std::chrono::steady_clock::now();
+
+    {
+        /* `0` means as many workers as cores */
+        ThreadPool pool(options.jobs ? options.jobs : std::thread::hardware_concurrency());
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            results[i].path = options.paths[i];
+
+            /* chunks wait for nothing, while files would wait for their chunks, so files can't be tasks of the same pool */
+            if (options.chunked)
+                compile(results[i], options, &pool);
+            else
+                tasks.push_back(pool.submit([&results, &options, i]{ compile(results[i], options, nullptr); }));
+        }
+
+        for (std::future<void> &task : tasks)
+            task.get();
+    }
+
+    Result total;
+    size_t failed = 0;
+    size_t cached = 0;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    /* reported in the order of the command line, no matter which finishes first */
+    for (const Result &result : results)
+    {
+        total.bytes += result.bytes;
+        total.nodes += result.nodes;
+        total.tokens += result.tokens;
+        total.seconds += result.seconds;
+        cached += result.cached;
+
+        if (!result.error.empty())
+        {
+            failed++;
+            fprintf(stderr, "%s%s\n", result.path.c_str(), result.error.c_str());
+            continue;
+        }
+
+        if (!result.warning.empty())
+            fprintf(stderr, "%s%s\n", result.path.c_str(), result.warning.c_str());
+
+        if (!options.quiet && result.cached)
+        {
+            printf("%s: %zu bytes, %zu tokens, %zu nodes loaded from snapshot in %.3f ms (%s)\n",
+                   result.path.c_str(), result.bytes, result.tokens, result.nodes, result.seconds * 1e3,
+                   rate(result.bytes, result.seconds, "B").c_str());
+        }
+        else if (!options.quiet)
+        {
+            printf("%s: %zu bytes, %zu tokens, %zu nodes in %.3f ms (%s, %s, %s)\n",
+                   result.path.c_str(), result.bytes, result.tokens, result.nodes, result.seconds * 1e3,
+                   rate(result.bytes, result.seconds, "B").c_str(),
+                   rate(result.tokens, result.seconds, "tok").c_str(),
+                   rate(result.nodes, result.seconds, "node").c_str());
+        }
+
+        if (options.dump)
+            fwrite(result.dump.data(), 1, result.dump.size(), stdout);
+    }
+
+    struct rusage rusage;
+    getrusage(RUSAGE_SELF, &rusage);
+
+    /* throughput is measured against the wall time, so it scales with the number of workers, and with cached files */
+    printf("total: %zu files (%zu failed, %zu from snapshots), %zu bytes, %zu tokens, %zu nodes in %.3f ms (%.3f ms summed over files)\n",
+           results.size(), failed, cached, total.bytes, total.tokens, total.nodes, elapsed * 1e3, total.seconds * 1e3);
+
+    printf("throughput: %s, %s, %s, peak memory %.2f MB\n",
+           rate(total.bytes, elapsed, "B").c_str(),
+           rate(total.tokens, elapsed, "tok").c_str(),
+           rate(total.nodes, elapsed, "node").c_str(),
+           rusage.ru_maxrss / 1024.0);
+
+    return failed ? 1 : 0;
 }
@@ -0,0 +1,42 @@
+#include <stdlib.h>
+#include "Arena.h"
+
+Arena::~Arena()
+{
+    /* run destructors first, objects may still refer to each other */
+    for (Cleanup *cleanup = _cleanups; cleanup; cleanup = cleanup->prev)
+        cleanup->destroy(cleanup->object);
+
+    /* then release every block in one go */
+    while (_blocks)
+    {
+        Block *prev = _blocks->prev;
+        free(_blocks);
+        _blocks = prev;
+    }
+}
+
+void *Arena::allocateSlow(size_t size, size_t align)
+{
+    /* oversized objects get a block of their own */
+    size_t header = (sizeof(Block) + align - 1) & ~(align - 1);
+    size_t capacity = (header + size > BlockSize) ? header + size : BlockSize;
+    Block *block = static_cast<Block *>(malloc(capacity));
+
+    if (!block)
+        throw std::bad_alloc();
+
+    /* chain the new block */
+    block->prev = _blocks;
+    block->size = capacity;
+
+    _blocks = block;
+    _reserved += capacity;
+
+    /* start bumping from the new block */
+    char *ptr = reinterpret_cast<char *>(block) + header;
+    _pos = ptr + size;
+    _end = reinterpret_cast<char *>(block) + capacity;
+    _used += size;
+    return ptr;
+}
@@ -0,0 +1,52 @@
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+
+#include "MappedFile.h"
+
+MappedFile::~MappedFile()
+{
+    if (_size)
+        munmap(const_cast<char *>(_data), _size);
+}
+
+MappedFile::MappedFile(const std::string &path) : _size(0), _data("")
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), path);
+
+    if (fstat(fd, &st) < 0)
+    {
+        int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), path);
+    }
+
+    /* empty files can't be mapped, simply leave it empty */
+    if (st.st_size > 0)
+    {
+        void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED)
+        {
+            int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), path);
+        }
+
+        /* scripts are scanned front to back, let the kernel read ahead aggressively */
+        madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+        _size = static_cast<size_t>(st.st_size);
+        _data = static_cast<const char *>(data);
+    }
+
+    /* the mapping stays valid after closing the descriptor */
+    close(fd);
+}
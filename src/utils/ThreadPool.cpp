@@ -0,0 +1,62 @@
+#include <memory>
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+
+    /* pending tasks are still run before the workers quit */
+    _ready.notify_all();
+
+    for (std::thread &worker : _workers)
+        worker.join();
+}
+
+ThreadPool::ThreadPool(size_t count) : _stop(false)
+{
+    /* `hardware_concurrency()` may not be able to tell */
+    for (size_t i = 0; i < std::max(count, static_cast<size_t>(1)); i++)
+        _workers.emplace_back(&ThreadPool::work, this);
+}
+
+void ThreadPool::work(void)
+{
+    for (;;)
+    {
+        std::function<void(void)> task;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _ready.wait(lock, [this]{ return _stop || !_tasks.empty(); });
+
+            /* only quit when there is nothing left */
+            if (_tasks.empty())
+                return;
+
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+std::future<void> ThreadPool::submit(const std::function<void(void)> &task)
+{
+    /* `std::function` must be copyable, so the packaged task is shared */
+    auto packaged = std::make_shared<std::packaged_task<void(void)>>(task);
+    std::future<void> result = packaged->get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.emplace_back([packaged]{ (*packaged)(); });
+    }
+
+    _ready.notify_one();
+    return result;
+}